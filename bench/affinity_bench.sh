@@ -0,0 +1,64 @@
+#!/usr/bin/env bash
+# CPU 親和性 / NUMA 配置的對照測試
+#
+# 在相同的負載下依序以下列配置啟動 server-app，並用 client-app 量測 QPS 與延遲：
+#   1. baseline   : 不綁定 (原本的行為)
+#   2. pinned     : 每條 io 執行緒綁定一個 CPU
+#   3. numa-local : 綁定 + 每條執行緒獨立 io_context (Session 配置在本地 NUMA 節點)
+#   4. reserved   : numa-local + 保留 CPU 給交握與日誌
+#
+# 在單一 socket 的機器上，可以用 taskset 模擬「只使用部分 CPU」的拓撲：
+#   SERVER_CPUS=0-3 CLIENT_CPUS=4-7 ./bench/affinity_bench.sh
+#
+# 用法: ./bench/affinity_bench.sh [build_dir] [clients] [duration_s] [message]
+
+set -euo pipefail
+
+BUILD_DIR=${1:-build}
+CLIENTS=${2:-64}
+DURATION=${3:-10}
+MESSAGE=${4:-"affinity-benchmark-payload"}
+SERVER_CPUS=${SERVER_CPUS:-}
+CLIENT_CPUS=${CLIENT_CPUS:-}
+
+SERVER_BIN="$BUILD_DIR/server-app"
+CLIENT_BIN="$BUILD_DIR/client-app"
+
+# 以 taskset 限制行程可用的 CPU (若有設定)
+with_cpus() {
+    local cpus=$1; shift
+    if [[ -n "$cpus" ]]; then taskset -c "$cpus" "$@"; else "$@"; fi
+}
+
+# 從 SERVER_CPUS (或全部 CPU) 中取出最後兩個 CPU 分別保留給交握與日誌
+allowed=$(with_cpus "$SERVER_CPUS" grep Cpus_allowed_list /proc/self/status | awk '{print $2}')
+last_cpus=$(python3 -c "
+import sys
+cpus=[]
+for part in '$allowed'.split(','):
+    a,_,b=part.partition('-'); cpus+=range(int(a),int(b or a)+1)
+print(cpus[-2] if len(cpus)>2 else '', cpus[-1] if len(cpus)>2 else '')")
+read -r HANDSHAKE_CPU LOGGER_CPU <<<"$last_cpus" || true
+
+run_case() {
+    local name=$1; shift
+    echo "=== $name: server-app $* ==="
+    with_cpus "$SERVER_CPUS" "$SERVER_BIN" "$@" > "bench_server_$name.log" 2>&1 &
+    local server_pid=$!
+    sleep 1
+    with_cpus "$CLIENT_CPUS" "$CLIENT_BIN" "$CLIENTS" "$DURATION" 0 "$MESSAGE" 2>&1 \
+        | grep -E "Average QPS|Average Latency|P99 Latency|Total failed" || true
+    kill -INT "$server_pid" 2>/dev/null || true
+    wait "$server_pid" 2>/dev/null || true
+}
+
+command -v numactl >/dev/null && numactl --hardware | head -n 3 || true
+echo "server CPUs: ${allowed}"
+
+run_case baseline
+run_case pinned --io-cpus "$allowed"
+run_case numa-local --io-cpus "$allowed" --numa-local
+if [[ -n "$HANDSHAKE_CPU" ]]; then
+    run_case reserved --numa-local --handshake-threads 1 \
+        --handshake-cpus "$HANDSHAKE_CPU" --logger-cpus "$LOGGER_CPU"
+fi
@@ -0,0 +1,62 @@
+#!/usr/bin/env bash
+# epoll 與 io_uring 後端的對照測試：吞吐量與每則訊息的系統呼叫數
+#
+# 先建立兩個建置目錄：
+#   cmake -S . -B build-epoll    -DCMAKE_BUILD_TYPE=Release
+#   cmake -S . -B build-io_uring -DCMAKE_BUILD_TYPE=Release -DENABLE_IO_URING=ON
+#   cmake --build build-epoll && cmake --build build-io_uring
+#
+# 用法: ./bench/backend_bench.sh [clients] [duration_s] [message] [build_dir ...]
+# 系統呼叫數優先使用 perf (raw_syscalls:sys_enter)，沒有 perf 時改用 strace -c (會明顯拖慢伺服器)
+
+set -euo pipefail
+
+CLIENTS=${1:-64}
+DURATION=${2:-10}
+MESSAGE=${3:-"backend-benchmark-payload"}
+shift $(( $# < 3 ? $# : 3 ))
+if [[ $# -gt 0 ]]; then BUILD_DIRS=("$@"); else BUILD_DIRS=(build-epoll build-io_uring); fi
+
+count_syscalls() {
+    local pid=$1 out=$2
+    if command -v perf >/dev/null; then
+        perf stat -e raw_syscalls:sys_enter -p "$pid" -x, -o "$out" &
+    elif command -v strace >/dev/null; then
+        strace -f -c -p "$pid" -o "$out" &
+    else
+        echo "perf/strace not found, syscall counts skipped" >&2
+        return
+    fi
+    echo $!
+}
+
+for dir in "${BUILD_DIRS[@]}"; do
+    echo "=== $dir ==="
+    "$dir/server-app" > "bench_server_$(basename "$dir").log" 2>&1 &
+    server_pid=$!
+    sleep 1
+
+    stats_file=$(mktemp)
+    tracer_pid=$(count_syscalls "$server_pid" "$stats_file")
+    client_out=$("$dir/client-app" "$CLIENTS" "$DURATION" 0 "$MESSAGE" 2>&1)
+    if [[ -n "$tracer_pid" ]]; then
+        kill -INT "$tracer_pid" 2>/dev/null || true
+        wait "$tracer_pid" 2>/dev/null || true
+    fi
+    kill -INT "$server_pid" 2>/dev/null || true
+    wait "$server_pid" 2>/dev/null || true
+
+    grep -m1 "I/O backend" "bench_server_$(basename "$dir").log" || true
+    echo "$client_out" | grep -E "Average QPS|Average Latency|P99 Latency"
+    requests=$(echo "$client_out" | sed -n 's/.*Total successful requests: \([0-9]*\).*/\1/p')
+    if command -v perf >/dev/null; then
+        syscalls=$(awk -F, '/raw_syscalls/ {print $1}' "$stats_file")
+    else
+        syscalls=$(awk '/total/ {print $4}' "$stats_file")
+    fi
+    if [[ -n "$requests" && "$requests" -gt 0 && -n "$syscalls" ]]; then
+        # 每個請求包含一次讀取與一次回覆
+        echo "Server syscalls: $syscalls ($(awk "BEGIN {printf \"%.2f\", $syscalls / $requests}") per message)"
+    fi
+    rm -f "$stats_file"
+done
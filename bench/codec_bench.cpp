@@ -0,0 +1,122 @@
+// 訊息編解碼基準測試：schema 產生的編解碼 (frame/Messages.hpp) 與原本手寫的解析比較
+// 用法: codec-bench [iterations]
+//
+// 每個項目都輸出每次操作的時間與配置次數 (以取代全域 operator new 計數)。
+// 編碼寫入同一塊預先配置的緩衝區；解碼輪流使用一組預先建立、內容各不相同的訊框
+// (避免編譯器把迴圈中不變的解碼提到迴圈外)，只比較編解碼本身的成本。
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "frame/FrameBuilder.hpp"
+#include "frame/Messages.hpp"
+
+static std::atomic<uint64_t> allocations{0};
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// 避免編譯器把沒有副作用的迴圈最佳化掉
+static volatile uint64_t sink = 0;
+
+template <typename Fn>
+static void run(const char* name, std::size_t iterations, Fn&& fn) {
+    const uint64_t allocations_before = allocations.load(std::memory_order_relaxed);
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t checksum = 0;
+    for (std::size_t i = 0; i < iterations; ++i) {
+        checksum += fn(i);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    sink = sink + checksum;
+    std::printf("%-38s %8.1f ns/op %6.2f allocs/op\n", name, ns / iterations,
+                static_cast<double>(allocations.load(std::memory_order_relaxed) - allocations_before) / iterations);
+}
+
+int main(int argc, char* argv[]) {
+    const std::size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5000000;
+    const std::string subject = "user-1234567";
+    const std::string topic = "market.quotes.eu";
+    std::vector<char> out(256);
+
+    // --- 編碼 CMD_REPLAY_RESPONSE ---
+    run("encode ReplayResponse (ad hoc)", iterations, [&](std::size_t i) {
+        std::string payload(1 + sizeof(uint64_t), '\0');
+        payload[0] = static_cast<char>(REPLAY_COMPLETE);
+        for (int b = 0; b < 8; ++b) {
+            payload[1 + b] = static_cast<char>((i >> (56 - 8 * b)) & 0xFF);
+        }
+        const auto frame = FrameBuilder::build(CMD_REPLAY_RESPONSE, payload);
+        return static_cast<uint64_t>(frame[sizeof(FrameHeader) + 8]);
+    });
+    run("encode ReplayResponse (codec, vector)", iterations, [&](std::size_t i) {
+        const auto frame = FrameBuilder::build(ReplayResponse{REPLAY_COMPLETE, i});
+        return static_cast<uint64_t>(frame[sizeof(FrameHeader) + 8]);
+    });
+    run("encode ReplayResponse (codec)", iterations, [&](std::size_t i) {
+        const std::size_t size = FrameBuilder::write(ReplayResponse{REPLAY_COMPLETE, i}, out.data(), out.size());
+        return static_cast<uint64_t>(out[size - 1]);
+    });
+
+    // --- 編碼 CMD_AUTH_RESPONSE ---
+    run("encode AuthResponse (ad hoc)", iterations, [&](std::size_t) {
+        std::string payload(1, '\0');
+        payload += subject;
+        const auto frame = FrameBuilder::build(CMD_AUTH_RESPONSE, payload);
+        return static_cast<uint64_t>(frame.size());
+    });
+    run("encode AuthResponse (codec)", iterations, [&](std::size_t) {
+        return static_cast<uint64_t>(FrameBuilder::write(AuthResponse{0, subject}, out.data(), out.size()));
+    });
+
+    // --- 解碼 CMD_REPLAY_REQUEST ---
+    constexpr std::size_t frame_count = 1024;
+    std::vector<std::vector<char>> replay_frames;
+    std::vector<std::vector<char>> interest_frames;
+    for (std::size_t i = 0; i < frame_count; ++i) {
+        replay_frames.push_back(FrameBuilder::build(ReplayRequest{0x1122334455667788ULL + i}));
+        interest_frames.push_back(FrameBuilder::build(PeerInterest{i % 2 == 0, topic + std::to_string(i)}));
+    }
+    auto payload_of = [](const std::vector<char>& frame) {
+        return std::string_view(frame.data() + sizeof(FrameHeader), frame.size() - sizeof(FrameHeader));
+    };
+
+    run("decode ReplayRequest (ad hoc)", iterations, [&](std::size_t i) {
+        const std::string_view replay_payload = payload_of(replay_frames[i % frame_count]);
+        if (replay_payload.size() != sizeof(uint64_t)) std::abort();
+        uint64_t offset = 0;
+        for (char byte : replay_payload) {
+            offset = (offset << 8) | static_cast<uint8_t>(byte);
+        }
+        return offset;
+    });
+    run("decode ReplayRequest (codec)", iterations, [&](std::size_t i) {
+        ReplayRequest request;
+        if (!codec::decode(payload_of(replay_frames[i % frame_count]), request)) std::abort();
+        return request.offset;
+    });
+
+    // --- 解碼 CMD_PEER_INTEREST (原本複製出 std::vector / std::string) ---
+    run("decode PeerInterest (ad hoc)", iterations, [&](std::size_t i) {
+        const auto& interest_frame = interest_frames[i % frame_count];
+        const std::vector<char> payload(interest_frame.begin() + sizeof(FrameHeader), interest_frame.end());
+        if (payload.empty()) std::abort();
+        const std::string name(payload.begin() + 1, payload.end());
+        return static_cast<uint64_t>(payload[0]) + name.size();
+    });
+    run("decode PeerInterest (codec)", iterations, [&](std::size_t i) {
+        PeerInterest interest;
+        if (!codec::decode(payload_of(interest_frames[i % frame_count]), interest)) std::abort();
+        return static_cast<uint64_t>(interest.interested) + interest.topic.size();
+    });
+    return 0;
+}
@@ -0,0 +1,57 @@
+#!/usr/bin/env bash
+# 多節點聯邦的吞吐量測試
+#
+# 依序啟動 1..MAX_NODES 個節點 (本機不同的 loopback 埠，互相設定 --peer 形成全連接)，
+# 每個節點各接一組發布者與訂閱者 (client-app)，所有訊息都屬於同一個主題，
+# 因此每則訊息都會送給本地訂閱者並轉送到其他每個節點。
+# 輸出每個節點的發布 QPS 與訂閱者收到的訊息數，以及伺服器端的轉送統計。
+#
+# 用法: ./bench/federation_bench.sh [build_dir] [max_nodes] [clients_per_node] [subscribers_per_node] [duration_s]
+
+set -euo pipefail
+
+BUILD_DIR=${1:-build}
+MAX_NODES=${2:-3}
+CLIENTS=${3:-16}
+SUBSCRIBERS=${4:-2}
+DURATION=${5:-10}
+BASE_PORT=${BASE_PORT:-12345}
+
+SERVER_BIN="$BUILD_DIR/server-app"
+CLIENT_BIN="$BUILD_DIR/client-app"
+
+for nodes in $(seq 1 "$MAX_NODES"); do
+    echo "=== $nodes node(s) ==="
+    server_pids=()
+    for i in $(seq 0 $((nodes - 1))); do
+        port=$((BASE_PORT + i))
+        peer_args=()
+        for j in $(seq 0 $((nodes - 1))); do
+            [[ $j -ne $i ]] && peer_args+=(--peer "127.0.0.1:$((BASE_PORT + j))")
+        done
+        "$SERVER_BIN" --port "$port" "${peer_args[@]}" > "bench_federation_${nodes}_$port.log" 2>&1 &
+        server_pids+=($!)
+    done
+    sleep 2 # 等待節點之間的連線建立
+
+    client_pids=()
+    for i in $(seq 0 $((nodes - 1))); do
+        port=$((BASE_PORT + i))
+        "$CLIENT_BIN" "$CLIENTS" "$DURATION" 0 "federation-benchmark-payload" --port "$port" --subscribers "$SUBSCRIBERS" \
+            > "bench_federation_${nodes}_client_$port.log" 2>&1 &
+        client_pids+=($!)
+    done
+    wait "${client_pids[@]}" || true
+
+    for pid in "${server_pids[@]}"; do kill -INT "$pid" 2>/dev/null || true; done
+    for pid in "${server_pids[@]}"; do wait "$pid" 2>/dev/null || true; done
+
+    for i in $(seq 0 $((nodes - 1))); do
+        port=$((BASE_PORT + i))
+        qps=$(grep -oE "Average QPS: [0-9.]+" "bench_federation_${nodes}_client_$port.log" | awk '{print $3}')
+        deliveries=$(grep -oE "Subscriber deliveries: [0-9]+ \([0-9.]+ msg/s" "bench_federation_${nodes}_client_$port.log" \
+            | awk '{print $4}' | tr -d '(')
+        echo "node $port: publish ${qps:-0} req/s, subscribers receive ${deliveries:-0} msg/s"
+        grep -hoE "federation: [^;]+" "bench_federation_${nodes}_$port.log" | tail -n 1 | sed "s/^/    /" || true
+    done
+done
@@ -0,0 +1,62 @@
+#!/usr/bin/env bash
+# 閒置連線的記憶體成本
+#
+# 啟動伺服器，依序建立 N 條完成 TLS 交握後不再送出資料的連線 (client-app --idle-connections)，
+# 在連線全部建立後讀取伺服器的 VmRSS (/proc/<pid>/status)，
+# 與建立連線前的 RSS 相減，輸出每條閒置連線佔用的位元組數 (包含核心以外、行程內的所有配置)。
+#
+# 用法: ./bench/idle_memory_bench.sh [build_dir] [connection_counts...]
+#   例如 ./bench/idle_memory_bench.sh build 1000 5000 10000
+# 需要足夠的檔案描述元上限 (ulimit -n)；伺服器若啟用認證，以 TOKEN 環境變數提供 token
+
+set -euo pipefail
+
+BUILD_DIR=${1:-build}
+shift || true
+COUNTS=("${@:-1000 5000}")
+PORT=${PORT:-12345}
+SERVER_ARGS=${SERVER_ARGS:-}
+
+SERVER_BIN="$BUILD_DIR/server-app"
+CLIENT_BIN="$BUILD_DIR/client-app"
+
+ulimit -n 1048576 2>/dev/null || ulimit -n "$(ulimit -Hn)"
+
+rss_kb() {
+    awk '/^VmRSS:/ { print $2 }' "/proc/$1/status"
+}
+
+token_args=()
+[[ -n "${TOKEN:-}" ]] && token_args=(--token "$TOKEN")
+
+printf "%-12s %-14s %-14s %s\n" "connections" "rss_before_kb" "rss_after_kb" "bytes_per_connection"
+for count in ${COUNTS[*]}; do
+    # shellcheck disable=SC2086
+    "$SERVER_BIN" --port "$PORT" $SERVER_ARGS > "bench_idle_server_$count.log" 2>&1 &
+    server_pid=$!
+    sleep 1
+    before=$(rss_kb "$server_pid")
+
+    # 連線全部建立後會印出 "Idle connections open"，之後保持 DURATION 秒
+    "$CLIENT_BIN" 0 "${DURATION:-5}" 0 idle --port "$PORT" --idle-connections "$count" "${token_args[@]}" \
+        > "bench_idle_client_$count.log" 2>&1 &
+    client_pid=$!
+    until grep -q "Idle connections open" "bench_idle_client_$count.log" 2>/dev/null; do
+        kill -0 "$client_pid" 2>/dev/null || break
+        sleep 0.2
+    done
+    sleep 1 # 讓伺服器處理完最後的交握
+    opened=$(grep -o "Idle connections open: [0-9]*" "bench_idle_client_$count.log" | awk '{ print $4 }')
+    after=$(rss_kb "$server_pid")
+
+    wait "$client_pid" || true
+    kill -INT "$server_pid" 2>/dev/null || true
+    wait "$server_pid" 2>/dev/null || true
+
+    opened=${opened:-0}
+    if [[ "$opened" -gt 0 ]]; then
+        printf "%-12s %-14s %-14s %s\n" "$opened" "$before" "$after" $(( (after - before) * 1024 / opened ))
+    else
+        echo "$count: no connections opened (see bench_idle_client_$count.log)"
+    fi
+done
@@ -0,0 +1,56 @@
+#!/usr/bin/env bash
+# kTLS 與 user-space TLS 的對照測試：回覆方向的吞吐量與伺服器每 GB 的 CPU 時間
+#
+# 依序以預設設定與 --ktls 啟動伺服器，客戶端送出大訊息的 echo 請求 (預設 16000 位元組，加上訊框標頭仍在一個 TLS record 之內)，
+# 由伺服器回覆的位元組數計算 MB/s，並讀取伺服器行程的 utime + stime (/proc/<pid>/stat)
+# 換算成每 GB 回覆的 CPU 秒數。kTLS 只取代寫入方向的加密，讀取仍由 OpenSSL 解密，
+# 因此兩者的差異主要來自回覆路徑 (加密與複製到 OpenSSL 的 record 緩衝區)。
+#
+# 用法: ./bench/ktls_bench.sh [build_dir] [clients] [duration_s] [message_bytes]
+# 核心需要載入 tls 模組 (modprobe tls)；沒有時伺服器日誌會顯示連線改用 user-space TLS
+
+set -euo pipefail
+
+BUILD_DIR=${1:-build}
+CLIENTS=${2:-8}
+DURATION=${3:-10}
+MESSAGE_BYTES=${4:-16000}
+PORT=${PORT:-12345}
+SERVER_ARGS=${SERVER_ARGS:-}
+
+SERVER_BIN="$BUILD_DIR/server-app"
+CLIENT_BIN="$BUILD_DIR/client-app"
+MESSAGE=$(head -c "$MESSAGE_BYTES" /dev/zero | tr '\0' 'x')
+TICKS=$(getconf CLK_TCK)
+
+# 行程累計的 user + system CPU 時間 (clock ticks)
+cpu_ticks() {
+    awk '{ print $14 + $15 }' "/proc/$1/stat"
+}
+
+printf "%-6s %-12s %-10s %-12s %s\n" "mode" "requests" "MB/s" "cpu_s" "cpu_s_per_GB"
+for mode in tls ktls; do
+    extra=()
+    [[ "$mode" == ktls ]] && extra=(--ktls)
+    # shellcheck disable=SC2086
+    "$SERVER_BIN" --port "$PORT" "${extra[@]}" $SERVER_ARGS > "bench_ktls_server_$mode.log" 2>&1 &
+    server_pid=$!
+    sleep 1
+    before=$(cpu_ticks "$server_pid")
+
+    client_out=$("$CLIENT_BIN" "$CLIENTS" "$DURATION" 0 "$MESSAGE" --port "$PORT" 2>&1)
+    after=$(cpu_ticks "$server_pid")
+    kill -INT "$server_pid" 2>/dev/null || true
+    wait "$server_pid" 2>/dev/null || true
+
+    requests=$(echo "$client_out" | sed -n 's/.*Total successful requests: \([0-9]*\).*/\1/p' | head -n1)
+    requests=${requests:-0}
+    awk -v mode="$mode" -v requests="$requests" -v bytes="$MESSAGE_BYTES" -v duration="$DURATION" \
+        -v ticks=$(( after - before )) -v hz="$TICKS" 'BEGIN {
+            gb = requests * bytes / 1e9
+            cpu = ticks / hz
+            printf "%-6s %-12d %-10.1f %-12.2f %s\n", mode, requests, requests * bytes / 1e6 / duration, cpu,
+                   (gb > 0 ? sprintf("%.2f", cpu / gb) : "-")
+        }'
+    grep -ho -e "Kernel TLS unavailable.*" -e "ktls: [^;]*" "bench_ktls_server_$mode.log" | sed "s/^/    /" || true
+done
@@ -0,0 +1,70 @@
+// 訊息日誌吞吐量基準測試
+// 用法: message-log-bench [message_count] [payload_bytes] [directory]
+//
+// 1. append：由單一執行緒呼叫 append()，量測交給附加執行緒並全部寫入映射頁面所需的時間
+// 2. replay：以 64 KB 區塊從 offset 0 讀到結尾，並走訪每個位元組 (模擬寫出時的記憶體存取)
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include "storage/MessageLog.hpp"
+#include "frame/FrameBuilder.hpp"
+
+int main(int argc, char* argv[]) {
+    const std::size_t message_count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    const std::size_t payload_bytes = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100;
+    const std::filesystem::path directory =
+        argc > 3 ? std::filesystem::path(argv[3]) : std::filesystem::temp_directory_path() / "message_log_bench";
+
+    std::filesystem::remove_all(directory);
+    auto logger = spdlog::stdout_color_mt("bench");
+
+    MessageLog::Options options;
+    options.directory = directory.string();
+    options.max_pending_bytes = 256 * 1024 * 1024;
+
+    // 與伺服器相同：所有附加共用同一份已編碼的訊框
+    const auto frame = std::make_shared<const std::vector<char>>(
+        FrameBuilder::build(CMD_PUBLISH_MESSAGE, std::string(payload_bytes, 'x')));
+    const double total_mb = static_cast<double>(frame->size() * message_count) / (1024.0 * 1024.0);
+
+    {
+        MessageLog log(options, logger);
+
+        const auto append_start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < message_count; ++i) {
+            log.append(frame);
+        }
+        log.sync();
+        const double append_s =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - append_start).count();
+
+        const auto replay_start = std::chrono::steady_clock::now();
+        uint64_t offset = 0;
+        std::size_t replayed = 0;
+        uint64_t checksum = 0;
+        while (true) {
+            auto chunk = log.read(offset, 65536);
+            if (chunk.size == 0) break;
+            for (std::size_t i = 0; i < chunk.size; i += 64) checksum += static_cast<unsigned char>(chunk.data[i]);
+            replayed += chunk.message_count;
+            offset = chunk.next_offset;
+        }
+        const double replay_s =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - replay_start).count();
+
+        std::printf("frame size      : %zu bytes\n", frame->size());
+        std::printf("append          : %zu msgs (%zu dropped) in %.3f s -> %.0f msgs/s, %.1f MB/s\n",
+                    static_cast<std::size_t>(log.appended_count()), static_cast<std::size_t>(log.dropped_count()),
+                    append_s, message_count / append_s, total_mb / append_s);
+        std::printf("replay          : %zu msgs in %.3f s -> %.0f msgs/s, %.1f MB/s (checksum %llu)\n",
+                    replayed, replay_s, replayed / replay_s, total_mb / replay_s,
+                    static_cast<unsigned long long>(checksum));
+    }
+
+    std::filesystem::remove_all(directory);
+    return 0;
+}
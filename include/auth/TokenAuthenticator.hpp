@@ -0,0 +1,206 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <atomic>
+#include <openssl/hmac.h>
+#include <openssl/evp.h>
+#include <openssl/crypto.h>
+#include "auth/TokenCache.hpp"
+
+// 驗證結果 (同時作為 CMD_AUTH_RESPONSE 的狀態碼)
+enum class AuthStatus : uint8_t {
+    OK = 0,
+    MALFORMED = 1,         // token 格式錯誤
+    UNKNOWN_KEY = 2,       // 簽章使用的金鑰不在本地的金鑰組中
+    BAD_SIGNATURE = 3,     // 簽章不符
+    EXPIRED = 4,           // token 已過期
+    UNAUTHENTICATED = 5,   // 尚未認證就送出其他指令
+    FORBIDDEN = 6,         // 已認證，但身分不允許這個操作 (例如一般客戶端宣告自己是聯邦節點)
+};
+
+inline const char* auth_status_name(AuthStatus status) {
+    switch (status) {
+        case AuthStatus::OK: return "ok";
+        case AuthStatus::MALFORMED: return "malformed";
+        case AuthStatus::UNKNOWN_KEY: return "unknown key";
+        case AuthStatus::BAD_SIGNATURE: return "bad signature";
+        case AuthStatus::EXPIRED: return "expired";
+        case AuthStatus::UNAUTHENTICATED: return "unauthenticated";
+        case AuthStatus::FORBIDDEN: return "forbidden";
+    }
+    return "unknown";
+}
+
+// 以 HMAC-SHA256 簽章的 token：
+//
+//     <key_id>:<subject>:<expires_at>:<hex(HMAC-SHA256(secret, "<key_id>:<subject>:<expires_at>"))>
+//
+// 金鑰組 (keyset) 可以有多把金鑰，簽發時使用第一把，驗證時接受任何一把 (用於輪替金鑰)。
+// 驗證成功的 token 會放入 TokenCache，之後同一個 token 只需要查表。
+class TokenAuthenticator {
+public:
+    struct Key {
+        std::string id;
+        std::string secret;
+    };
+
+    struct Result {
+        AuthStatus status = AuthStatus::MALFORMED;
+        std::string subject;
+        bool cache_hit = false;
+    };
+
+    explicit TokenAuthenticator(std::vector<Key> keys, std::size_t cache_capacity = 65536)
+        : keys_(std::move(keys)),
+          cache_(cache_capacity) {
+        if (keys_.empty()) {
+            throw std::invalid_argument("Token keyset is empty");
+        }
+    }
+
+    // 從檔案載入金鑰組：每行「key_id secret」，空行與 # 開頭的行會被忽略
+    static std::vector<Key> load_keys(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) {
+            throw std::runtime_error("Cannot open key file " + path);
+        }
+        std::vector<Key> keys;
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream fields(line);
+            Key key;
+            if (!(fields >> key.id) || key.id[0] == '#') continue;
+            if (!(fields >> key.secret) || key.id.find(':') != std::string::npos) {
+                throw std::runtime_error("Invalid key line in " + path + ": " + line);
+            }
+            keys.push_back(std::move(key));
+        }
+        return keys;
+    }
+
+    // 以第一把金鑰簽發 token
+    std::string issue(const std::string& subject, std::chrono::seconds ttl) const {
+        if (subject.find(':') != std::string::npos) {
+            throw std::invalid_argument("Token subject must not contain ':'");
+        }
+        const Key& key = keys_.front();
+        const std::string body = key.id + ":" + subject + ":" + std::to_string(unix_now() + ttl.count());
+        return body + ":" + to_hex(sign(key.secret, body));
+    }
+
+    // 驗證 token (任何執行緒皆可呼叫)
+    Result authenticate(const std::string& token) {
+        const int64_t now = unix_now();
+        Result result;
+        if (auto cached = cache_.find(token, now)) {
+            result.status = AuthStatus::OK;
+            result.subject = std::move(cached->subject);
+            result.cache_hit = true;
+            return result;
+        }
+
+        // token 的四個欄位以 ':' 分隔，簽章在最後
+        std::string_view view(token);
+        const auto first = view.find(':');
+        const auto second = first == std::string_view::npos ? first : view.find(':', first + 1);
+        const auto last = view.rfind(':');
+        if (second == std::string_view::npos || last <= second) return result;
+
+        const std::string_view key_id = view.substr(0, first);
+        const std::string_view body = view.substr(0, last);
+        const std::string_view signature_hex = view.substr(last + 1);
+        int64_t expires_at = 0;
+        try {
+            std::size_t parsed = 0;
+            const std::string expiry(view.substr(second + 1, last - second - 1));
+            expires_at = std::stoll(expiry, &parsed);
+            if (parsed != expiry.size()) return result;
+        } catch (const std::exception&) {
+            return result;
+        }
+
+        const Key* key = find_key(key_id);
+        if (!key) {
+            result.status = AuthStatus::UNKNOWN_KEY;
+            return result;
+        }
+        const auto expected = sign(key->secret, body);
+        std::vector<unsigned char> actual;
+        if (!from_hex(signature_hex, actual) || actual.size() != expected.size() ||
+            CRYPTO_memcmp(actual.data(), expected.data(), expected.size()) != 0) {
+            result.status = AuthStatus::BAD_SIGNATURE;
+            return result;
+        }
+        if (expires_at <= now) {
+            result.status = AuthStatus::EXPIRED;
+            return result;
+        }
+
+        result.status = AuthStatus::OK;
+        result.subject = std::string(view.substr(first + 1, second - first - 1));
+        cache_.insert(token, {result.subject, expires_at});
+        return result;
+    }
+
+    TokenCache& cache() { return cache_; }
+
+private:
+    const Key* find_key(std::string_view id) const {
+        for (const auto& key : keys_) {
+            if (key.id == id) return &key;
+        }
+        return nullptr;
+    }
+
+    static std::vector<unsigned char> sign(const std::string& secret, std::string_view body) {
+        std::vector<unsigned char> digest(EVP_MAX_MD_SIZE);
+        unsigned int length = 0;
+        HMAC(EVP_sha256(), secret.data(), static_cast<int>(secret.size()),
+             reinterpret_cast<const unsigned char*>(body.data()), body.size(), digest.data(), &length);
+        digest.resize(length);
+        return digest;
+    }
+
+    static std::string to_hex(const std::vector<unsigned char>& bytes) {
+        static const char digits[] = "0123456789abcdef";
+        std::string out;
+        out.reserve(bytes.size() * 2);
+        for (unsigned char byte : bytes) {
+            out += digits[byte >> 4];
+            out += digits[byte & 0x0F];
+        }
+        return out;
+    }
+
+    static bool from_hex(std::string_view hex, std::vector<unsigned char>& out) {
+        if (hex.size() % 2 != 0) return false;
+        auto value = [](char c) -> int {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        };
+        out.resize(hex.size() / 2);
+        for (std::size_t i = 0; i < out.size(); ++i) {
+            const int high = value(hex[2 * i]);
+            const int low = value(hex[2 * i + 1]);
+            if (high < 0 || low < 0) return false;
+            out[i] = static_cast<unsigned char>((high << 4) | low);
+        }
+        return true;
+    }
+
+    static int64_t unix_now() {
+        return std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    std::vector<Key> keys_;
+    TokenCache cache_;
+};
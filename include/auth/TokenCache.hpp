@@ -0,0 +1,97 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <optional>
+#include <functional>
+#include <unordered_map>
+
+// 已驗證過的 token 快取 (分片的 LRU)
+//
+// 大量客戶端同時重新連線時，同一批 token 會被反覆驗證；命中快取就不必重算 HMAC。
+// 快取分成多個分片，每個分片各自持有一把鎖與一條 LRU 串列，不同執行緒查詢不同的 token 時幾乎不會互相等待。
+class TokenCache {
+public:
+    struct Entry {
+        std::string subject;   // token 代表的身分
+        int64_t expires_at;    // 到期時間 (Unix 秒)
+    };
+
+    // capacity：整個快取最多保存的 token 數，平均分配到各分片
+    explicit TokenCache(std::size_t capacity = 65536, std::size_t shard_count = 16)
+        : shards_(shard_count == 0 ? 1 : shard_count) {
+        const std::size_t per_shard = (capacity + shards_.size() - 1) / shards_.size();
+        for (auto& shard : shards_) {
+            shard.capacity = per_shard == 0 ? 1 : per_shard;
+        }
+    }
+
+    // 查詢 token；命中時移到 LRU 的最前面。已過期的項目會被移除並視為未命中
+    std::optional<Entry> find(const std::string& token, int64_t now) {
+        Shard& shard = shard_for(token);
+        std::lock_guard lock(shard.mutex);
+        auto it = shard.index.find(token);
+        if (it == shard.index.end()) return std::nullopt;
+        if (it->second->second.expires_at <= now) {
+            shard.lru.erase(it->second);
+            shard.index.erase(it);
+            return std::nullopt;
+        }
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return it->second->second;
+    }
+
+    // 加入剛驗證成功的 token；分片已滿時淘汰最久未使用的項目
+    void insert(const std::string& token, Entry entry) {
+        Shard& shard = shard_for(token);
+        std::lock_guard lock(shard.mutex);
+        auto it = shard.index.find(token);
+        if (it != shard.index.end()) {
+            it->second->second = std::move(entry);
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            return;
+        }
+        if (shard.lru.size() >= shard.capacity) {
+            shard.index.erase(shard.lru.back().first);
+            shard.lru.pop_back();
+        }
+        shard.lru.emplace_front(token, std::move(entry));
+        shard.index.emplace(token, shard.lru.begin());
+    }
+
+    void clear() {
+        for (auto& shard : shards_) {
+            std::lock_guard lock(shard.mutex);
+            shard.index.clear();
+            shard.lru.clear();
+        }
+    }
+
+    std::size_t size() const {
+        std::size_t total = 0;
+        for (const auto& shard : shards_) {
+            std::lock_guard lock(shard.mutex);
+            total += shard.lru.size();
+        }
+        return total;
+    }
+
+private:
+    // 每個分片對齊到快取行，避免不同分片的鎖互相干擾 (false sharing)
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::list<std::pair<std::string, Entry>> lru; // 最前面是最近使用的
+        std::unordered_map<std::string, std::list<std::pair<std::string, Entry>>::iterator> index;
+        std::size_t capacity = 0;
+    };
+
+    Shard& shard_for(const std::string& token) {
+        return shards_[std::hash<std::string>{}(token) % shards_.size()];
+    }
+
+    std::vector<Shard> shards_;
+};
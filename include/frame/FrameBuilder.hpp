@@ -2,39 +2,133 @@
 #include <vector>
 #include <string>
 #include <cstring> // for std::memcpy
+#include <string_view>
+#include <limits>
+#include <cassert>
 #include "frame/FrameHeader.hpp"
+#include "frame/MessageCodec.hpp"
 
 class FrameBuilder {
 public:
     // 靜態方法，用於建構一個完整的封包 (Header + Payload)
     // 回傳一個包含所有位元組的 vector
-    static std::vector<char> build(CommandID cmd, const std::string& payload) {
-        // 1. 計算總長度
-        const uint32_t total_length = sizeof(FrameHeader) + payload.size();
-
-        // 2. 準備 Header
-        FrameHeader header;
-        encode_header(header, total_length, cmd);
-
-        // 3. 準備儲存完整封包的 vector
-        std::vector<char> packet(total_length);
-
-        // 4. 將 Header 和 Payload 複製到 vector 中
-        std::memcpy(packet.data(), &header, sizeof(FrameHeader));
+    static std::vector<char> build(CommandID cmd, std::string_view payload) {
+        // 準備儲存完整封包的 vector，Header 寫在最前面，後面接著 Payload
+        std::vector<char> packet(sizeof(FrameHeader) + payload.size());
+        write_header(packet.data(), cmd, payload.size());
         std::memcpy(packet.data() + sizeof(FrameHeader), payload.data(), payload.size());
-        
         return packet;
     }
 
     // 可以為沒有 payload 的訊息提供一個重載版本，例如心跳包
     static std::vector<char> build(CommandID cmd) {
-        const uint32_t total_length = sizeof(FrameHeader);
-        FrameHeader header;
-        encode_header(header, total_length, cmd);
+        std::vector<char> packet(sizeof(FrameHeader));
+        write_header(packet.data(), cmd, 0);
+        return packet;
+    }
 
-        std::vector<char> packet(total_length);
-        std::memcpy(packet.data(), &header, sizeof(FrameHeader));
-        
+    // 由 schema 編碼承載資料 (見 frame/Messages.hpp)：訊框只配置一次，承載資料直接寫在標頭後面
+    // 欄位無法編碼 (例如帶長度的字串超過 65535 位元組) 時回傳空的 vector，呼叫端必須檢查
+    template <class Message>
+    static std::vector<char> build(const Message& message) {
+        const std::size_t payload_size = codec::encoded_size(message);
+        std::vector<char> packet(sizeof(FrameHeader) + payload_size);
+        if (!codec::encode(message, packet.data() + sizeof(FrameHeader), payload_size)) {
+            assert(!"FrameBuilder::build: message cannot be encoded");
+            return {};
+        }
+        write_header(packet.data(), codec::command_of<Message>(), payload_size);
         return packet;
     }
-};
\ No newline at end of file
+
+    // 將整個訊框寫入呼叫端提供的記憶體 (不配置記憶體)；回傳訊框大小，空間不足時回傳 0
+    template <class Message>
+    static std::size_t write(const Message& message, char* out, std::size_t capacity) {
+        const std::size_t payload_size = codec::encoded_size(message);
+        if (capacity < sizeof(FrameHeader) + payload_size ||
+            !codec::encode(message, out + sizeof(FrameHeader), payload_size)) {
+            return 0;
+        }
+        write_header(out, codec::command_of<Message>(), payload_size);
+        return sizeof(FrameHeader) + payload_size;
+    }
+
+    // 將標頭寫入呼叫端提供的記憶體 (通常是承載資料前面預留的 sizeof(FrameHeader) 位元組)，
+    // 承載資料已經在正確的位置上，不需要再複製一次
+    static void write_header(char* out, CommandID cmd, std::size_t payload_size) {
+        FrameHeader encoded;
+        encode_header(encoded, static_cast<uint32_t>(sizeof(FrameHeader) + payload_size), cmd);
+        std::memcpy(out, &encoded, sizeof(FrameHeader));
+    }
+};
+
+// 建立 CMD_BATCH 訊框：將多個小訊息打包成一個訊框，只需要一個 FrameHeader、一次解析與一個回覆
+class BatchBuilder {
+public:
+    // max_frame_bytes：整個批次訊框的大小上限 (不可超過 FrameParser 的上限)
+    explicit BatchBuilder(std::size_t max_frame_bytes = 65536)
+        : max_frame_bytes_(max_frame_bytes) {
+        clear();
+    }
+
+    // 加入一個子訊息；超過批次大小上限或子訊息過長時回傳 false (此時應先送出目前的批次)
+    bool add(CommandID cmd, std::string_view payload) {
+        if (payload.size() > std::numeric_limits<uint16_t>::max() ||
+            packet_.size() + sizeof(BatchEntryHeader) + payload.size() > max_frame_bytes_) {
+            return false;
+        }
+        const std::size_t offset = packet_.size();
+        packet_.resize(offset + sizeof(BatchEntryHeader));
+        write_entry_header(packet_.data() + offset, cmd, payload.size());
+        packet_.insert(packet_.end(), payload.begin(), payload.end());
+        ++count_;
+        return true;
+    }
+
+    // 加入一個由 schema 編碼的子訊息，直接編碼在批次的緩衝區中
+    template <class Message>
+    bool add(const Message& message) {
+        const std::size_t payload_size = codec::encoded_size(message);
+        if (payload_size > std::numeric_limits<uint16_t>::max() ||
+            packet_.size() + sizeof(BatchEntryHeader) + payload_size > max_frame_bytes_) {
+            return false;
+        }
+        const std::size_t offset = packet_.size();
+        packet_.resize(offset + sizeof(BatchEntryHeader) + payload_size);
+        if (!codec::encode(message, packet_.data() + offset + sizeof(BatchEntryHeader), payload_size)) {
+            packet_.resize(offset);
+            return false;
+        }
+        write_entry_header(packet_.data() + offset, codec::command_of<Message>(), payload_size);
+        ++count_;
+        return true;
+    }
+
+    std::size_t count() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+    // 填入訊框標頭並取出完整的封包，之後可以繼續建立下一個批次
+    std::vector<char> build() {
+        FrameBuilder::write_header(packet_.data(), CMD_BATCH, packet_.size() - sizeof(FrameHeader));
+        std::vector<char> packet = std::move(packet_);
+        clear();
+        return packet;
+    }
+
+    void clear() {
+        packet_.assign(sizeof(FrameHeader), 0); // 預留訊框標頭
+        count_ = 0;
+    }
+
+private:
+    static void write_entry_header(char* out, CommandID cmd, std::size_t payload_size) {
+        BatchEntryHeader entry;
+        entry.command_id = asio::detail::socket_ops::host_to_network_short(static_cast<uint16_t>(cmd));
+        entry.length = asio::detail::socket_ops::host_to_network_short(static_cast<uint16_t>(payload_size));
+        std::memcpy(out, &entry, sizeof(BatchEntryHeader));
+    }
+
+    std::vector<char> packet_;
+    std::size_t count_ = 0;
+    std::size_t max_frame_bytes_;
+};
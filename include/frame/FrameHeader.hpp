@@ -11,7 +11,7 @@
  * 
  * <------------------------------------ 總長度 (total_length) ------------------------------------>
  * +-----------------+-------------------+--------------+---------------+-------------------------+
- * | 總長度 (4 bytes) | 指令 ID (2 bytes) | 旗標 (1 byte) | 保留 (1 byte) |    承載資料 (N bytes)    |
+ * | 總長度 (4 bytes) | 指令 ID (2 bytes) | 旗標 (1 byte) | 請求 ID (1 byte) |  承載資料 (N bytes)    |
  * +-----------------+-------------------+--------------+---------------+--------------------------+
  * |<---------------------- Header (固定 8 bytes) ---------------------->| <- Payload (可變長度) -> |
  * 
@@ -30,8 +30,10 @@
  * 旗標位，保留用於功能擴展。例如，第 0 個位元可以表示 Payload 是否經過壓縮，
  * 第 1 個位元可以表示是否需要加密等。
  * 
- * * @param reserved     (1 byte, uint8_t):
- * 保留欄位，用於未來擴展。同時也確保頭部大小為 8 位元組，有助於記憶體對齊。
+ * * @param request_id   (1 byte, uint8_t):
+ * 請求 ID (原本的保留欄位)。0 表示沒有指定；非 0 時伺服器的回覆帶回相同的 ID，
+ * 客戶端可以同時送出多個請求 (pipelining)，並以 ID 對應先後不一的回覆
+ * (交給工作執行緒的指令會比其他指令晚回覆)。同時也確保頭部大小為 8 位元組，有助於記憶體對齊。
  */
 
 
@@ -42,7 +44,7 @@ struct FrameHeader {
     uint32_t total_length;
     uint16_t command_id;
     uint8_t flags;
-    uint8_t reserved;
+    uint8_t request_id;
 };
 #pragma pack(pop)
 
@@ -52,6 +54,19 @@ enum CommandID : uint16_t {
     CMD_AUTH_RESPONSE = 1002,
     CMD_PUBLISH_MESSAGE = 2001,
     CMD_SUBSCRIBE_TOPIC = 3001,
+    CMD_REPLAY_REQUEST = 4001,   // Payload: 起始 offset (uint64_t, 網路位元組序)
+    CMD_REPLAY_RESPONSE = 4002,  // Payload: 狀態 (uint8_t) + 下一個 offset (uint64_t, 網路位元組序)
+    // 節點之間的聯邦連線 (由發起連線的節點送出 HELLO，之後雙方使用以下指令)
+    CMD_PEER_HELLO = 5001,       // Payload: 發起連線的節點名稱
+    CMD_PEER_INTEREST = 5002,    // Payload: 1 (開始需要) 或 0 (不再需要) (uint8_t) + 主題名稱
+    CMD_PEER_FORWARD = 5003,     // Payload: 多個完整的 CMD_PUBLISH_MESSAGE 訊框，依序串接
+    // 批次封裝：Payload 為多個子訊息，每個子訊息為
+    //   指令 ID (uint16_t) + 長度 (uint16_t) + 承載資料，皆為網路位元組序
+    CMD_BATCH = 6001,
+    CMD_BATCH_ACK = 6002,        // Payload: 批次中已處理的子訊息數 (uint32_t, 網路位元組序)
+    // 耗用 CPU 的指令 (設定了工作執行緒時不在 io 執行緒上處理，回覆可能晚於之後的請求)
+    CMD_DIGEST_REQUEST = 7001,   // Payload: 迭代次數 (uint32_t, 網路位元組序) + 資料
+    CMD_DIGEST_RESPONSE = 7002,  // Payload: 狀態 (uint8_t) + SHA-256 摘要
     CMD_HEARTBEAT = 9001,
 };
 
@@ -60,7 +75,12 @@ inline void encode_header(FrameHeader& header, uint32_t total_length, CommandID
     header.total_length = asio::detail::socket_ops::host_to_network_long(total_length);
     header.command_id = asio::detail::socket_ops::host_to_network_short(static_cast<uint16_t>(cmd));
     header.flags = 0;
-    header.reserved = 0;
+    header.request_id = 0;
+}
+
+// 在已編碼的訊框上設定請求 ID (不需要重新編碼標頭)
+inline void set_request_id(char* frame, uint8_t request_id) {
+    reinterpret_cast<FrameHeader*>(frame)->request_id = request_id;
 }
 
 // 輔助函式，用於將網路位元組序轉換為主機位元組序
@@ -68,3 +88,11 @@ inline void decode_header(FrameHeader& header) {
     header.total_length = asio::detail::socket_ops::network_to_host_long(header.total_length);
     header.command_id = asio::detail::socket_ops::network_to_host_short(header.command_id);
 }
+
+// 批次 (CMD_BATCH) 中每個子訊息的標頭
+#pragma pack(push, 1)
+struct BatchEntryHeader {
+    uint16_t command_id;
+    uint16_t length; // 子訊息承載資料的長度 (不含此標頭)
+};
+#pragma pack(pop)
@@ -2,12 +2,41 @@
 #include <vector>
 #include <cstdint>
 #include <optional>
+#include <cstring>
+#include <algorithm>
+#include <string_view>
 #include "frame/FrameHeader.hpp"
+#include "frame/MessageCodec.hpp"
 
 // 定義一個 Frame 結構來代表一個完整的訊息
 struct Frame {
     FrameHeader header;
     std::vector<char> payload;
+
+    // 指令 ID 符合 Message 的 schema 時解碼承載資料 (見 frame/Messages.hpp)
+    template <class Message>
+    bool decode(Message& out) const {
+        return codec::decode(header.command_id, std::string_view(payload.data(), payload.size()), out);
+    }
+};
+
+// 零複製解析取出的訊框：指向原始位元組 (包含標頭，仍為網路位元組序)
+// 只在下一次呼叫 FrameParser::next() 之前有效
+struct FrameView {
+    FrameHeader header{};          // 已解碼的標頭
+    const char* bytes = nullptr;   // 整個訊框 (標頭 + 承載資料)
+    std::size_t size = 0;
+    bool buffered = false;         // true：跨越讀取邊界，位於解析器內部緩衝區；false：位於呼叫端傳入的資料中
+
+    std::string_view payload() const {
+        return std::string_view(bytes + sizeof(FrameHeader), size - sizeof(FrameHeader));
+    }
+
+    // 指令 ID 符合 Message 的 schema 時解碼承載資料；字串欄位直接指向訊框
+    template <class Message>
+    bool decode(Message& out) const {
+        return codec::decode(header.command_id, payload(), out);
+    }
 };
 
 // 定義解析結果的狀態碼
@@ -20,6 +49,15 @@ enum class ParseResult {
 
 class FrameParser {
 public:
+    // 設定一個合理的封包最大長度，防止惡意客戶端傳送超大長度導致伺服器記憶體耗盡
+    // (送出訊框的一方也必須遵守：超過的訊框會被對方視為惡意封包而斷線)
+    static constexpr std::size_t max_frame_length = 65536; // 64KB
+
+    // 標頭中的總長度是否合法 (至少包含標頭本身，且不超過上限)
+    static bool valid_length(uint32_t total_length) {
+        return total_length >= sizeof(FrameHeader) && total_length <= max_frame_length;
+    }
+
     // 將收到的原始資料推進內部緩衝區
     void push_data(const char* data, std::size_t length) {
         buffer_.insert(buffer_.end(), data, data + length);
@@ -71,8 +109,152 @@ public:
         return ParseResult::SUCCESS;
     }
 
+    // 零複製解析：從 data 依序取出完整的訊框，data / length 會前進到未處理的位置
+    // 完整落在 data 中的訊框直接指向 data，不做任何複製；只有跨越讀取邊界的訊框才累積到內部緩衝區。
+    // 資料用完時把不完整的尾端保存起來並回傳 NEED_MORE_DATA。(與 push_data / try_parse 擇一使用)
+    ParseResult next(const char*& data, std::size_t& length, FrameView& out) {
+        consume_pending();
+
+        // 1. 上一次讀取留下的資料 (不完整的訊框，或 defer() 保存的訊框)：先從這裡取出
+        if (buffered() > 0) {
+            if (buffered() < sizeof(FrameHeader)) {
+                append(data, length, sizeof(FrameHeader) - buffered());
+                if (buffered() < sizeof(FrameHeader)) return ParseResult::NEED_MORE_DATA;
+            }
+            FrameHeader header = peek_header(buffer_.data() + start_);
+            if (!valid_length(header.total_length)) {
+                buffer_.clear();
+                start_ = 0;
+                return ParseResult::INVALID_HEADER;
+            }
+            if (buffered() < header.total_length) {
+                append(data, length, header.total_length - buffered());
+                if (buffered() < header.total_length) return ParseResult::NEED_MORE_DATA;
+            }
+
+            out = FrameView{header, buffer_.data() + start_, header.total_length, true};
+            pending_size_ = header.total_length; // 呼叫端處理完後，下一次呼叫時才移除
+            return ParseResult::SUCCESS;
+        }
+
+        // 2. 完整的訊框直接從 data 取出
+        if (length >= sizeof(FrameHeader)) {
+            FrameHeader header = peek_header(data);
+            if (!valid_length(header.total_length)) {
+                return ParseResult::INVALID_HEADER;
+            }
+            if (length >= header.total_length) {
+                out = FrameView{header, data, header.total_length, false};
+                data += header.total_length;
+                length -= header.total_length;
+                return ParseResult::SUCCESS;
+            }
+            buffer_.reserve(header.total_length);
+        }
+
+        // 3. 不完整的尾端留到下一次讀取
+        buffer_.insert(buffer_.end(), data, data + length);
+        data += length;
+        length = 0;
+        return ParseResult::NEED_MORE_DATA;
+    }
+
+    // 暫停分派時把 data 中尚未解析的資料移入內部緩衝區，之後的 next() 會先從這裡繼續
+    // (與不完整的尾端相同)。之前取出的 FrameView 從此失效
+    void defer(const char*& data, std::size_t& length) {
+        consume_pending();
+        buffer_.insert(buffer_.end(), data, data + length);
+        data += length;
+        length = 0;
+    }
+
+    // 緩衝區內沒有未完成的訊框時歸還儲存空間 (連線閒置時呼叫)
+    void release_if_empty() {
+        consume_pending();
+        if (buffer_.empty() && buffer_.capacity() != 0) {
+            std::vector<char>().swap(buffer_);
+        }
+    }
+
 private:
+    static FrameHeader peek_header(const char* data) {
+        FrameHeader header;
+        std::memcpy(&header, data, sizeof(FrameHeader));
+        decode_header(header);
+        return header;
+    }
+
+    // next() 使用的內部緩衝區中，從 start_ 開始尚未交給呼叫端的位元組數
+    std::size_t buffered() const { return buffer_.size() - start_; }
+
+    // 移除已交給呼叫端的訊框；緩衝區用完時從頭開始使用
+    void consume_pending() {
+        if (pending_size_ == 0) return;
+        start_ += pending_size_;
+        pending_size_ = 0;
+        if (start_ == buffer_.size()) {
+            buffer_.clear();
+            start_ = 0;
+        }
+    }
+
+    // 從 data 移入最多 wanted 位元組到內部緩衝區
+    void append(const char*& data, std::size_t& length, std::size_t wanted) {
+        const std::size_t take = std::min(length, wanted);
+        buffer_.insert(buffer_.end(), data, data + take);
+        data += take;
+        length -= take;
+    }
+
     std::vector<char> buffer_;
-    // 設定一個合理的封包最大長度，防止惡意客戶端傳送超大長度導致伺服器記憶體耗盡
-    static constexpr std::size_t max_frame_length = 65536; // 64KB
-};
\ No newline at end of file
+    std::size_t start_ = 0;        // next()：buffer_ 中尚未交給呼叫端的資料從這裡開始
+    std::size_t pending_size_ = 0; // next()：buffer_ 中已交給呼叫端的完整訊框大小 (下一次呼叫時移除)
+};
+
+// 批次中的一個子訊息；payload 直接指向批次訊框的記憶體，不會複製
+struct BatchEntry {
+    uint16_t command_id = 0;
+    std::string_view payload;
+};
+
+// 依序走訪 CMD_BATCH 承載資料中的子訊息 (一次掃過，不配置記憶體)
+//
+//     BatchReader reader(frame.payload.data(), frame.payload.size());
+//     BatchEntry entry;
+//     while (reader.next(entry)) { ... }
+//     if (reader.malformed()) { ... }
+class BatchReader {
+public:
+    BatchReader(const char* data, std::size_t size)
+        : data_(data), size_(size) {}
+
+    // 取出下一個子訊息；已經讀完或格式錯誤時回傳 false
+    bool next(BatchEntry& out) {
+        if (offset_ == size_ || malformed_) return false;
+        if (size_ - offset_ < sizeof(BatchEntryHeader)) {
+            malformed_ = true;
+            return false;
+        }
+        BatchEntryHeader header;
+        std::memcpy(&header, data_ + offset_, sizeof(BatchEntryHeader));
+        const std::size_t length = asio::detail::socket_ops::network_to_host_short(header.length);
+        offset_ += sizeof(BatchEntryHeader);
+        if (size_ - offset_ < length) {
+            malformed_ = true;
+            return false;
+        }
+        out.command_id = asio::detail::socket_ops::network_to_host_short(header.command_id);
+        out.payload = std::string_view(data_ + offset_, length);
+        offset_ += length;
+        return true;
+    }
+
+    // 子訊息的長度超出批次範圍 (截斷或惡意的批次)
+    bool malformed() const { return malformed_; }
+
+private:
+    const char* data_;
+    std::size_t size_;
+    std::size_t offset_ = 0;
+    bool malformed_ = false;
+};
@@ -0,0 +1,266 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <limits>
+#include "frame/FrameHeader.hpp"
+
+/**
+ * @brief 編譯期產生的訊息編解碼 (schema 層)
+ *
+ * 每種訊息是一個普通的 struct，並特化 codec::MessageSchema 描述它的指令 ID 與欄位：
+ *
+ *     struct ReplayResponse { uint8_t status; uint64_t next_offset; };
+ *     template <> struct codec::MessageSchema<ReplayResponse> {
+ *         static constexpr CommandID command = CMD_REPLAY_RESPONSE;
+ *         static constexpr auto fields = std::make_tuple(codec::field(&ReplayResponse::status),
+ *                                                        codec::field(&ReplayResponse::next_offset));
+ *     };
+ *
+ * 編碼與解碼由欄位描述在編譯期展開，直接讀寫訊框的記憶體：不配置記憶體、沒有虛擬函式，
+ * 且每一次讀寫都檢查邊界。字串欄位解碼成指向訊框的 std::string_view (只在訊框有效期間可用)。
+ *
+ * 欄位種類與線上格式 (整數皆為網路位元組序，與 FrameHeader 一致)：
+ *
+ *     field(&T::m)  無號整數 / bool / 以無號整數為底的列舉，依型別大小編碼
+ *     text(&T::m)   std::string_view，前面加上長度 (uint16_t)
+ *     tail(&T::m)   std::string_view，佔用承載資料剩下的所有位元組 (只能是最後一個欄位)
+ *
+ * 沒有 tail 欄位的訊息解碼時要求承載資料剛好用完，多出的位元組視為格式錯誤。
+ */
+namespace codec {
+
+// 由每種訊息特化：command (CommandID) 與 fields (欄位描述的 tuple)
+template <class Message>
+struct MessageSchema;
+
+template <class Owner, class Member>
+struct Field {
+    Member Owner::*member;
+};
+
+template <class Owner>
+struct Text {
+    std::string_view Owner::*member;
+};
+
+template <class Owner>
+struct Tail {
+    std::string_view Owner::*member;
+};
+
+template <class Owner, class Member>
+constexpr Field<Owner, Member> field(Member Owner::*member) {
+    static_assert(std::is_same_v<Member, bool> || std::is_enum_v<Member> || std::is_unsigned_v<Member>,
+                  "codec::field supports unsigned integers, bool and enums (use text/tail for strings)");
+    return {member};
+}
+
+template <class Owner>
+constexpr Text<Owner> text(std::string_view Owner::*member) { return {member}; }
+
+template <class Owner>
+constexpr Tail<Owner> tail(std::string_view Owner::*member) { return {member}; }
+
+// 寫入呼叫端提供的記憶體；空間不足時停止寫入並記錄失敗
+class Writer {
+public:
+    Writer(char* out, std::size_t capacity) : out_(out), capacity_(capacity) {}
+
+    template <std::size_t Bytes>
+    void put_uint(uint64_t value) {
+        if (!reserve(Bytes)) return;
+        for (std::size_t i = 0; i < Bytes; ++i) {
+            out_[pos_ + i] = static_cast<char>((value >> (8 * (Bytes - 1 - i))) & 0xFF);
+        }
+        pos_ += Bytes;
+    }
+
+    void put_bytes(std::string_view bytes) {
+        if (!reserve(bytes.size())) return;
+        std::memcpy(out_ + pos_, bytes.data(), bytes.size());
+        pos_ += bytes.size();
+    }
+
+    // 欄位的值無法編碼 (例如字串超過長度欄位的上限)
+    void fail() { ok_ = false; }
+
+    bool ok() const { return ok_; }
+    std::size_t written() const { return pos_; }
+
+private:
+    bool reserve(std::size_t bytes) {
+        if (!ok_ || capacity_ - pos_ < bytes) {
+            ok_ = false;
+            return false;
+        }
+        return true;
+    }
+
+    char* out_;
+    std::size_t capacity_;
+    std::size_t pos_ = 0;
+    bool ok_ = true;
+};
+
+// 依序讀取承載資料；超出範圍時停止讀取並記錄失敗
+class Reader {
+public:
+    explicit Reader(std::string_view data) : data_(data) {}
+
+    template <std::size_t Bytes>
+    uint64_t get_uint() {
+        if (!ok_ || remaining() < Bytes) {
+            ok_ = false;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (std::size_t i = 0; i < Bytes; ++i) {
+            value = (value << 8) | static_cast<uint8_t>(data_[pos_ + i]);
+        }
+        pos_ += Bytes;
+        return value;
+    }
+
+    std::string_view get_bytes(std::size_t length) {
+        if (!ok_ || remaining() < length) {
+            ok_ = false;
+            return {};
+        }
+        const std::string_view bytes = data_.substr(pos_, length);
+        pos_ += length;
+        return bytes;
+    }
+
+    std::size_t remaining() const { return data_.size() - pos_; }
+    bool ok() const { return ok_; }
+
+private:
+    std::string_view data_;
+    std::size_t pos_ = 0;
+    bool ok_ = true;
+};
+
+namespace detail {
+
+template <class Member>
+using wire_type = std::conditional_t<std::is_enum_v<Member>, std::underlying_type<Member>,
+                                     std::type_identity<Member>>::type;
+
+// --- 固定大小的整數欄位 ---
+template <class Owner, class Member>
+constexpr std::size_t size_of(const Field<Owner, Member>&, const Owner&) { return sizeof(wire_type<Member>); }
+
+template <class Owner, class Member>
+void write(Writer& writer, const Field<Owner, Member>& f, const Owner& message) {
+    writer.put_uint<sizeof(wire_type<Member>)>(static_cast<uint64_t>(message.*f.member));
+}
+
+template <class Owner, class Member>
+void read(Reader& reader, const Field<Owner, Member>& f, Owner& message) {
+    const uint64_t value = reader.get_uint<sizeof(wire_type<Member>)>();
+    if constexpr (std::is_same_v<Member, bool>) {
+        message.*f.member = value != 0;
+    } else {
+        message.*f.member = static_cast<Member>(value);
+    }
+}
+
+// --- 帶長度的字串 ---
+template <class Owner>
+constexpr std::size_t size_of(const Text<Owner>& f, const Owner& message) {
+    return sizeof(uint16_t) + (message.*f.member).size();
+}
+
+template <class Owner>
+void write(Writer& writer, const Text<Owner>& f, const Owner& message) {
+    const std::string_view value = message.*f.member;
+    if (value.size() > std::numeric_limits<uint16_t>::max()) {
+        writer.fail();
+        return;
+    }
+    writer.put_uint<sizeof(uint16_t)>(value.size());
+    writer.put_bytes(value);
+}
+
+template <class Owner>
+void read(Reader& reader, const Text<Owner>& f, Owner& message) {
+    const auto length = static_cast<std::size_t>(reader.get_uint<sizeof(uint16_t)>());
+    message.*f.member = reader.get_bytes(length);
+}
+
+// --- 剩下的所有位元組 ---
+template <class Owner>
+constexpr std::size_t size_of(const Tail<Owner>& f, const Owner& message) { return (message.*f.member).size(); }
+
+template <class Owner>
+void write(Writer& writer, const Tail<Owner>& f, const Owner& message) {
+    writer.put_bytes(message.*f.member);
+}
+
+template <class Owner>
+void read(Reader& reader, const Tail<Owner>& f, Owner& message) {
+    message.*f.member = reader.get_bytes(reader.remaining());
+}
+
+template <class T>
+struct is_tail : std::false_type {};
+template <class Owner>
+struct is_tail<Tail<Owner>> : std::true_type {};
+
+// tail 欄位只能出現在最後
+template <class Fields, std::size_t... I>
+constexpr bool tail_only_last(std::index_sequence<I...>) {
+    constexpr std::size_t count = sizeof...(I);
+    return ((I + 1 == count || !is_tail<std::tuple_element_t<I, Fields>>::value) && ...);
+}
+
+template <class Message>
+constexpr const auto& fields_of() {
+    using Fields = std::remove_cv_t<decltype(MessageSchema<Message>::fields)>;
+    static_assert(tail_only_last<Fields>(std::make_index_sequence<std::tuple_size_v<Fields>>{}),
+                  "codec::tail must be the last field of a message");
+    return MessageSchema<Message>::fields;
+}
+
+} // namespace detail
+
+template <class Message>
+constexpr CommandID command_of() { return MessageSchema<Message>::command; }
+
+// 編碼後承載資料的大小
+template <class Message>
+constexpr std::size_t encoded_size(const Message& message) {
+    return std::apply([&](const auto&... f) { return (std::size_t{0} + ... + detail::size_of(f, message)); },
+                      detail::fields_of<Message>());
+}
+
+// 將承載資料寫入 out (不含訊框標頭)，剛好寫入 encoded_size(message) 個位元組
+// 空間不足或欄位無法編碼時回傳 false
+template <class Message>
+bool encode(const Message& message, char* out, std::size_t capacity) {
+    Writer writer(out, capacity);
+    std::apply([&](const auto&... f) { (detail::write(writer, f, message), ...); }, detail::fields_of<Message>());
+    return writer.ok();
+}
+
+// 從承載資料解碼；長度不符或欄位超出範圍時回傳 false
+// 字串欄位指向 payload 的記憶體，不會複製
+template <class Message>
+bool decode(std::string_view payload, Message& out) {
+    Reader reader(payload);
+    std::apply([&](const auto&... f) { (detail::read(reader, f, out), ...); }, detail::fields_of<Message>());
+    return reader.ok() && reader.remaining() == 0;
+}
+
+// 指令 ID 符合時才解碼
+template <class Message>
+bool decode(uint16_t command_id, std::string_view payload, Message& out) {
+    return command_id == command_of<Message>() && decode(payload, out);
+}
+
+} // namespace codec
@@ -0,0 +1,142 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <tuple>
+#include "frame/MessageCodec.hpp"
+
+// 各指令承載資料的結構 (schema)，編解碼由 codec 在編譯期產生
+// 線上格式與原本手寫的編碼相同；字串欄位只在訊框 (或編碼的來源) 有效期間可用
+// 新增指令時在此定義 struct 並特化 codec::MessageSchema
+
+// CMD_AUTH_REQUEST：承載資料即為 token
+struct AuthRequest {
+    std::string_view token;
+};
+
+// CMD_AUTH_RESPONSE：狀態 (AuthStatus) + 認證的身分 (失敗時為空)
+struct AuthResponse {
+    uint8_t status = 0;
+    std::string_view subject;
+};
+
+// CMD_SUBSCRIBE_TOPIC：承載資料即為主題名稱
+struct SubscribeRequest {
+    std::string_view topic;
+};
+
+// CMD_REPLAY_REQUEST：從這個 offset 開始重播訊息日誌
+struct ReplayRequest {
+    uint64_t offset = 0;
+};
+
+// 重播狀態碼 (CMD_REPLAY_RESPONSE 的第一個位元組)
+enum ReplayStatus : uint8_t {
+    REPLAY_COMPLETE = 0,       // 已重播到最新的訊息
+    REPLAY_LOG_DISABLED = 1,   // 伺服器未啟用訊息日誌
+    REPLAY_BAD_REQUEST = 2,    // 請求格式錯誤
+};
+
+// CMD_REPLAY_RESPONSE：重播結束 (或失敗) 的標記
+struct ReplayResponse {
+    ReplayStatus status = REPLAY_COMPLETE;
+    uint64_t next_offset = 0;
+};
+
+// CMD_PEER_HELLO：發起聯邦連線的節點名稱
+struct PeerHello {
+    std::string_view node_name;
+};
+
+// CMD_PEER_INTEREST：開始 (或不再) 需要某個主題
+struct PeerInterest {
+    bool interested = false;
+    std::string_view topic;
+};
+
+// CMD_BATCH_ACK：批次中已處理的子訊息數
+struct BatchAck {
+    uint32_t count = 0;
+};
+
+// CMD_DIGEST_REQUEST：對資料計算 SHA-256，再對摘要重複計算到共 rounds 次
+struct DigestRequest {
+    uint32_t rounds = 1;
+    std::string_view data;
+};
+
+// 摘要狀態碼 (CMD_DIGEST_RESPONSE 的第一個位元組)
+enum DigestStatus : uint8_t {
+    DIGEST_OK = 0,
+    DIGEST_BAD_REQUEST = 1,    // 請求格式錯誤或迭代次數超出範圍
+};
+
+// CMD_DIGEST_RESPONSE：狀態 + 摘要 (失敗時為空)
+struct DigestResponse {
+    DigestStatus status = DIGEST_OK;
+    std::string_view digest;
+};
+
+template <>
+struct codec::MessageSchema<AuthRequest> {
+    static constexpr CommandID command = CMD_AUTH_REQUEST;
+    static constexpr auto fields = std::make_tuple(codec::tail(&AuthRequest::token));
+};
+
+template <>
+struct codec::MessageSchema<AuthResponse> {
+    static constexpr CommandID command = CMD_AUTH_RESPONSE;
+    static constexpr auto fields = std::make_tuple(codec::field(&AuthResponse::status),
+                                                   codec::tail(&AuthResponse::subject));
+};
+
+template <>
+struct codec::MessageSchema<SubscribeRequest> {
+    static constexpr CommandID command = CMD_SUBSCRIBE_TOPIC;
+    static constexpr auto fields = std::make_tuple(codec::tail(&SubscribeRequest::topic));
+};
+
+template <>
+struct codec::MessageSchema<ReplayRequest> {
+    static constexpr CommandID command = CMD_REPLAY_REQUEST;
+    static constexpr auto fields = std::make_tuple(codec::field(&ReplayRequest::offset));
+};
+
+template <>
+struct codec::MessageSchema<ReplayResponse> {
+    static constexpr CommandID command = CMD_REPLAY_RESPONSE;
+    static constexpr auto fields = std::make_tuple(codec::field(&ReplayResponse::status),
+                                                   codec::field(&ReplayResponse::next_offset));
+};
+
+template <>
+struct codec::MessageSchema<PeerHello> {
+    static constexpr CommandID command = CMD_PEER_HELLO;
+    static constexpr auto fields = std::make_tuple(codec::tail(&PeerHello::node_name));
+};
+
+template <>
+struct codec::MessageSchema<PeerInterest> {
+    static constexpr CommandID command = CMD_PEER_INTEREST;
+    static constexpr auto fields = std::make_tuple(codec::field(&PeerInterest::interested),
+                                                   codec::tail(&PeerInterest::topic));
+};
+
+template <>
+struct codec::MessageSchema<BatchAck> {
+    static constexpr CommandID command = CMD_BATCH_ACK;
+    static constexpr auto fields = std::make_tuple(codec::field(&BatchAck::count));
+};
+
+template <>
+struct codec::MessageSchema<DigestRequest> {
+    static constexpr CommandID command = CMD_DIGEST_REQUEST;
+    static constexpr auto fields = std::make_tuple(codec::field(&DigestRequest::rounds),
+                                                   codec::tail(&DigestRequest::data));
+};
+
+template <>
+struct codec::MessageSchema<DigestResponse> {
+    static constexpr CommandID command = CMD_DIGEST_RESPONSE;
+    static constexpr auto fields = std::make_tuple(codec::field(&DigestResponse::status),
+                                                   codec::tail(&DigestResponse::digest));
+};
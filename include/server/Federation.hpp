@@ -0,0 +1,477 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_set>
+#include <atomic>
+#include <algorithm>
+#include <asio.hpp>
+#include <asio/ssl.hpp>
+#include "utils/Logger.hpp"
+#include "frame/FrameParser.hpp"
+#include "frame/FrameBuilder.hpp"
+#include "frame/Messages.hpp"
+#include "server/ServerMetrics.hpp"
+#include "server/TopicRegistry.hpp"
+#include "auth/TokenAuthenticator.hpp"
+
+using asio::ip::tcp;
+
+// 建立 CMD_PEER_INTEREST 訊框
+inline std::vector<char> build_peer_interest(const std::string& topic, bool interested) {
+    return FrameBuilder::build(PeerInterest{interested, topic});
+}
+
+// 待轉送的訊框依序累積成 CMD_PEER_FORWARD 批次 (不做同步，由 PeerLink 的鎖保護)
+//
+// 批次以 max_batch_bytes 為目標大小；超過目標大小的訊框單獨成為一批。
+// 每個批次訊框 (標頭 + 串接的訊框) 都不會超過 FrameParser 的訊框上限，否則對方會把它當成惡意封包而斷線，
+// 放不進一個批次的訊框 (max_frame_bytes 以上) 無法轉送。
+class ForwardQueue {
+public:
+    struct Batch {
+        std::vector<char> bytes; // 標頭 + 串接的訊框
+        std::size_t messages = 0;
+    };
+
+    // 批次的目標大小 (包含標頭)
+    static constexpr std::size_t max_batch_bytes = 32 * 1024;
+    // 可以轉送的單一訊框上限：CMD_PEER_FORWARD 的標頭之外的空間
+    static constexpr std::size_t max_frame_bytes = FrameParser::max_frame_length - sizeof(FrameHeader);
+
+    // 加入一個已編碼的訊框；訊框太大、無法轉送時回傳 false
+    bool push(const std::vector<char>& frame) {
+        if (frame.size() > max_frame_bytes) return false;
+        if (batches_.empty() || batches_.back().bytes.size() + frame.size() > max_batch_bytes) {
+            batches_.emplace_back();
+            batches_.back().bytes.resize(sizeof(FrameHeader)); // 預留批次訊框的標頭
+        }
+        auto& batch = batches_.back();
+        batch.bytes.insert(batch.bytes.end(), frame.begin(), frame.end());
+        ++batch.messages;
+        bytes_ += frame.size();
+        return true;
+    }
+
+    bool empty() const { return batches_.empty(); }
+
+    // 尚未取出的訊框位元組數 (不含批次標頭)
+    std::size_t bytes() const { return bytes_; }
+
+    // 取出最早的批次，並寫好 CMD_PEER_FORWARD 標頭
+    Batch pop() {
+        Batch batch = std::move(batches_.front());
+        batches_.pop_front();
+        bytes_ -= batch.bytes.size() - sizeof(FrameHeader);
+        FrameBuilder::write_header(batch.bytes.data(), CMD_PEER_FORWARD, batch.bytes.size() - sizeof(FrameHeader));
+        return batch;
+    }
+
+    // 捨棄所有批次，回傳捨棄的訊息數
+    std::size_t clear() {
+        std::size_t messages = 0;
+        for (const auto& batch : batches_) messages += batch.messages;
+        batches_.clear();
+        bytes_ = 0;
+        return messages;
+    }
+
+private:
+    std::deque<Batch> batches_; // 最後一個仍可附加
+    std::size_t bytes_ = 0;
+};
+
+// 本節點連往另一個節點的持久連線 (單向轉送：本節點 -> 對方)
+//
+// 對方透過同一條連線回報它需要哪些主題 (CMD_PEER_INTEREST)，本節點只轉送這些主題的訊息。
+// 轉送的訊息會累積成批次：上一批還在寫出時，新訊息都附加到下一批，
+// 寫完後整批以一個 CMD_PEER_FORWARD 訊框 (一次寫入、一個 TLS record) 送出。
+// 連線中斷時每秒重試一次，重新連上後對方會重新送出完整的主題清單。
+class PeerLink : public std::enable_shared_from_this<PeerLink> {
+public:
+    PeerLink(asio::io_context& io_context, std::shared_ptr<asio::ssl::context> ssl_context,
+             std::string host, std::string port, std::string node_name,
+             std::shared_ptr<TokenAuthenticator> authenticator,
+             std::shared_ptr<ServerMetrics> metrics, std::shared_ptr<spdlog::logger> logger)
+        : strand_(asio::make_strand(io_context)),
+          ssl_context_(std::move(ssl_context)),
+          resolver_(strand_),
+          retry_timer_(strand_),
+          host_(std::move(host)),
+          port_(std::move(port)),
+          node_name_(std::move(node_name)),
+          authenticator_(std::move(authenticator)),
+          metrics_(std::move(metrics)),
+          logger_(std::move(logger)) {}
+
+    void start() {
+        asio::post(strand_, [self = shared_from_this()] { self->connect(); });
+    }
+
+    void stop() {
+        stopped_ = true;
+        asio::post(strand_, [self = shared_from_this()] {
+            self->retry_timer_.cancel();
+            self->close();
+        });
+    }
+
+    std::string name() const { return host_ + ":" + port_; }
+
+    // 對方是否有這個主題的訂閱者 (任何執行緒皆可呼叫)
+    bool wants(const std::string& topic) const {
+        std::shared_lock lock(interest_mutex_);
+        return remote_topics_.count(topic) > 0;
+    }
+
+    // 將一個已編碼的 CMD_PUBLISH_MESSAGE 訊框加入待轉送的批次 (任何執行緒皆可呼叫)
+    void forward(const std::vector<char>& frame) {
+        bool start_flush = false;
+        {
+            std::lock_guard lock(pending_mutex_);
+            if (!connected_ || pending_.bytes() + frame.size() > max_pending_bytes) {
+                metrics_->forward_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            if (!pending_.push(frame)) {
+                // 接近訊框上限的發布加上批次標頭後超過對方的上限，無法轉送
+                metrics_->forward_dropped.fetch_add(1, std::memory_order_relaxed);
+                logger_->warn("Dropped a {}-byte message for {}: too large to forward", frame.size(), name());
+                return;
+            }
+            if (!flush_scheduled_) {
+                flush_scheduled_ = true;
+                start_flush = true;
+            }
+        }
+        if (start_flush) {
+            asio::post(strand_, [self = shared_from_this()] { self->flush(); });
+        }
+    }
+
+private:
+    using Stream = asio::ssl::stream<tcp::socket>;
+
+    // 每次重新連線都建立新的 stream；回呼持有自己的 stream，連線更換後舊連線的回呼直接忽略
+    void connect() {
+        if (stopped_) return;
+        auto stream = std::make_shared<Stream>(strand_, *ssl_context_);
+        stream_ = stream;
+        parser_ = FrameParser();
+        resolver_.async_resolve(host_, port_,
+            [this, self = shared_from_this(), stream](const asio::error_code& ec, tcp::resolver::results_type endpoints) {
+                if (ec) return fail(stream, "resolve", ec);
+                asio::async_connect(stream->lowest_layer(), endpoints,
+                    [this, self, stream](const asio::error_code& ec, const tcp::endpoint&) {
+                        if (ec) return fail(stream, "connect", ec);
+                        asio::error_code ignored;
+                        stream->lowest_layer().set_option(tcp::no_delay(true), ignored);
+                        stream->async_handshake(asio::ssl::stream_base::client,
+                            [this, self, stream](const asio::error_code& ec) {
+                                if (ec) return fail(stream, "handshake", ec);
+                                on_connected(stream);
+                            });
+                    });
+            });
+    }
+
+    void on_connected(const std::shared_ptr<Stream>& stream) {
+        if (stream != stream_) return;
+        logger_->info("Federation link to {} established", name());
+        failures_ = 0;
+        // 啟用認證時，節點以共用的金鑰組為自己簽發 token，與 HELLO 一起送出
+        hello_.clear();
+        if (authenticator_) {
+            std::string subject = "peer/" + node_name_;
+            std::replace(subject.begin(), subject.end(), ':', '/'); // token 的欄位以 ':' 分隔
+            hello_ = FrameBuilder::build(CMD_AUTH_REQUEST, authenticator_->issue(subject, std::chrono::hours(1)));
+        }
+        const auto hello = FrameBuilder::build(PeerHello{node_name_});
+        if (hello.empty()) return fail(stream, "encode hello", asio::error::invalid_argument);
+        hello_.insert(hello_.end(), hello.begin(), hello.end());
+        writing_ = true;
+        asio::async_write(*stream, asio::buffer(hello_),
+            [this, self = shared_from_this(), stream](const asio::error_code& ec, std::size_t) {
+                if (stream != stream_) return;
+                writing_ = false;
+                if (ec) return fail(stream, "write", ec);
+                {
+                    std::lock_guard lock(pending_mutex_);
+                    connected_ = true;
+                }
+                flush();
+            });
+        do_read(stream);
+    }
+
+    // 讀取對方回報的主題清單變化
+    void do_read(const std::shared_ptr<Stream>& stream) {
+        stream->async_read_some(asio::buffer(read_buffer_),
+            [this, self = shared_from_this(), stream](const asio::error_code& ec, std::size_t length) {
+                if (stream != stream_) return;
+                if (ec) return fail(stream, "read", ec);
+                parser_.push_data(read_buffer_.data(), length);
+                Frame frame;
+                ParseResult result;
+                while ((result = parser_.try_parse(frame)) == ParseResult::SUCCESS) {
+                    AuthResponse auth;
+                    PeerInterest interest;
+                    if (frame.decode(auth) && auth.status != 0) {
+                        logger_->error("Federation link to {} rejected: {}", name(),
+                                       auth_status_name(static_cast<AuthStatus>(auth.status)));
+                    }
+                    if (frame.decode(interest)) {
+                        std::string topic(interest.topic);
+                        std::unique_lock lock(interest_mutex_);
+                        if (interest.interested) {
+                            remote_topics_.insert(std::move(topic));
+                        } else {
+                            remote_topics_.erase(topic);
+                        }
+                    }
+                }
+                if (result == ParseResult::INVALID_HEADER) {
+                    return fail(stream, "read", asio::error::invalid_argument);
+                }
+                do_read(stream);
+            });
+    }
+
+    // 必須在 strand 中呼叫：寫出下一個批次
+    void flush() {
+        if (writing_ || !stream_) return;
+        {
+            std::lock_guard lock(pending_mutex_);
+            if (pending_.empty() || !connected_) {
+                flush_scheduled_ = false;
+                return;
+            }
+            in_flight_ = pending_.pop();
+        }
+
+        writing_ = true;
+        asio::async_write(*stream_, asio::buffer(in_flight_.bytes),
+            [this, self = shared_from_this(), stream = stream_](const asio::error_code& ec, std::size_t) {
+                if (stream != stream_) return;
+                writing_ = false;
+                if (ec) {
+                    metrics_->forward_dropped.fetch_add(in_flight_.messages, std::memory_order_relaxed);
+                    return fail(stream, "write", ec);
+                }
+                metrics_->forwarded_out.fetch_add(in_flight_.messages, std::memory_order_relaxed);
+                metrics_->forward_batches.fetch_add(1, std::memory_order_relaxed);
+                flush();
+            });
+    }
+
+    // 必須在 strand 中呼叫：關閉連線並捨棄尚未送出的批次
+    void close() {
+        {
+            std::lock_guard lock(pending_mutex_);
+            connected_ = false;
+            metrics_->forward_dropped.fetch_add(pending_.clear(), std::memory_order_relaxed);
+            flush_scheduled_ = false;
+        }
+        {
+            std::unique_lock lock(interest_mutex_);
+            remote_topics_.clear();
+        }
+        if (stream_) {
+            asio::error_code ignored;
+            stream_->lowest_layer().close(ignored);
+            stream_.reset(); // 尚未完成的回呼仍持有這個 stream，會以 operation_aborted 結束
+        }
+        writing_ = false;
+    }
+
+    void fail(const std::shared_ptr<Stream>& stream, const char* what, const asio::error_code& ec) {
+        if (stopped_ || stream != stream_) return;
+        // 對方可能尚未啟動，重試時只記錄第一次失敗，避免洗版
+        if (failures_++ == 0) {
+            logger_->warn("Federation link to {} {} failed: {}. Retrying every second.", name(), what, ec.message());
+        }
+        close();
+        retry_timer_.expires_after(std::chrono::seconds(1));
+        retry_timer_.async_wait([this, self = shared_from_this()](const asio::error_code& ec) {
+            if (!ec) connect();
+        });
+    }
+
+    // 尚未送出的轉送資料上限，超過時丟棄新的訊息而不是無限制地累積
+    static constexpr std::size_t max_pending_bytes = 8 * 1024 * 1024;
+
+    asio::strand<asio::io_context::executor_type> strand_;
+    std::shared_ptr<asio::ssl::context> ssl_context_;
+    tcp::resolver resolver_;
+    asio::steady_timer retry_timer_;
+    std::shared_ptr<Stream> stream_;
+    std::string host_;
+    std::string port_;
+    std::string node_name_;
+    std::vector<char> hello_; // 連線後送出的第一批訊框 (認證 + HELLO)
+    std::shared_ptr<TokenAuthenticator> authenticator_;
+    std::array<char, 4096> read_buffer_;
+    FrameParser parser_;
+    ForwardQueue::Batch in_flight_;
+    bool writing_ = false;
+    unsigned failures_ = 0;
+    std::atomic<bool> stopped_{false};
+
+    mutable std::shared_mutex interest_mutex_;
+    std::unordered_set<std::string> remote_topics_; // 對方需要的主題
+
+    std::mutex pending_mutex_;
+    ForwardQueue pending_;                // 等待寫出的批次
+    bool flush_scheduled_ = false;        // 是否已有 flush 排入 strand 或正在寫出
+    bool connected_ = false;              // 連線是否可用 (受 pending_mutex_ 保護)
+
+    std::shared_ptr<ServerMetrics> metrics_;
+    std::shared_ptr<spdlog::logger> logger_;
+};
+
+// 多節點聯邦：讓多個伺服器實例共同組成一個邏輯上的伺服器
+//
+// 每個節點對設定中的每個 peer 建立一條 PeerLink (因此節點之間互相設定 --peer 會形成全連接網狀)。
+// - 本地發布的訊息只轉送給有訂閱者的節點；收到的轉送訊息只送給本地訂閱者，不會再轉送 (避免迴圈)
+// - 其他節點連進來的連線 (inbound peer session) 用來接收轉送並回報本節點需要的主題
+class Federation {
+public:
+    Federation(asio::io_context& io_context, const std::vector<std::string>& peers, std::string node_name,
+               std::shared_ptr<TopicRegistry> topics, std::shared_ptr<TokenAuthenticator> authenticator,
+               std::shared_ptr<ServerMetrics> metrics, std::shared_ptr<spdlog::logger> logger)
+        : ssl_context_(std::make_shared<asio::ssl::context>(asio::ssl::context::tls_client)),
+          topics_(std::move(topics)),
+          metrics_(metrics),
+          logger_(logger) {
+        // 節點之間使用與客戶端相同的伺服器憑證驗證對方
+        ssl_context_->set_options(asio::ssl::context::default_workarounds |
+                                  asio::ssl::context::no_sslv2 |
+                                  asio::ssl::context::no_sslv3 |
+                                  asio::ssl::context::no_tlsv1 |
+                                  asio::ssl::context::no_tlsv1_1);
+        ssl_context_->set_verify_mode(asio::ssl::verify_peer);
+        ssl_context_->load_verify_file("certs/server.crt");
+
+        for (const auto& peer : peers) {
+            const auto colon = peer.rfind(':');
+            if (colon == std::string::npos) {
+                throw std::invalid_argument("Peer address must be HOST:PORT: " + peer);
+            }
+            links_.push_back(std::make_shared<PeerLink>(io_context, ssl_context_, peer.substr(0, colon),
+                                                        peer.substr(colon + 1), node_name, authenticator,
+                                                        metrics, logger));
+        }
+
+        // 本節點需要的主題有變化時通知所有連進來的節點
+        topics_->set_interest_callback([this](const std::string& topic, bool interested) {
+            auto frame = std::make_shared<const std::vector<char>>(build_peer_interest(topic, interested));
+            if (frame->empty()) return;
+            std::lock_guard lock(inbound_mutex_);
+            for (const auto& entry : inbound_peers_) {
+                if (auto peer = entry.peer.lock()) {
+                    peer->deliver(frame, PriorityClass::CONTROL);
+                }
+            }
+        });
+    }
+
+    void start() {
+        for (const auto& link : links_) {
+            logger_->info("Federation: linking to peer {}", link->name());
+            link->start();
+        }
+    }
+
+    void stop() {
+        for (const auto& link : links_) {
+            link->stop();
+        }
+    }
+
+    std::size_t link_count() const { return links_.size(); }
+
+    // 本地發布的訊息：轉送給需要此主題的節點
+    void forward(const std::string& topic, const std::vector<char>& frame) {
+        for (const auto& link : links_) {
+            if (link->wants(topic)) {
+                link->forward(frame);
+            }
+        }
+    }
+
+    // 另一個節點連進來並送出 CMD_PEER_HELLO：送出目前的主題清單，並開始接收後續變化
+    void add_inbound_peer(const std::shared_ptr<TopicSubscriber>& peer) {
+        topics_->with_topics([&](const std::vector<std::string>& topics) {
+            {
+                std::lock_guard lock(inbound_mutex_);
+                inbound_peers_.push_back({peer.get(), peer});
+            }
+            for (const auto& topic : topics) {
+                auto frame = std::make_shared<const std::vector<char>>(build_peer_interest(topic, true));
+                if (!frame->empty()) peer->deliver(std::move(frame), PriorityClass::CONTROL);
+            }
+        });
+    }
+
+    void remove_inbound_peer(const TopicSubscriber* peer) {
+        std::lock_guard lock(inbound_mutex_);
+        inbound_peers_.erase(std::remove_if(inbound_peers_.begin(), inbound_peers_.end(),
+                                            [&](const InboundPeer& entry) { return entry.key == peer; }),
+                             inbound_peers_.end());
+    }
+
+    // 收到其他節點轉送的批次：拆出每個 CMD_PUBLISH_MESSAGE 訊框，送給本地訂閱者
+    // 回傳 false 表示批次格式錯誤 (長度不合法，或尾端有不完整的訊框)，此時不送出任何訊息
+    bool deliver_forwarded(std::string_view payload) {
+        if (!well_formed_batch(payload)) return false;
+
+        const char* data = payload.data();
+        std::size_t length = payload.size();
+        FrameParser parser;
+        FrameView frame;
+        uint64_t messages = 0;
+        uint64_t delivered = 0;
+        while (length > 0 && parser.next(data, length, frame) == ParseResult::SUCCESS) {
+            if (frame.header.command_id != CMD_PUBLISH_MESSAGE) continue;
+            ++messages;
+            const std::string_view body = frame.payload();
+            const std::string topic = publish_topic(body.data(), body.size());
+            auto packet = std::make_shared<const std::vector<char>>(FrameBuilder::build(CMD_PUBLISH_MESSAGE, body));
+            delivered += topics_->publish(topic, packet, priority_class_of(CMD_PUBLISH_MESSAGE));
+        }
+        metrics_->forwarded_in.fetch_add(messages, std::memory_order_relaxed);
+        metrics_->delivered.fetch_add(delivered, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 批次的承載資料剛好由完整的訊框組成
+    static bool well_formed_batch(std::string_view payload) {
+        const char* data = payload.data();
+        std::size_t length = payload.size();
+        FrameParser parser;
+        FrameView frame;
+        while (length > 0) {
+            // 尾端不完整的訊框也會讓 next() 回傳 NEED_MORE_DATA
+            if (parser.next(data, length, frame) != ParseResult::SUCCESS) return false;
+        }
+        return true;
+    }
+
+private:
+    struct InboundPeer {
+        const TopicSubscriber* key;
+        std::weak_ptr<TopicSubscriber> peer;
+    };
+
+    std::shared_ptr<asio::ssl::context> ssl_context_;
+    std::shared_ptr<TopicRegistry> topics_;
+    std::vector<std::shared_ptr<PeerLink>> links_;
+    std::mutex inbound_mutex_;
+    std::vector<InboundPeer> inbound_peers_;
+    std::shared_ptr<ServerMetrics> metrics_;
+    std::shared_ptr<spdlog::logger> logger_;
+};
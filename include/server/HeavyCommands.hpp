@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+#include <openssl/sha.h>
+#include "frame/FrameHeader.hpp"
+#include "frame/FrameBuilder.hpp"
+#include "frame/Messages.hpp"
+
+/**
+ * @brief 耗用 CPU 的指令 (heavy command)
+ *
+ * 處理時間遠大於一次讀寫的指令在這裡標記與實作。設定了工作執行緒 (--worker-threads) 時，
+ * Session 把它們交給工作執行緒，完成後再把回覆送回 Session 的 strand，
+ * io 執行緒不會因為一個昂貴的請求而延遲同一條執行緒上其他連線的讀寫。
+ *
+ * 這裡的函式只使用承載資料的複本，不存取 Session，可以在任何執行緒上呼叫。
+ * 新增耗用 CPU 的指令時，在 is_heavy_command() 標記，並在 run_heavy_command() 與 reject_heavy_command() 分派。
+ */
+
+// 單一請求的迭代次數上限 (約數百毫秒的 CPU 時間)
+constexpr uint32_t max_digest_rounds = 1u << 20;
+
+inline bool is_heavy_command(uint16_t command_id) {
+    switch (command_id) {
+        case CMD_DIGEST_REQUEST:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// CMD_DIGEST_REQUEST：SHA-256(data)，之後對摘要重複計算到共 rounds 次
+inline std::vector<char> handle_digest_request(std::string_view payload) {
+    DigestRequest request;
+    if (!codec::decode(payload, request) || request.rounds == 0 || request.rounds > max_digest_rounds) {
+        return FrameBuilder::build(DigestResponse{DIGEST_BAD_REQUEST, {}});
+    }
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    unsigned char next[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(request.data.data()), request.data.size(), digest);
+    for (uint32_t round = 1; round < request.rounds; ++round) {
+        SHA256(digest, sizeof(digest), next);
+        std::memcpy(digest, next, sizeof(digest));
+    }
+    return FrameBuilder::build(
+        DigestResponse{DIGEST_OK, std::string_view(reinterpret_cast<const char*>(digest), sizeof(digest))});
+}
+
+// 執行耗用 CPU 的指令，回傳完整的回覆訊框 (請求 ID 由呼叫端設定)
+inline std::vector<char> run_heavy_command(uint16_t command_id, std::string_view payload) {
+    switch (command_id) {
+        case CMD_DIGEST_REQUEST:
+            return handle_digest_request(payload);
+        default:
+            return {};
+    }
+}
+
+// 拒絕執行時的回覆 (例如位於 CMD_BATCH 中)，不做任何計算
+inline std::vector<char> reject_heavy_command(uint16_t command_id) {
+    switch (command_id) {
+        case CMD_DIGEST_REQUEST:
+            return FrameBuilder::build(DigestResponse{DIGEST_BAD_REQUEST, {}});
+        default:
+            return {};
+    }
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <asio.hpp>
+#include "utils/Logger.hpp"
+#include "utils/CpuAffinity.hpp"
+#include "server/ServerMetrics.hpp"
+
+// 管理一組 io_context 與執行它們的執行緒
+// - context_count == 1：所有執行緒共用同一個 io_context (原本的模式)
+// - context_count == thread_count：每條執行緒擁有自己的 io_context
+class IoContextPool {
+public:
+    IoContextPool(std::string name, std::size_t context_count, std::shared_ptr<spdlog::logger> logger)
+        : name_(std::move(name)),
+          logger_(logger) {
+        if (context_count == 0) context_count = 1;
+        contexts_.reserve(context_count);
+        for (std::size_t i = 0; i < context_count; ++i) {
+            contexts_.push_back(std::make_unique<asio::io_context>());
+            work_guards_.push_back(asio::make_work_guard(*contexts_.back()));
+        }
+    }
+
+    // 第一個 io_context，用於 acceptor 等只需要單一 context 的物件
+    asio::io_context& primary_context() { return *contexts_.front(); }
+
+    // 以輪詢 (round-robin) 的方式挑選下一個 io_context
+    asio::io_context& next_context() {
+        const std::size_t index = next_.fetch_add(1, std::memory_order_relaxed) % contexts_.size();
+        return *contexts_[index];
+    }
+
+    std::size_t context_count() const { return contexts_.size(); }
+
+    // 啟用 busy-poll：執行緒閒置時先以 poll() 空轉 window 這麼久，仍沒有工作才阻塞等待
+    // 必須在 run() 之前呼叫
+    void enable_busy_poll(std::chrono::microseconds window, std::shared_ptr<ServerMetrics> metrics) {
+        busy_poll_window_ = window;
+        metrics_ = std::move(metrics);
+    }
+
+    // 啟動 thread_count 條執行緒。第 i 條執行緒執行 contexts_[i % context_count]，
+    // 並在開始執行前綁定到 cpus[i % cpus.size()] (pin_each) 或整個 cpus 集合
+    void run(std::size_t thread_count, const std::vector<int>& cpus, bool pin_each) {
+        threads_.reserve(thread_count); // threads_ <vector> 一次預先準備好記憶體空間
+        for (std::size_t i = 0; i < thread_count; ++i) {
+            std::vector<int> thread_cpus = cpus;
+            if (pin_each && !cpus.empty()) {
+                thread_cpus = { cpus[i % cpus.size()] };
+            }
+            asio::io_context& context = *contexts_[i % contexts_.size()];
+            threads_.emplace_back([this, i, &context, thread_cpus] {
+                // 必須在執行任何 handler 之前綁定，之後此執行緒配置的記憶體才會落在本地節點
+                if (!thread_cpus.empty()) {
+                    if (pin_current_thread(thread_cpus)) {
+                        logger_->info("{} thread {} pinned to CPU {} (NUMA node {})", name_, i,
+                                      format_cpu_list(thread_cpus), numa_node_of_cpu(thread_cpus.front()));
+                    } else {
+                        logger_->warn("{} thread {} failed to pin to CPU {}", name_, i, format_cpu_list(thread_cpus));
+                    }
+                }
+                if (busy_poll_window_.count() > 0) {
+                    run_busy_poll(context);
+                } else {
+                    context.run();
+                }
+            });
+        }
+    }
+
+    void stop() {
+        // 釋放 work_guard，允許 io_context 在所有任務完成後退出
+        for (auto& guard : work_guards_) {
+            guard.reset();
+        }
+        for (auto& context : contexts_) {
+            context->stop();
+        }
+        // 等待所有執行緒自然結束
+        for (auto& t : threads_) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+    }
+
+    bool stopped() const {
+        for (const auto& context : contexts_) {
+            if (!context->stopped()) return false;
+        }
+        return true;
+    }
+
+private:
+    // busy-poll 的事件迴圈
+    // poll() 只執行已就緒的 handler (epoll_wait 逾時為 0)，不會讓執行緒睡眠；
+    // 空轉超過 busy_poll_window_ 仍無工作時才呼叫 run_one() 阻塞等待
+    void run_busy_poll(asio::io_context& context) {
+        using clock = std::chrono::steady_clock;
+        // 統計先累積在區域變數，於每次阻塞前才寫入共享的原子計數
+        uint64_t spin_ns = 0, hits = 0, blocks = 0;
+        auto flush = [&] {
+            if (!metrics_) return;
+            metrics_->busy_poll_spin_ns.fetch_add(spin_ns, std::memory_order_relaxed);
+            metrics_->busy_poll_hits.fetch_add(hits, std::memory_order_relaxed);
+            metrics_->busy_poll_blocks.fetch_add(blocks, std::memory_order_relaxed);
+            spin_ns = hits = blocks = 0;
+        };
+
+        while (!context.stopped()) {
+            // 先把已就緒的工作做完
+            if (context.poll() > 0) continue;
+
+            // 閒置：在時間窗內空轉輪詢
+            // 只計算沒有取得工作的輪詢時間，不含之後執行 handler 的時間
+            const auto spin_start = clock::now();
+            auto poll_start = spin_start;
+            bool found_work = false;
+            while (!context.stopped() && poll_start - spin_start < busy_poll_window_) {
+                if (context.poll() > 0) {
+                    found_work = true;
+                    break;
+                }
+                poll_start = clock::now();
+            }
+            spin_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(poll_start - spin_start).count();
+
+            if (found_work) {
+                // 持續忙碌的執行緒很少阻塞，定期寫入統計讓報告保持更新
+                if (++hits % 1024 == 0) flush();
+            } else if (!context.stopped()) {
+                ++blocks;
+                flush();
+                context.run_one(); // 阻塞直到下一個 handler 完成
+            }
+        }
+        flush();
+    }
+
+    std::string name_;
+    std::vector<std::unique_ptr<asio::io_context>> contexts_;
+    std::vector<asio::executor_work_guard<asio::io_context::executor_type>> work_guards_;
+    std::vector<std::thread> threads_;
+    std::atomic<std::size_t> next_{0};
+    std::chrono::microseconds busy_poll_window_{0};
+    std::shared_ptr<ServerMetrics> metrics_;
+    std::shared_ptr<spdlog::logger> logger_;
+};
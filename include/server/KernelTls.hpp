@@ -0,0 +1,296 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <openssl/ssl.h>
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+#include <openssl/crypto.h>
+
+#if defined(__linux__) && __has_include(<linux/tls.h>)
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <linux/tls.h>
+#define HAS_KERNEL_TLS 1
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#endif
+
+// 將 TLS 連線的加密 (傳送方向) 交給核心 (kTLS)
+enum class KernelTlsStatus {
+    ENABLED,               // 之後寫入 socket 的明文由核心加密成 TLS record
+    KERNEL_UNSUPPORTED,    // 核心沒有 tls 模組 (或不是 Linux)
+    PROTOCOL_UNSUPPORTED,  // 只支援 TLS 1.3 的 AES-GCM 與 ChaCha20-Poly1305
+    FAILED,                // 其他錯誤 (例如沒有取得金鑰)
+};
+
+inline const char* kernel_tls_status_name(KernelTlsStatus status) {
+    switch (status) {
+        case KernelTlsStatus::ENABLED: return "enabled";
+        case KernelTlsStatus::KERNEL_UNSUPPORTED: return "kernel tls module not available";
+        case KernelTlsStatus::PROTOCOL_UNSUPPORTED: return "protocol or cipher not supported";
+        case KernelTlsStatus::FAILED: return "failed";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief kTLS：交握完成後把 TLS record 層的加密移到核心
+ *
+ * asio::ssl::stream 以記憶體 BIO 驅動 OpenSSL，OpenSSL 內建的 kTLS (只支援 socket BIO) 不會啟用，
+ * 因此自己完成切換：
+ *   1. install() 在 SSL_CTX 上登記 keylog 與 record 回呼，取得伺服器的應用資料 traffic secret，
+ *      並計算 secret 產生之後 OpenSSL 已經寫出的 record 數 (例如 NewSessionTicket)，作為核心的起始序號
+ *   2. 交握完成後 enable_tx() 以 HKDF-Expand-Label 推導金鑰與 IV，設定 TCP_ULP "tls" 與 TLS_TX
+ *   3. 之後直接把明文寫入 socket (可以是多個 buffer 的 writev)，由核心加密；關閉時以 send_close_notify() 送出警示
+ *
+ * 接收方向仍由 OpenSSL 在使用者空間解密。對端要求更新金鑰 (KeyUpdate) 時 OpenSSL 的回應會與核心的序號衝突，
+ * 連線會因此中斷 (一般客戶端不會在連線中更新金鑰)。
+ * 核心不支援時 enable_tx() 回傳 KERNEL_UNSUPPORTED，連線照常使用 OpenSSL 加密。
+ */
+class KernelTls {
+public:
+    // 在 SSL_CTX 上登記取得金鑰所需的回呼 (建立任何連線之前呼叫)
+    static void install(SSL_CTX* ctx) {
+        state_index();
+        SSL_CTX_set_keylog_callback(ctx, &on_keylog);
+        SSL_CTX_set_msg_callback(ctx, &on_record);
+    }
+
+    struct TrafficKeys {
+        std::vector<unsigned char> key;
+        std::vector<unsigned char> iv;
+    };
+
+    // 交給核心的傳送方向參數
+    struct TxParameters {
+        uint16_t cipher_id = 0;    // TLS 1.3 cipher suite (0x1301 / 0x1302 / 0x1303)
+        TrafficKeys keys;
+        uint64_t sequence = 0;     // 下一個 record 的序號
+    };
+
+    // 交握完成後取得傳送方向的金鑰、IV 與序號 (之後 OpenSSL 不能再寫出任何 record)
+    static KernelTlsStatus tx_parameters(SSL* ssl, TxParameters& out) {
+        if (SSL_version(ssl) != TLS1_3_VERSION) return KernelTlsStatus::PROTOCOL_UNSUPPORTED;
+        const SSL_CIPHER* cipher = SSL_get_current_cipher(ssl);
+        if (!cipher) return KernelTlsStatus::FAILED;
+        out.cipher_id = SSL_CIPHER_get_protocol_id(cipher);
+        std::size_t key_length = 0;
+        switch (out.cipher_id) {
+            case 0x1301: key_length = 16; break; // TLS_AES_128_GCM_SHA256
+            case 0x1302: key_length = 32; break; // TLS_AES_256_GCM_SHA384
+            case 0x1303: key_length = 32; break; // TLS_CHACHA20_POLY1305_SHA256
+            default: return KernelTlsStatus::PROTOCOL_UNSUPPORTED;
+        }
+        auto* state = static_cast<TxState*>(SSL_get_ex_data(ssl, state_index()));
+        if (!state || !state->secret_seen) return KernelTlsStatus::FAILED;
+        if (!derive_traffic_keys(SSL_CIPHER_get_handshake_digest(cipher), state->secret, key_length, out.keys)) {
+            return KernelTlsStatus::FAILED;
+        }
+        out.sequence = state->records;
+        return KernelTlsStatus::ENABLED;
+    }
+
+    // 交握完成後呼叫 (傳送方向改由核心加密)；失敗時連線維持原狀，可以繼續使用 OpenSSL
+    static KernelTlsStatus enable_tx(SSL* ssl, int fd) {
+#if defined(HAS_KERNEL_TLS)
+        if (kernel_unsupported().load(std::memory_order_relaxed)) return KernelTlsStatus::KERNEL_UNSUPPORTED;
+        TxParameters parameters;
+        const KernelTlsStatus status = tx_parameters(ssl, parameters);
+        if (status != KernelTlsStatus::ENABLED) return status;
+        const int result = install_tx(fd, parameters);
+        OPENSSL_cleanse(parameters.keys.key.data(), parameters.keys.key.size());
+        if (auto* state = static_cast<TxState*>(SSL_get_ex_data(ssl, state_index()))) {
+            OPENSSL_cleanse(state->secret.data(), state->secret.size());
+            state->secret.clear();
+        }
+        if (result == ENOENT || result == ENOPROTOOPT || result == EOPNOTSUPP) {
+            // 核心沒有 tls 模組：之後的連線不再嘗試
+            kernel_unsupported().store(true, std::memory_order_relaxed);
+            return KernelTlsStatus::KERNEL_UNSUPPORTED;
+        }
+        if (result != 0) return KernelTlsStatus::FAILED;
+        // 傳送方向已交給核心，不再需要計算 record
+        SSL_set_msg_callback(ssl, nullptr);
+        return KernelTlsStatus::ENABLED;
+#else
+        (void)ssl;
+        (void)fd;
+        return KernelTlsStatus::KERNEL_UNSUPPORTED;
+#endif
+    }
+
+    // 已啟用 kTLS 的連線以核心送出 close_notify 警示 (取代 SSL_shutdown)
+    static bool send_close_notify(int fd) {
+#if defined(HAS_KERNEL_TLS)
+        unsigned char alert[2] = {1, 0}; // warning, close_notify
+        unsigned char record_type = 21;  // alert
+        char control[CMSG_SPACE(sizeof(record_type))] = {};
+        iovec iov{alert, sizeof(alert)};
+        msghdr message{};
+        message.msg_iov = &iov;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        cmsghdr* header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_TLS;
+        header->cmsg_type = TLS_SET_RECORD_TYPE;
+        header->cmsg_len = CMSG_LEN(sizeof(record_type));
+        std::memcpy(CMSG_DATA(header), &record_type, sizeof(record_type));
+        return ::sendmsg(fd, &message, MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(alert));
+#else
+        (void)fd;
+        return false;
+#endif
+    }
+
+    // RFC 8446 7.3：由 traffic secret 推導 record 的金鑰與 IV (12 個位元組)
+    static bool derive_traffic_keys(const EVP_MD* digest, std::string_view secret, std::size_t key_length,
+                                    TrafficKeys& out) {
+        out.key.resize(key_length);
+        out.iv.resize(12);
+        return hkdf_expand_label(digest, secret, "key", out.key.data(), out.key.size()) &&
+               hkdf_expand_label(digest, secret, "iv", out.iv.data(), out.iv.size());
+    }
+
+    // RFC 8446 7.1：HKDF-Expand-Label(secret, label, "", length)
+    static bool hkdf_expand_label(const EVP_MD* digest, std::string_view secret, std::string_view label,
+                                  unsigned char* out, std::size_t length) {
+        std::string info;
+        const std::string full_label = "tls13 " + std::string(label);
+        info.push_back(static_cast<char>(length >> 8));
+        info.push_back(static_cast<char>(length & 0xFF));
+        info.push_back(static_cast<char>(full_label.size()));
+        info += full_label;
+        info.push_back(0); // context 長度 0
+
+        EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr);
+        if (!ctx) return false;
+        std::size_t out_length = length;
+        const bool ok =
+            EVP_PKEY_derive_init(ctx) > 0 &&
+            EVP_PKEY_CTX_hkdf_mode(ctx, EVP_PKEY_HKDEF_MODE_EXPAND_ONLY) > 0 &&
+            EVP_PKEY_CTX_set_hkdf_md(ctx, digest) > 0 &&
+            EVP_PKEY_CTX_set1_hkdf_key(ctx, reinterpret_cast<const unsigned char*>(secret.data()),
+                                       static_cast<int>(secret.size())) > 0 &&
+            EVP_PKEY_CTX_add1_hkdf_info(ctx, reinterpret_cast<const unsigned char*>(info.data()),
+                                        static_cast<int>(info.size())) > 0 &&
+            EVP_PKEY_derive(ctx, out, &out_length) > 0 && out_length == length;
+        EVP_PKEY_CTX_free(ctx);
+        return ok;
+    }
+
+private:
+    // 每條連線在交握期間收集的資料 (存放在 SSL 的 ex_data，SSL 釋放時一併釋放)
+    struct TxState {
+        std::string secret;        // 伺服器的應用資料 traffic secret
+        bool secret_seen = false;
+        uint64_t records = 0;      // secret 產生之後 OpenSSL 已寫出的 record 數 (核心的起始序號)
+    };
+
+#if defined(HAS_KERNEL_TLS)
+    // 設定 TCP_ULP "tls" 與 TLS_TX；回傳 0 或 errno
+    static int install_tx(int fd, const TxParameters& parameters) {
+        if (::setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) != 0) return errno;
+
+        // 核心的 nonce 為 salt (IV 的前 4 個位元組，ChaCha20 沒有) + iv (其餘位元組)，序號為大端序
+        unsigned char sequence[8];
+        for (int i = 0; i < 8; ++i) sequence[i] = static_cast<unsigned char>(parameters.sequence >> (8 * (7 - i)));
+        int result = -1;
+        if (parameters.cipher_id == 0x1303) {
+            tls12_crypto_info_chacha20_poly1305 info{};
+            fill(info, TLS_CIPHER_CHACHA20_POLY1305, parameters.keys, 0, sequence);
+            result = ::setsockopt(fd, SOL_TLS, TLS_TX, &info, sizeof(info));
+            OPENSSL_cleanse(&info, sizeof(info));
+        } else if (parameters.cipher_id == 0x1301) {
+            tls12_crypto_info_aes_gcm_128 info{};
+            fill(info, TLS_CIPHER_AES_GCM_128, parameters.keys, 4, sequence);
+            result = ::setsockopt(fd, SOL_TLS, TLS_TX, &info, sizeof(info));
+            OPENSSL_cleanse(&info, sizeof(info));
+        } else {
+            tls12_crypto_info_aes_gcm_256 info{};
+            fill(info, TLS_CIPHER_AES_GCM_256, parameters.keys, 4, sequence);
+            result = ::setsockopt(fd, SOL_TLS, TLS_TX, &info, sizeof(info));
+            OPENSSL_cleanse(&info, sizeof(info));
+        }
+        return result == 0 ? 0 : errno;
+    }
+
+    template <typename Info>
+    static void fill(Info& info, uint16_t cipher_type, const TrafficKeys& keys, std::size_t salt_length,
+                     const unsigned char (&sequence)[8]) {
+        info.info.version = TLS_1_3_VERSION;
+        info.info.cipher_type = cipher_type;
+        std::memcpy(info.key, keys.key.data(), sizeof(info.key));
+        std::memcpy(info.salt, keys.iv.data(), salt_length);
+        std::memcpy(info.iv, keys.iv.data() + salt_length, sizeof(info.iv));
+        std::memcpy(info.rec_seq, sequence, sizeof(info.rec_seq));
+    }
+#endif
+
+    static int state_index() {
+        static const int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr,
+            [](void*, void* ptr, CRYPTO_EX_DATA*, int, long, void*) {
+                auto* state = static_cast<TxState*>(ptr);
+                if (state) OPENSSL_cleanse(state->secret.data(), state->secret.size());
+                delete state;
+            });
+        return index;
+    }
+
+    static TxState* state_of(SSL* ssl) {
+        auto* state = static_cast<TxState*>(SSL_get_ex_data(ssl, state_index()));
+        if (!state) {
+            state = new TxState();
+            SSL_set_ex_data(ssl, state_index(), state);
+        }
+        return state;
+    }
+
+    // keylog 的格式為「標籤 client_random secret」(十六進位)
+    static void on_keylog(const SSL* ssl, const char* line) {
+        static constexpr std::string_view label = "SERVER_TRAFFIC_SECRET_0 ";
+        const std::string_view text(line);
+        if (text.substr(0, label.size()) != label) return;
+        const std::size_t space = text.find(' ', label.size());
+        if (space == std::string_view::npos) return;
+        const std::string_view hex = text.substr(space + 1);
+
+        TxState* state = state_of(const_cast<SSL*>(ssl));
+        state->secret.clear();
+        for (std::size_t i = 0; i + 1 < hex.size(); i += 2) {
+            state->secret.push_back(static_cast<char>((hex_value(hex[i]) << 4) | hex_value(hex[i + 1])));
+        }
+        state->secret_seen = true;
+        state->records = 0;
+    }
+
+    // OpenSSL 每寫出一個 record 會以 SSL3_RT_HEADER 呼叫一次
+    static void on_record(int write_p, int, int content_type, const void*, std::size_t, SSL* ssl, void*) {
+        if (!write_p || content_type != SSL3_RT_HEADER) return;
+        auto* state = static_cast<TxState*>(SSL_get_ex_data(ssl, state_index()));
+        if (state && state->secret_seen) ++state->records;
+    }
+
+    static int hex_value(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return 0;
+    }
+
+    static std::atomic<bool>& kernel_unsupported() {
+        static std::atomic<bool> unsupported{false};
+        return unsupported;
+    }
+};
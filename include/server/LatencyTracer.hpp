@@ -0,0 +1,255 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <spdlog/fmt/fmt.h>
+
+// 取樣訊框經過的時間點 (依發生順序)
+enum class FrameStamp : uint8_t {
+    READ_READY,     // socket 變成可讀 (開始讀取)
+    READ_DONE,      // 讀取完成 (TLS 已解密)
+    PARSED,         // 解析器取出這個訊框
+    DISPATCHED,     // 開始分派給指令的處理函式
+    ENQUEUED,       // 處理函式把回覆放入寫入佇列
+    WRITE_STARTED,  // 回覆所在的那一批開始寫出
+    WRITTEN,        // 寫入完成
+};
+
+inline constexpr std::size_t FRAME_STAMP_COUNT = 7;
+// 相鄰兩個時間點之間為一個階段
+inline constexpr std::size_t FRAME_STAGE_COUNT = FRAME_STAMP_COUNT - 1;
+
+// 階段 i 為 FrameStamp i 到 i + 1 之間
+inline const char* frame_stage_name(std::size_t stage) {
+    static constexpr const char* names[FRAME_STAGE_COUNT] = {
+        "tls_read", "parse", "dispatch", "handle", "queue", "write"};
+    return stage < FRAME_STAGE_COUNT ? names[stage] : "unknown";
+}
+
+// 一個取樣訊框的時間戳記 (steady_clock 奈秒；0 表示沒有經過這個時間點，例如沒有回覆的指令)
+struct FrameSample {
+    uint32_t connection_id = 0;
+    uint16_t command_id = 0;
+    uint32_t payload_size = 0;
+    std::array<int64_t, FRAME_STAMP_COUNT> stamps{};
+
+    void stamp(FrameStamp point) { stamps[static_cast<std::size_t>(point)] = now_ns(); }
+    bool has(FrameStamp point) const { return stamps[static_cast<std::size_t>(point)] != 0; }
+
+    // 階段的耗時；兩端任一沒有時間戳記時回傳 -1
+    int64_t stage_ns(std::size_t stage) const {
+        if (stamps[stage] == 0 || stamps[stage + 1] == 0) return -1;
+        return stamps[stage + 1] - stamps[stage];
+    }
+
+    static int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+/**
+ * @brief 取樣的逐訊框延遲追蹤
+ *
+ * 每 sample_interval 次讀取取樣一次，被取樣的讀取中第一個訊框會記錄讀取、解析、分派、
+ * 放入寫入佇列、開始寫出與寫入完成的時間點，用來判斷延遲是花在 TLS 解密、解析、排隊還是等待 socket 可寫。
+ * 沒有被取樣的讀取只多一次分支判斷。
+ *
+ * 完成的樣本寫入「記錄時所在執行緒」的環狀緩衝區 (單一寫入者、不需要鎖，滿了覆寫最舊的)；
+ * dump() 可隨時把所有緩衝區中的樣本輸出成 Chrome trace JSON (chrome://tracing 或 Perfetto 皆可開啟)。
+ */
+class LatencyTracer {
+public:
+    explicit LatencyTracer(uint32_t sample_interval, std::size_t ring_capacity = 4096)
+        : sample_interval_(sample_interval > 0 ? sample_interval : 1),
+          ring_capacity_(ring_capacity > 0 ? ring_capacity : 1),
+          id_(next_tracer_id().fetch_add(1, std::memory_order_relaxed)),
+          start_ns_(FrameSample::now_ns()) {}
+
+    LatencyTracer(const LatencyTracer&) = delete;
+    LatencyTracer& operator=(const LatencyTracer&) = delete;
+
+    // 這次讀取是否取樣 (每條執行緒各自倒數)
+    bool sample() {
+        thread_local uint32_t countdown = 0;
+        if (countdown != 0) {
+            --countdown;
+            return false;
+        }
+        countdown = sample_interval_ - 1;
+        return true;
+    }
+
+    // 為連線分配在追蹤檔中的 ID (第一次被取樣時才分配)
+    uint32_t next_connection_id() { return next_connection_id_.fetch_add(1, std::memory_order_relaxed); }
+
+    // 記錄一個完成的樣本 (任何執行緒皆可呼叫，寫入目前執行緒的緩衝區)
+    void record(const FrameSample& sample) {
+        local_ring().push(sample);
+        recorded_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t recorded() const { return recorded_.load(std::memory_order_relaxed); }
+
+    // 目前所有緩衝區中的樣本 (正在被覆寫的樣本會被略過)
+    std::vector<FrameSample> snapshot() const {
+        std::vector<FrameSample> samples;
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (const auto& ring : rings_) {
+            ring->collect(samples);
+        }
+        return samples;
+    }
+
+    // 輸出成 Chrome trace JSON；每條連線一個軌道，每個樣本是一個訊框事件加上各階段的子事件
+    // 回傳輸出的樣本數；無法開啟檔案時拋出例外
+    std::size_t dump(const std::string& path) const {
+        const std::vector<FrameSample> samples = snapshot();
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            throw std::runtime_error("Cannot open latency trace file " + path);
+        }
+        std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        bool first = true;
+        auto event = [&](const char* name, int64_t begin_ns, int64_t end_ns, const FrameSample& sample) {
+            if (!first) out += ",\n";
+            first = false;
+            out += fmt::format("{{\"name\":\"{}\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":{},"
+                               "\"ts\":{:.3f},\"dur\":{:.3f},\"args\":{{\"command\":{},\"payload\":{}}}}}",
+                               name, sample.connection_id, (begin_ns - start_ns_) / 1e3,
+                               (end_ns - begin_ns) / 1e3, sample.command_id, sample.payload_size);
+        };
+        for (const auto& sample : samples) {
+            // 整個訊框：從第一個到最後一個有記錄的時間點
+            int64_t begin = 0;
+            int64_t end = 0;
+            for (int64_t stamp : sample.stamps) {
+                if (stamp == 0) continue;
+                if (begin == 0) begin = stamp;
+                end = stamp;
+            }
+            if (begin == 0) continue;
+            event(fmt::format("frame {}", sample.command_id).c_str(), begin, end, sample);
+            for (std::size_t stage = 0; stage < FRAME_STAGE_COUNT; ++stage) {
+                if (sample.stage_ns(stage) >= 0) {
+                    event(frame_stage_name(stage), sample.stamps[stage], sample.stamps[stage + 1], sample);
+                }
+            }
+            if (out.size() >= 64 * 1024) {
+                std::fwrite(out.data(), 1, out.size(), file);
+                out.clear();
+            }
+        }
+        out += "\n]}\n";
+        std::fwrite(out.data(), 1, out.size(), file);
+        std::fclose(file);
+        return samples.size();
+    }
+
+private:
+    // 單一寫入者的環狀緩衝區；每個位置以序號 (seqlock) 讓 dump 偵測讀到一半被覆寫的樣本
+    class Ring {
+    public:
+        explicit Ring(std::size_t capacity) : slots_(capacity) {}
+
+        void push(const FrameSample& sample) {
+            const uint64_t index = head_.load(std::memory_order_relaxed);
+            Slot& slot = slots_[index % slots_.size()];
+            slot.sequence.store(2 * index + 1, std::memory_order_relaxed); // 寫入中
+            std::atomic_thread_fence(std::memory_order_release);
+            const auto words = pack(sample);
+            for (std::size_t i = 0; i < words.size(); ++i) {
+                slot.words[i].store(words[i], std::memory_order_relaxed);
+            }
+            slot.sequence.store(2 * index + 2, std::memory_order_release);
+            head_.store(index + 1, std::memory_order_release);
+        }
+
+        void collect(std::vector<FrameSample>& out) const {
+            const uint64_t head = head_.load(std::memory_order_acquire);
+            const uint64_t begin = head > slots_.size() ? head - slots_.size() : 0;
+            for (uint64_t index = begin; index < head; ++index) {
+                const Slot& slot = slots_[index % slots_.size()];
+                const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+                if (sequence != 2 * index + 2) continue; // 已被覆寫或正在寫入
+                std::array<uint64_t, word_count> words;
+                for (std::size_t i = 0; i < words.size(); ++i) {
+                    words[i] = slot.words[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) != sequence) continue;
+                out.push_back(unpack(words));
+            }
+        }
+
+    private:
+        static constexpr std::size_t word_count = 2 + FRAME_STAMP_COUNT;
+
+        static std::array<uint64_t, word_count> pack(const FrameSample& sample) {
+            std::array<uint64_t, word_count> words{};
+            words[0] = (static_cast<uint64_t>(sample.connection_id) << 32) | sample.payload_size;
+            words[1] = sample.command_id;
+            for (std::size_t i = 0; i < FRAME_STAMP_COUNT; ++i) {
+                words[2 + i] = static_cast<uint64_t>(sample.stamps[i]);
+            }
+            return words;
+        }
+
+        static FrameSample unpack(const std::array<uint64_t, word_count>& words) {
+            FrameSample sample;
+            sample.connection_id = static_cast<uint32_t>(words[0] >> 32);
+            sample.payload_size = static_cast<uint32_t>(words[0]);
+            sample.command_id = static_cast<uint16_t>(words[1]);
+            for (std::size_t i = 0; i < FRAME_STAMP_COUNT; ++i) {
+                sample.stamps[i] = static_cast<int64_t>(words[2 + i]);
+            }
+            return sample;
+        }
+
+        struct Slot {
+            std::atomic<uint64_t> sequence{0};
+            std::array<std::atomic<uint64_t>, word_count> words{};
+        };
+
+        std::vector<Slot> slots_;
+        std::atomic<uint64_t> head_{0};
+    };
+
+    // 目前執行緒在這個追蹤器中的緩衝區 (第一次記錄時建立並登記)
+    Ring& local_ring() {
+        struct Local {
+            uint64_t tracer_id = 0;
+            std::shared_ptr<Ring> ring;
+        };
+        thread_local Local local;
+        if (local.tracer_id != id_) {
+            local.ring = std::make_shared<Ring>(ring_capacity_);
+            local.tracer_id = id_;
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            rings_.push_back(local.ring);
+        }
+        return *local.ring;
+    }
+
+    static std::atomic<uint64_t>& next_tracer_id() {
+        static std::atomic<uint64_t> id{1};
+        return id;
+    }
+
+    const uint32_t sample_interval_;
+    const std::size_t ring_capacity_;
+    const uint64_t id_;
+    const int64_t start_ns_;
+    std::atomic<uint32_t> next_connection_id_{1};
+    std::atomic<uint64_t> recorded_{0};
+    mutable std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+};
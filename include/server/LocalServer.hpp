@@ -0,0 +1,124 @@
+#pragma once
+
+#include "utils/Logger.hpp"
+#include "server/Session.hpp"
+#include "server/SessionStream.hpp"
+#include "server/IoContextPool.hpp"
+#include "server/SessionServices.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <system_error>
+#include <stdexcept>
+#include <asio.hpp>
+
+#if defined(ASIO_HAS_LOCAL_SOCKETS) && !defined(_WIN32)
+#include <sys/stat.h>
+
+/**
+ * @brief 本機 sidecar 使用的 Unix domain socket 監聽
+ *
+ * 與 Server 說同樣的訊框協定、建立同樣的 Session，但不經過 TCP 與 TLS：
+ * 能連線的行程由 socket 檔案的權限決定，接受連線時再以 SO_PEERCRED 取得對端的 uid，
+ * 設定了允許清單時拒絕清單以外的 uid。
+ */
+class LocalServer {
+public:
+    LocalServer(IoContextPool& session_pool, std::shared_ptr<const SessionServices> services)
+        : session_pool_(session_pool),
+          acceptor_(session_pool.primary_context()),
+          services_(std::move(services)),
+          config_(services_->config),
+          path_(config_.unix_socket_path),
+          logger_(services_->logger) {
+        remove_stale_socket();
+        using asio::local::stream_protocol;
+        acceptor_.open(stream_protocol());
+        acceptor_.bind(stream_protocol::endpoint(path_));
+        // 開始監聽前先設定權限，權限以外的使用者無法連線
+        if (::chmod(path_.c_str(), static_cast<mode_t>(config_.unix_socket_mode)) != 0) {
+            throw std::system_error(errno, std::generic_category(), "chmod " + path_);
+        }
+        acceptor_.listen();
+        logger_->info("Listening on unix socket {} (mode {:o}{})", path_, config_.unix_socket_mode,
+                      config_.unix_allowed_uids.empty()
+                          ? std::string()
+                          : fmt::format(", allowed uids {}", fmt::join(config_.unix_allowed_uids, ",")));
+        do_accept();
+    }
+
+    LocalServer(const LocalServer&) = delete;
+    LocalServer& operator=(const LocalServer&) = delete;
+
+    // 停止監聽並刪除 socket 檔案 (已建立的連線不受影響)
+    ~LocalServer() {
+        asio::error_code ec;
+        acceptor_.close(ec);
+        std::error_code remove_ec;
+        std::filesystem::remove(path_, remove_ec);
+    }
+
+private:
+    // 上次沒有正常結束時留下的 socket 檔案會讓 bind 失敗；不是 socket 的檔案則不動它
+    void remove_stale_socket() {
+        std::error_code ec;
+        const auto status = std::filesystem::symlink_status(path_, ec);
+        if (ec || !std::filesystem::exists(status)) return;
+        if (status.type() != std::filesystem::file_type::socket) {
+            throw std::runtime_error("Unix socket path exists and is not a socket: " + path_);
+        }
+        std::filesystem::remove(path_, ec);
+    }
+
+    void do_accept() {
+        acceptor_.async_accept(session_pool_.next_context(),
+            [this](const asio::error_code& ec, asio::local::stream_protocol::socket socket) {
+                if (ec == asio::error::operation_aborted) return; // 監聽已關閉
+                if (!ec) {
+                    const PeerCredentials credentials = read_peer_credentials(socket);
+                    if (!allowed(credentials)) {
+                        logger_->warn("Rejected unix socket connection from pid {} uid {}",
+                                      credentials.pid, credentials.uid);
+                        services_->metrics->local_rejected.fetch_add(1, std::memory_order_relaxed);
+                    } else {
+                        logger_->info("Accepted unix socket connection from pid {} uid {}",
+                                      credentials.pid, credentials.uid);
+                        services_->metrics->local_accepted.fetch_add(1, std::memory_order_relaxed);
+                        // 與 Server 相同：在 socket 所屬的執行緒上建立 Session
+                        auto executor = socket.get_executor();
+                        asio::post(executor, [this, socket = std::move(socket), credentials]() mutable {
+                            std::make_shared<Session>(SessionStream(std::move(socket), credentials), services_)->start();
+                        });
+                    }
+                } else {
+                    logger_->error("Unix socket accept failed: {}", ec.message());
+                }
+                do_accept();
+            });
+    }
+
+    bool allowed(const PeerCredentials& credentials) const {
+        const auto& uids = config_.unix_allowed_uids;
+        if (uids.empty()) return true;
+        return credentials.known() && std::find(uids.begin(), uids.end(), credentials.uid) != uids.end();
+    }
+
+    IoContextPool& session_pool_;
+    asio::local::stream_protocol::acceptor acceptor_;
+    std::shared_ptr<const SessionServices> services_;
+    const ServerConfig& config_;
+    std::string path_;
+    std::shared_ptr<spdlog::logger> logger_;
+};
+
+#else
+
+// 不支援 Unix domain socket (或 SO_PEERCRED) 的平台：設定了 --unix-socket 時啟動失敗
+class LocalServer {
+public:
+    LocalServer(IoContextPool&, std::shared_ptr<const SessionServices>) {
+        throw std::runtime_error("Unix domain socket listener is not supported on this platform");
+    }
+};
+
+#endif
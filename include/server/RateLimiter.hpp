@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+
+// 令牌桶，以 GCRA (generic cell rate algorithm) 實作
+//
+// 整個狀態只有一個「理論抵達時間」(theoretical arrival time)：每消耗一個令牌就往後推 1/rate 秒，
+// 它超前現在的時間不能超過 burst (也就是最多可以突發 rate * burst 個令牌)。
+// 因此只需要一個原子變數與 CAS，不需要鎖；同一個桶可以由多條執行緒共用 (例如同一個來源 IP 的所有連線)。
+class TokenBucket {
+public:
+    // 未設定速率的桶不做任何限制
+    TokenBucket() = default;
+    TokenBucket(const TokenBucket&) = delete;
+    TokenBucket& operator=(const TokenBucket&) = delete;
+
+    // rate_per_s：每秒補充的令牌數 (0 表示不限制)；burst：可以累積的突發時間
+    void configure(double rate_per_s, std::chrono::nanoseconds burst) {
+        interval_ns_ = rate_per_s > 0 ? 1e9 / rate_per_s : 0;
+        tolerance_ns_ = burst.count();
+        tat_.store(0, std::memory_order_relaxed);
+    }
+
+    bool enabled() const { return interval_ns_ > 0; }
+
+    // 扣除 cost 個令牌。已經讀進來的資料無法退回，所以一律扣除 (可以透支)，
+    // 回傳還需要等待多久才會回到限制內；0 表示仍在限制內
+    std::chrono::nanoseconds consume(double cost, int64_t now_ns) {
+        if (!enabled()) return std::chrono::nanoseconds(0);
+        const auto increment = static_cast<int64_t>(cost * interval_ns_);
+        int64_t tat = tat_.load(std::memory_order_relaxed);
+        int64_t next = 0;
+        do {
+            next = std::max(tat, now_ns) + increment;
+        } while (!tat_.compare_exchange_weak(tat, next, std::memory_order_relaxed));
+        return std::chrono::nanoseconds(std::max<int64_t>(0, next - tolerance_ns_ - now_ns));
+    }
+
+private:
+    double interval_ns_ = 0;            // 補充一個令牌所需的時間
+    int64_t tolerance_ns_ = 0;          // 允許的突發時間
+    std::atomic<int64_t> tat_{0};       // 理論抵達時間 (steady_clock 奈秒)
+};
+
+// 速率限制的設定 (0 表示不限制)
+struct RateLimitConfig {
+    double session_frames_per_s = 0;   // 每條連線每秒的訊框數
+    double session_bytes_per_s = 0;    // 每條連線每秒的位元組數
+    double source_frames_per_s = 0;    // 每個來源 IP (所有連線合計) 每秒的訊框數
+    double source_bytes_per_s = 0;     // 每個來源 IP 每秒的位元組數
+    unsigned burst_ms = 1000;          // 允許的突發量，以「幾毫秒的額度」表示
+
+    bool session_enabled() const { return session_frames_per_s > 0 || session_bytes_per_s > 0; }
+    bool source_enabled() const { return source_frames_per_s > 0 || source_bytes_per_s > 0; }
+    std::chrono::nanoseconds burst() const { return std::chrono::milliseconds(burst_ms); }
+};
+
+// 同一個來源 IP 的所有連線共用的令牌桶
+struct SourceBuckets {
+    TokenBucket frames;
+    TokenBucket bytes;
+};
+
+// 來源 IP -> 共用令牌桶 的對照表
+// 只在連線建立時查詢一次 (需要鎖)；之後每次檢查只碰原子變數。最後一條連線關閉後桶會被回收
+class SourceRateLimits {
+public:
+    explicit SourceRateLimits(const RateLimitConfig& config) : config_(config) {}
+
+    std::shared_ptr<SourceBuckets> acquire(const std::string& address) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& entry = buckets_[address];
+        if (auto existing = entry.lock()) return existing;
+
+        auto buckets = std::make_shared<SourceBuckets>();
+        buckets->frames.configure(config_.source_frames_per_s, config_.burst());
+        buckets->bytes.configure(config_.source_bytes_per_s, config_.burst());
+        entry = buckets;
+
+        // 表的大小翻倍時清掉已經沒有連線的來源
+        if (buckets_.size() >= sweep_threshold_) {
+            for (auto it = buckets_.begin(); it != buckets_.end();) {
+                it = it->second.expired() ? buckets_.erase(it) : std::next(it);
+            }
+            sweep_threshold_ = std::max<std::size_t>(1024, buckets_.size() * 2);
+        }
+        return buckets;
+    }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return buckets_.size();
+    }
+
+private:
+    RateLimitConfig config_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::weak_ptr<SourceBuckets>> buckets_;
+    std::size_t sweep_threshold_ = 1024;
+};
+
+// 單一 Session 的速率限制器 (只在 Session 的 strand 中使用)
+// 連線自己的桶是 Session 的成員，來源 IP 的桶與同一來源的其他連線共用
+class RateLimiter {
+public:
+    struct Verdict {
+        std::chrono::nanoseconds wait{0};  // 需要暫停讀取的時間
+        bool by_source = false;            // 是否是來源 IP 的限制造成的
+    };
+
+    void configure(const RateLimitConfig& config, std::shared_ptr<SourceBuckets> source) {
+        frames_.configure(config.session_frames_per_s, config.burst());
+        bytes_.configure(config.session_bytes_per_s, config.burst());
+        source_ = std::move(source);
+        enabled_ = frames_.enabled() || bytes_.enabled() || source_;
+    }
+
+    bool enabled() const { return enabled_; }
+
+    // 一次讀取處理完後扣除這次讀到的訊框數與位元組數
+    Verdict charge(uint64_t frames, uint64_t bytes) {
+        const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        Verdict verdict;
+        verdict.wait = std::max(frames_.consume(static_cast<double>(frames), now),
+                                bytes_.consume(static_cast<double>(bytes), now));
+        if (source_) {
+            const auto source_wait = std::max(source_->frames.consume(static_cast<double>(frames), now),
+                                              source_->bytes.consume(static_cast<double>(bytes), now));
+            if (source_wait > verdict.wait) {
+                verdict.wait = source_wait;
+                verdict.by_source = true;
+            }
+        }
+        return verdict;
+    }
+
+private:
+    TokenBucket frames_;
+    TokenBucket bytes_;
+    std::shared_ptr<SourceBuckets> source_;
+    bool enabled_ = false;
+};
@@ -2,6 +2,8 @@
 
 #include "utils/Logger.hpp"
 #include "server/Session.hpp"
+#include "server/IoContextPool.hpp"
+#include "server/SessionServices.hpp"
 #include <asio.hpp>
 #include <asio/ssl.hpp>
 
@@ -9,35 +11,71 @@ using asio::ip::tcp;
 
 class Server {
 public:
-    Server(asio::io_context& io_context, short port, asio::ssl::context& ssl_context, std::shared_ptr<spdlog::logger> logger)
-        : acceptor_(io_context, tcp::endpoint(tcp::v4(), port)),
+    // session_pool：Session 所屬的 io_context 由此 pool 輪詢分配
+    // services：所有 Session 共用的服務與設定
+    Server(IoContextPool& session_pool, short port, asio::ssl::context& ssl_context,
+           std::shared_ptr<const SessionServices> services)
+        : session_pool_(session_pool),
+        acceptor_(session_pool.primary_context(), tcp::endpoint(tcp::v4(), port)),
         ssl_context_(ssl_context),
-        logger_(logger) {
+        services_(std::move(services)),
+        config_(services_->config),
+        logger_(services_->logger) {
         do_accept();
     }
 
 private:
     void do_accept() {
-        // 接受連線， socket 會被包裝在 ssl_stream 中
-        acceptor_.async_accept(
+        // 接受連線，新的 socket 直接建立在輪詢選出的 io_context 上
+        acceptor_.async_accept(session_pool_.next_context(),
             [this](const asio::error_code& ec, tcp::socket socket) { // 接收一個原始的 tcp::socket
                 if (!ec) {
                 // 在此處記錄完整的客戶端端點資訊
                 logger_->info("Accepted connection from: {}:{}", 
                                             socket.remote_endpoint().address().to_string(), socket.remote_endpoint().port());
-                    // 建立一個 Session 物件來處理這個連線
-                    // 將 socket 和 ssl_context 傳遞給 Session
-                    std::make_shared<Session>(
-                        asio::ssl::stream<tcp::socket>(std::move(socket), ssl_context_), 
-                        logger_
-                    )->start();
+                    if (config_.busy_poll_us > 0) {
+                        apply_low_latency_options(socket);
+                    }
+                    // 在 socket 所屬的執行緒上建立 Session，
+                    // 讓 Session 與 SSL 物件的記憶體由該執行緒首次觸碰 (first-touch)，配置在本地 NUMA 節點
+                    auto executor = socket.get_executor();
+                    asio::post(executor, [this, socket = std::move(socket)]() mutable {
+                        // 建立一個 Session 物件來處理這個連線
+                        // 將 socket 和 ssl_context 傳遞給 Session
+                        std::make_shared<Session>(
+                            SessionStream(asio::ssl::stream<tcp::socket>(std::move(socket), ssl_context_)),
+                            services_
+                        )->start();
+                    });
                 }
                 // 繼續等待下一個連線
                 do_accept();
             });
     }
 
+    // busy-poll 模式下的 socket 選項：
+    // - TCP_NODELAY：小封包立即送出，不等待 Nagle 合併
+    // - SO_BUSY_POLL：接收時讓核心在驅動佇列上忙碌輪詢，減少中斷與喚醒延遲 (Linux)
+    void apply_low_latency_options(tcp::socket& socket) {
+        asio::error_code ec;
+        socket.set_option(tcp::no_delay(true), ec);
+        if (ec) {
+            logger_->warn("Failed to set TCP_NODELAY: {}", ec.message());
+        }
+#if defined(SO_BUSY_POLL)
+        using busy_poll_option = asio::detail::socket_option::integer<SOL_SOCKET, SO_BUSY_POLL>;
+        socket.set_option(busy_poll_option(static_cast<int>(config_.busy_poll_us)), ec);
+        if (ec) {
+            // 一般使用者設定的值超過 net.core.busy_poll 上限時需要 CAP_NET_ADMIN
+            logger_->warn("Failed to set SO_BUSY_POLL: {}", ec.message());
+        }
+#endif
+    }
+
+    IoContextPool& session_pool_;
     tcp::acceptor acceptor_;
     asio::ssl::context& ssl_context_;
+    std::shared_ptr<const SessionServices> services_;
+    const ServerConfig& config_;
     std::shared_ptr<spdlog::logger> logger_;
-};
\ No newline at end of file
+};
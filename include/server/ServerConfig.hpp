@@ -0,0 +1,95 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <algorithm>
+#include "utils/CpuAffinity.hpp"
+#include "server/RateLimiter.hpp"
+
+// 伺服器的可調整選項，預設值即為原本的行為
+struct ServerConfig {
+    // 監聽的 TCP 埠
+    unsigned short port = 12345;
+
+    // 聯邦中其他節點的位址 (HOST:PORT)；空表示單節點
+    std::vector<std::string> peers;
+
+    // token 認證的金鑰檔 (每行「key_id secret」)；空字串表示不需要認證
+    // 啟用時，連線在送出 CMD_AUTH_REQUEST 並通過驗證之前只能送出認證訊框
+    std::string auth_keys_file;
+    std::size_t auth_cache_capacity = 65536;   // 已驗證 token 快取的容量
+
+    // io 執行緒要綁定的 CPU，第 i 條執行緒綁定到 io_cpus[i % size]；空表示不綁定
+    std::vector<int> io_cpus;
+
+    // 每條 io 執行緒擁有獨立的 io_context，Session 直接在所屬執行緒上建立，
+    // 讓 Session 的記憶體依 first-touch 政策配置在該執行緒的本地 NUMA 節點上，
+    // 且 Session 之後不會在執行緒 (以及 NUMA 節點) 之間遷移
+    bool numa_local = false;
+
+    // TLS 交握專用的執行緒數；0 表示交握直接在 io 執行緒上進行
+    std::size_t handshake_threads = 0;
+    // 交握執行緒可使用的 CPU 集合 (保留給交握，io 執行緒會避開)
+    std::vector<int> handshake_cpus;
+
+    // 耗用 CPU 的指令 (見 HeavyCommands.hpp) 使用的工作執行緒數；0 表示直接在 io 執行緒上處理
+    std::size_t worker_threads = 0;
+    // 工作執行緒可使用的 CPU 集合 (保留給工作執行緒，io 執行緒會避開)
+    std::vector<int> worker_cpus;
+
+    // 非同步日誌執行緒可使用的 CPU 集合 (保留給日誌，io 執行緒會避開)
+    std::vector<int> logger_cpus;
+
+    // busy-poll 低延遲模式：io 執行緒閒置時先空轉輪詢這麼多微秒才阻塞；0 表示停用
+    // 啟用時，新連線會設定 TCP_NODELAY 與 SO_BUSY_POLL (同樣的微秒數)
+    unsigned busy_poll_us = 0;
+
+    // 定期將統計數據寫入日誌的間隔 (秒)；0 表示只在伺服器停止時報告
+    unsigned metrics_interval_s = 0;
+
+    // 已發布訊息的持久化日誌目錄；空字串表示停用
+    std::string message_log_dir;
+    std::size_t message_log_segment_mb = 64;   // 每個區段檔案的大小 (MB)
+    std::size_t message_log_max_segments = 0;  // 保留的區段數上限，0 表示不限制
+
+    // 流量軌跡檔：每個收到的訊框記錄時間、連線、指令與大小，供 client-app 重播；空字串表示停用
+    std::string trace_file;
+
+    // 每條連線與每個來源 IP 的令牌桶速率限制 (訊框數/秒、位元組數/秒)；預設不限制
+    // 超過限制的客戶端會被暫停讀取 (由 TCP 流量控制把壓力推回客戶端)，而不是斷線
+    RateLimitConfig rate_limit;
+
+    // 逐訊框延遲取樣：每 N 次讀取取樣一個訊框，各階段的耗時列入統計數據；0 表示停用
+    // 有設定 latency_trace_file 時，停止 (或收到 SIGUSR1) 時將樣本輸出成 Chrome trace JSON
+    unsigned latency_sample_interval = 0;
+    std::string latency_trace_file;
+
+    // 額外的 Unix domain socket 監聽路徑 (同一台主機上的 sidecar 使用，不經過 TLS)；空字串表示停用
+    // 信任來自 socket 檔案的權限 (unix_socket_mode) 與對端的 SO_PEERCRED：
+    // unix_allowed_uids 非空時只接受這些 uid 的行程；啟用 token 認證時，本機連線以 uid 作為認證的身分
+    std::string unix_socket_path;
+    unsigned unix_socket_mode = 0660;
+    std::vector<long> unix_allowed_uids;
+
+    // TLS 1.3 連線在交握後把寫入方向的加密交給核心 (kTLS)，寫出時不再經過 OpenSSL 的加密與複製
+    // 核心不支援 (沒有 tls 模組) 或協商的加密套件不支援時，連線自動維持 user-space TLS
+    bool ktls = false;
+
+    // 若有保留 CPU 給交握、工作執行緒或日誌、但沒有指定 io_cpus，
+    // 就把剩下的 CPU 分配給 io 執行緒，避免互相搶佔
+    std::vector<int> resolve_io_cpus() const {
+        if (!io_cpus.empty() || (handshake_cpus.empty() && worker_cpus.empty() && logger_cpus.empty())) {
+            return io_cpus;
+        }
+        std::vector<int> cpus;
+        for (int cpu : available_cpus()) {
+            const bool reserved =
+                std::find(handshake_cpus.begin(), handshake_cpus.end(), cpu) != handshake_cpus.end() ||
+                std::find(worker_cpus.begin(), worker_cpus.end(), cpu) != worker_cpus.end() ||
+                std::find(logger_cpus.begin(), logger_cpus.end(), cpu) != logger_cpus.end();
+            if (!reserved) cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+};
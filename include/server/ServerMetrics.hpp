@@ -0,0 +1,151 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <spdlog/fmt/fmt.h>
+#include "utils/LatencyHistogram.hpp"
+#include "server/WriteScheduler.hpp"
+#include "server/LatencyTracer.hpp"
+
+// 伺服器層級的統計數據，所有欄位皆為原子變數，可由任何執行緒更新
+// 熱路徑上的計數應先在執行緒內累積，再批次寫入，避免快取行 (cache line) 爭用
+struct ServerMetrics {
+    // --- busy-poll ---
+    std::atomic<uint64_t> busy_poll_spin_ns{0};   // 空轉輪詢 (poll 沒有取得任何 handler) 花費的時間
+    std::atomic<uint64_t> busy_poll_hits{0};      // 在空轉期間取得工作的次數 (省下一次阻塞喚醒)
+    std::atomic<uint64_t> busy_poll_blocks{0};    // 空轉超時後改為阻塞等待的次數
+
+    // --- 寫入排程 ---
+    std::atomic<uint64_t> write_batches{0};       // 發出的寫入次數 (合併後)
+    std::atomic<uint64_t> write_packets{0};       // 寫出的封包數
+    std::array<LatencyHistogram, PRIORITY_CLASS_COUNT> write_queue_delay; // 各優先等級的排隊時間
+
+    // --- 批次 ---
+    std::atomic<uint64_t> batch_frames{0};        // 收到的批次訊框 (CMD_BATCH) 數
+    std::atomic<uint64_t> batch_messages{0};      // 批次中的子訊息總數
+
+    // --- 主題與聯邦 ---
+    std::atomic<uint64_t> published{0};           // 本節點客戶端發布的訊息數
+    std::atomic<uint64_t> delivered{0};           // 送給本地訂閱者的訊息份數
+    std::atomic<uint64_t> forwarded_out{0};       // 轉送給其他節點的訊息數
+    std::atomic<uint64_t> forward_batches{0};     // 轉送時使用的批次 (CMD_PEER_FORWARD) 數
+    std::atomic<uint64_t> forward_dropped{0};     // 連線中斷或佇列已滿而未能轉送的訊息數
+    std::atomic<uint64_t> forwarded_in{0};        // 從其他節點收到的訊息數
+
+    // --- 認證 ---
+    std::atomic<uint64_t> auth_succeeded{0};      // 認證成功次數
+    std::atomic<uint64_t> auth_failed{0};         // 認證失敗次數 (含未認證就送出其他指令)
+    std::atomic<uint64_t> auth_cache_hits{0};     // 命中已驗證 token 快取、不需重算 HMAC 的次數
+
+    // --- 速率限制 ---
+    std::atomic<uint64_t> throttled_session{0};   // 因連線本身的限制而暫停讀取的次數
+    std::atomic<uint64_t> throttled_source{0};    // 因來源 IP 的限制而暫停讀取的次數
+    std::atomic<uint64_t> throttled_ns{0};        // 暫停讀取的總時間
+
+    // --- Unix domain socket ---
+    std::atomic<uint64_t> local_accepted{0};      // 接受的本機連線數
+    std::atomic<uint64_t> local_rejected{0};      // 對端 uid 不在允許清單中而拒絕的連線數
+
+    // --- 工作執行緒 (耗用 CPU 的指令) ---
+    std::atomic<uint64_t> worker_jobs{0};         // 交給工作執行緒的請求數
+    std::atomic<uint64_t> worker_inline{0};       // 直接在 io 執行緒上處理的請求數 (沒有工作執行緒)
+    std::atomic<uint64_t> worker_read_pauses{0};  // 連線的待處理請求達到上限而暫停讀取的次數
+
+    // --- kTLS ---
+    std::atomic<uint64_t> ktls_enabled{0};        // 寫入方向交給核心加密的連線數
+    std::atomic<uint64_t> ktls_fallback{0};       // 無法交給核心、維持 user-space TLS 的連線數
+
+    // --- 逐訊框延遲取樣 ---
+    std::array<LatencyHistogram, FRAME_STAGE_COUNT> frame_stage_latency; // 取樣訊框在各階段的耗時
+
+    // 產生一行摘要，供定期報告與停止時寫入日誌
+    std::string report() const {
+        std::string out;
+        const uint64_t hits = busy_poll_hits.load(std::memory_order_relaxed);
+        const uint64_t blocks = busy_poll_blocks.load(std::memory_order_relaxed);
+        const uint64_t spin_ns = busy_poll_spin_ns.load(std::memory_order_relaxed);
+        if (hits + blocks > 0) {
+            // 每省下一次喚醒所付出的空轉 CPU 時間，用來評估延遲與 CPU 的取捨
+            out += fmt::format("busy-poll: spun {:.1f} ms, {} wakeups avoided, {} blocking waits, {:.2f} us spin per avoided wakeup",
+                               spin_ns / 1e6, hits, blocks, hits ? spin_ns / 1e3 / hits : 0.0);
+        }
+        const uint64_t batches = write_batches.load(std::memory_order_relaxed);
+        if (batches > 0) {
+            append(out, fmt::format("writes: {} packets in {} batches ({:.2f} per write)",
+                                    write_packets.load(std::memory_order_relaxed), batches,
+                                    static_cast<double>(write_packets.load(std::memory_order_relaxed)) / batches));
+        }
+        const uint64_t batch_count = batch_frames.load(std::memory_order_relaxed);
+        if (batch_count > 0) {
+            const uint64_t messages = batch_messages.load(std::memory_order_relaxed);
+            append(out, fmt::format("batches: {} frames carrying {} messages ({:.2f} per frame)",
+                                    batch_count, messages, static_cast<double>(messages) / batch_count));
+        }
+        const uint64_t published_count = published.load(std::memory_order_relaxed);
+        const uint64_t forwarded_in_count = forwarded_in.load(std::memory_order_relaxed);
+        if (published_count + forwarded_in_count > 0) {
+            append(out, fmt::format("topics: {} published, {} delivered locally", published_count,
+                                    delivered.load(std::memory_order_relaxed)));
+        }
+        const uint64_t forward_batch_count = forward_batches.load(std::memory_order_relaxed);
+        if (forward_batch_count + forwarded_in_count > 0) {
+            const uint64_t out_count = forwarded_out.load(std::memory_order_relaxed);
+            append(out, fmt::format("federation: {} forwarded in {} batches ({:.2f} per batch), {} received, {} dropped",
+                                    out_count, forward_batch_count,
+                                    forward_batch_count ? static_cast<double>(out_count) / forward_batch_count : 0.0,
+                                    forwarded_in_count, forward_dropped.load(std::memory_order_relaxed)));
+        }
+        const uint64_t auth_ok = auth_succeeded.load(std::memory_order_relaxed);
+        const uint64_t auth_bad = auth_failed.load(std::memory_order_relaxed);
+        if (auth_ok + auth_bad > 0) {
+            append(out, fmt::format("auth: {} succeeded ({} from cache), {} failed", auth_ok,
+                                    auth_cache_hits.load(std::memory_order_relaxed), auth_bad));
+        }
+        const uint64_t throttled_by_session = throttled_session.load(std::memory_order_relaxed);
+        const uint64_t throttled_by_source = throttled_source.load(std::memory_order_relaxed);
+        if (throttled_by_session + throttled_by_source > 0) {
+            append(out, fmt::format("rate limit: {} read pauses ({} per connection, {} per source IP), {:.1f} ms paused",
+                                    throttled_by_session + throttled_by_source, throttled_by_session,
+                                    throttled_by_source, throttled_ns.load(std::memory_order_relaxed) / 1e6));
+        }
+        const uint64_t local_ok = local_accepted.load(std::memory_order_relaxed);
+        const uint64_t local_bad = local_rejected.load(std::memory_order_relaxed);
+        if (local_ok + local_bad > 0) {
+            append(out, fmt::format("unix socket: {} accepted, {} rejected by peer credentials", local_ok, local_bad));
+        }
+        const uint64_t jobs = worker_jobs.load(std::memory_order_relaxed);
+        const uint64_t jobs_inline = worker_inline.load(std::memory_order_relaxed);
+        if (jobs + jobs_inline > 0) {
+            append(out, fmt::format("heavy commands: {} on worker threads, {} inline, {} read pauses at the pending limit",
+                                    jobs, jobs_inline, worker_read_pauses.load(std::memory_order_relaxed)));
+        }
+        const uint64_t ktls_ok = ktls_enabled.load(std::memory_order_relaxed);
+        const uint64_t ktls_bad = ktls_fallback.load(std::memory_order_relaxed);
+        if (ktls_ok + ktls_bad > 0) {
+            append(out, fmt::format("ktls: {} connections offloaded, {} fell back to user-space TLS", ktls_ok, ktls_bad));
+        }
+        for (std::size_t cls = 0; cls < PRIORITY_CLASS_COUNT; ++cls) {
+            const auto& histogram = write_queue_delay[cls];
+            if (histogram.count() == 0) continue;
+            append(out, fmt::format("queue delay [{}]: n={} p50={:.1f}us p99={:.1f}us max={:.1f}us",
+                                    priority_class_name(static_cast<PriorityClass>(cls)), histogram.count(),
+                                    histogram.percentile(50) / 1e3, histogram.percentile(99) / 1e3,
+                                    histogram.max() / 1e3));
+        }
+        for (std::size_t stage = 0; stage < FRAME_STAGE_COUNT; ++stage) {
+            const auto& histogram = frame_stage_latency[stage];
+            if (histogram.count() == 0) continue;
+            append(out, fmt::format("frame stage [{}]: n={} p50={:.1f}us p99={:.1f}us max={:.1f}us",
+                                    frame_stage_name(stage), histogram.count(), histogram.percentile(50) / 1e3,
+                                    histogram.percentile(99) / 1e3, histogram.max() / 1e3));
+        }
+        return out;
+    }
+
+private:
+    static void append(std::string& out, const std::string& part) {
+        if (!out.empty()) out += "; ";
+        out += part;
+    }
+};
@@ -1,8 +1,13 @@
 #pragma once
 
 #include "Server.hpp"
+#include "LocalServer.hpp"
+#include "KernelTls.hpp"
 #include "utils/Logger.hpp"
+#include "utils/IoBackend.hpp"
 #include "Session.hpp" 
+#include "ServerConfig.hpp"
+#include "IoContextPool.hpp"
 
 #include <iostream>
 #include <vector>
@@ -14,13 +19,25 @@
 class ServerRunner {
 
 public:
-    ServerRunner(short port, std::size_t thread_count, std::shared_ptr<spdlog::logger> logger)
+    ServerRunner(short port, std::size_t thread_count, std::shared_ptr<spdlog::logger> logger, ServerConfig config = {})
         : port_(port),
           thread_count_(thread_count),
-          io_context_(), // io_context 必須在 ssl_context 之前初始化
+          config_(std::move(config)),
+          // io_context pool 必須在 ssl_context 與 server 之前初始化
+          // numa_local 模式下每條 io 執行緒擁有自己的 io_context
+          io_pool_("io", config_.numa_local ? thread_count_ : 1, logger),
+          handshake_pool_(config_.handshake_threads > 0
+                              ? std::make_unique<IoContextPool>("handshake", 1, logger)
+                              : nullptr),
+          worker_pool_(config_.worker_threads > 0
+                           ? std::make_unique<IoContextPool>("worker", 1, logger)
+                           : nullptr),
           ssl_context_(asio::ssl::context::tls_server),
-          server_(io_context_, port_, ssl_context_, logger), 
-          work_guard_(asio::make_work_guard(io_context_)),
+          metrics_(std::make_shared<ServerMetrics>()),
+          services_(make_services(logger)),
+          server_(io_pool_, port_, ssl_context_, services_), 
+          local_server_(make_local_server()),
+          metrics_timer_(io_pool_.primary_context()),
           logger_(logger) // 儲存 logger
     {
         try {
@@ -38,6 +55,15 @@ public:
             ssl_context_.use_certificate_chain_file("certs/server.crt");
             ssl_context_.use_private_key_file("certs/server.key", asio::ssl::context::pem);
             ssl_context_.use_tmp_dh_file("certs/dhparam.pem");
+
+            // 連線閒置 (沒有未處理的 TLS record) 時，OpenSSL 釋放每條連線約 34KB 的讀寫 record 緩衝區
+            SSL_CTX_set_mode(ssl_context_.native_handle(), SSL_MODE_RELEASE_BUFFERS);
+
+            // kTLS 需要交握產生的流量金鑰與交握後已送出的 record 數，必須在接受連線之前掛上
+            if (config_.ktls) {
+                KernelTls::install(ssl_context_.native_handle());
+                logger_->info("Kernel TLS offload requested for the write path (TLS 1.3 only)");
+            }
             
         } catch (const std::exception& e) {
             logger_->critical("Failed to set up SSL context: {}", e.what());
@@ -47,44 +73,202 @@ public:
     }
 
     void run() {
-        logger_->info("Starting server with {} threads...", thread_count_);
-        threads_.reserve(thread_count_); // threads_ <vector> 一次預先準備好記憶體空間
-        for (std::size_t i = 0; i < thread_count_; ++i) {
-            threads_.emplace_back([this] { io_context_.run(); });
+        const std::vector<int> io_cpus = config_.resolve_io_cpus();
+        logger_->info("I/O backend: {}", io_backend_name());
+        logger_->info("Starting server with {} threads ({} io_context(s), io CPUs: {})...",
+                      thread_count_, io_pool_.context_count(), format_cpu_list(io_cpus));
+
+        // 交握執行緒先啟動，並綁定到整個保留的 CPU 集合
+        if (handshake_pool_) {
+            logger_->info("Starting {} handshake threads (CPUs: {})",
+                          config_.handshake_threads, format_cpu_list(config_.handshake_cpus));
+            handshake_pool_->run(config_.handshake_threads, config_.handshake_cpus, false);
+        }
+        // 工作執行緒共用同一個佇列：閒置的執行緒取走下一個請求，不會有請求卡在忙碌的執行緒後面
+        if (worker_pool_) {
+            logger_->info("Starting {} worker threads for heavy commands (CPUs: {})",
+                          config_.worker_threads, format_cpu_list(config_.worker_cpus));
+            worker_pool_->run(config_.worker_threads, config_.worker_cpus, false);
+        }
+        if (config_.busy_poll_us > 0) {
+            logger_->info("Busy-poll enabled: io threads spin {} us before blocking", config_.busy_poll_us);
+            io_pool_.enable_busy_poll(std::chrono::microseconds(config_.busy_poll_us), metrics_);
         }
+        if (config_.metrics_interval_s > 0) {
+            schedule_metrics_report();
+        }
+        if (services_->federation) {
+            services_->federation->start();
+        }
+
+        // 每條 io 執行緒各自綁定到一個 CPU
+        io_pool_.run(thread_count_, io_cpus, true);
     }
 
     void stop() {
         logger_->info("Stopping server...");
 
+        if (services_->federation) {
+            services_->federation->stop();
+        }
+        io_pool_.stop();
+        if (handshake_pool_) {
+            handshake_pool_->stop();
+        }
+        if (worker_pool_) {
+            worker_pool_->stop();
+        }
+        local_server_.reset(); // 刪除 Unix domain socket 檔案
+        logger_->info("All server threads joined. Server stopped.");
+        log_metrics();
+        dump_latency_trace();
+    }
 
-        // 釋放 work_guard，允許 io_context 在所有任務完成後退出
-        work_guard_.reset();
-
-        io_context_.stop();
+    const ServerMetrics& metrics() const { return *metrics_; }
 
-        // 3. 等待所有執行緒自然結束
-        for (auto& t : threads_) {
-            if (t.joinable()) {
-                t.join();
-            }
+    // 將目前的延遲樣本輸出到設定的追蹤檔 (可在伺服器運行中隨時呼叫)
+    void dump_latency_trace() {
+        if (!services_->latency_tracer || config_.latency_trace_file.empty()) return;
+        try {
+            const std::size_t samples = services_->latency_tracer->dump(config_.latency_trace_file);
+            logger_->info("Latency trace: {} samples written to {}", samples, config_.latency_trace_file);
+        } catch (const std::exception& e) {
+            logger_->error("Latency trace dump failed: {}", e.what());
         }
-        logger_->info("All server threads joined. Server stopped.");
     }
 
     ~ServerRunner() {
-        if (!io_context_.stopped()) {
+        if (!io_pool_.stopped()) {
             stop();
         }
     }
 
 private:
+    void schedule_metrics_report() {
+        metrics_timer_.expires_after(std::chrono::seconds(config_.metrics_interval_s));
+        metrics_timer_.async_wait([this](const asio::error_code& ec) {
+            if (ec) return; // 計時器被取消 (伺服器停止)
+            log_metrics();
+            schedule_metrics_report();
+        });
+    }
+
+    void log_metrics() {
+        const std::string report = metrics_->report();
+        if (!report.empty()) {
+            logger_->info("Metrics: {}", report);
+        }
+        log_throughput();
+        if (services_->message_log) {
+            const auto& log = *services_->message_log;
+            logger_->info("Message log: {} appended, {} dropped, offsets [{}, {})",
+                          log.appended_count(), log.dropped_count(), log.first_offset(), log.next_offset());
+        }
+        if (services_->trace) {
+            services_->trace->flush();
+            logger_->info("Traffic trace: {} records in {}", services_->trace->recorded(), services_->trace->path());
+        }
+    }
+
+    // 本節點自上次報告以來的訊息吞吐量，用來比較增加節點時每個節點的負載
+    void log_throughput() {
+        const auto now = std::chrono::steady_clock::now();
+        const uint64_t published = metrics_->published.load(std::memory_order_relaxed);
+        const uint64_t delivered = metrics_->delivered.load(std::memory_order_relaxed);
+        const uint64_t forwarded_out = metrics_->forwarded_out.load(std::memory_order_relaxed);
+        const uint64_t forwarded_in = metrics_->forwarded_in.load(std::memory_order_relaxed);
+        const double seconds = std::chrono::duration<double>(now - last_report_.time).count();
+        if (seconds > 0 && published + forwarded_in > last_report_.published + last_report_.forwarded_in) {
+            logger_->info("Throughput [port {}]: {:.0f} published/s, {:.0f} delivered/s, {:.0f} forwarded/s, {:.0f} received from peers/s",
+                          port_, (published - last_report_.published) / seconds,
+                          (delivered - last_report_.delivered) / seconds,
+                          (forwarded_out - last_report_.forwarded_out) / seconds,
+                          (forwarded_in - last_report_.forwarded_in) / seconds);
+        }
+        last_report_ = {now, published, delivered, forwarded_out, forwarded_in};
+    }
+
+    // 建立所有 Session 共用的服務 (在 server_ 之前、建構子初始化列表中呼叫)
+    std::shared_ptr<SessionServices> make_services(std::shared_ptr<spdlog::logger> logger) {
+        auto services = std::make_shared<SessionServices>();
+        services->logger = logger;
+        services->metrics = metrics_;
+        services->config = config_;
+        services->handshake_executor = handshake_executor();
+        if (worker_pool_) {
+            services->worker_executor = worker_pool_->primary_context().get_executor();
+        }
+        if (!config_.message_log_dir.empty()) {
+            MessageLog::Options options;
+            options.directory = config_.message_log_dir;
+            options.segment_bytes = config_.message_log_segment_mb * 1024 * 1024;
+            options.max_segments = config_.message_log_max_segments;
+            services->message_log = std::make_shared<MessageLog>(options, logger);
+        }
+        if (!config_.auth_keys_file.empty()) {
+            auto keys = TokenAuthenticator::load_keys(config_.auth_keys_file);
+            logger->info("Token authentication enabled ({} key(s), cache capacity {})",
+                         keys.size(), config_.auth_cache_capacity);
+            services->authenticator = std::make_shared<TokenAuthenticator>(std::move(keys), config_.auth_cache_capacity);
+        }
+        if (!config_.trace_file.empty()) {
+            services->trace = std::make_shared<TraceRecorder>(config_.trace_file);
+            logger->info("Recording traffic trace to {}", config_.trace_file);
+        }
+        if (config_.rate_limit.source_enabled()) {
+            services->source_limits = std::make_shared<SourceRateLimits>(config_.rate_limit);
+        }
+        if (config_.rate_limit.session_enabled() || config_.rate_limit.source_enabled()) {
+            const auto& limits = config_.rate_limit;
+            logger->info("Rate limits: per connection {} frames/s, {} bytes/s; per source IP {} frames/s, {} bytes/s; burst {} ms (0 = unlimited)",
+                         limits.session_frames_per_s, limits.session_bytes_per_s,
+                         limits.source_frames_per_s, limits.source_bytes_per_s, limits.burst_ms);
+        }
+        if (config_.latency_sample_interval > 0 || !config_.latency_trace_file.empty()) {
+            const unsigned interval = config_.latency_sample_interval > 0 ? config_.latency_sample_interval : 1024;
+            services->latency_tracer = std::make_shared<LatencyTracer>(interval);
+            logger->info("Sampling frame latency: 1 in {} reads{}", interval,
+                         config_.latency_trace_file.empty() ? "" : ", trace file " + config_.latency_trace_file);
+        }
+        services->topics = std::make_shared<TopicRegistry>();
+        if (!config_.peers.empty()) {
+            // 節點名稱只用於日誌，讓對方知道是哪個節點連進來
+            const std::string node_name = asio::ip::host_name() + ":" + std::to_string(port_);
+            services->federation = std::make_shared<Federation>(io_pool_.primary_context(), config_.peers, node_name,
+                                                                services->topics, services->authenticator,
+                                                                metrics_, logger);
+        }
+        return services;
+    }
+
+    std::unique_ptr<LocalServer> make_local_server() {
+        if (config_.unix_socket_path.empty()) return nullptr;
+        return std::make_unique<LocalServer>(io_pool_, services_);
+    }
+
+    std::optional<asio::any_io_executor> handshake_executor() {
+        if (!handshake_pool_) return std::nullopt;
+        return handshake_pool_->primary_context().get_executor();
+    }
+
     short port_;
     std::size_t thread_count_;
-    asio::io_context io_context_;
+    ServerConfig config_;
+    IoContextPool io_pool_;
+    std::unique_ptr<IoContextPool> handshake_pool_;
+    std::unique_ptr<IoContextPool> worker_pool_; // 有設定 worker_threads 時才建立
     asio::ssl::context ssl_context_;
+    std::shared_ptr<ServerMetrics> metrics_; // 必須在 server_ 之前初始化
+    std::shared_ptr<SessionServices> services_;
     Server server_;
-    asio::executor_work_guard<asio::io_context::executor_type> work_guard_;
-    std::vector<std::thread> threads_;
+    std::unique_ptr<LocalServer> local_server_; // 有設定 unix_socket_path 時才建立
+    asio::steady_timer metrics_timer_; // 定期報告統計數據
+    struct ThroughputSnapshot {
+        std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+        uint64_t published = 0;
+        uint64_t delivered = 0;
+        uint64_t forwarded_out = 0;
+        uint64_t forwarded_in = 0;
+    } last_report_; // 上次報告吞吐量時的計數
     std::shared_ptr<spdlog::logger> logger_; 
 };
\ No newline at end of file
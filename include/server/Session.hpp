@@ -3,33 +3,70 @@
 #include <memory>
 #include <array>
 #include <deque>
+#include <optional>
 #include <asio.hpp>
 #include <asio/ssl.hpp>
 #include "utils/Logger.hpp"
+#include "utils/BufferPool.hpp"
 #include "frame/FrameParser.hpp"
 #include "frame/FrameBuilder.hpp"
+#include "frame/Messages.hpp"
+#include "server/WriteScheduler.hpp"
+#include "server/ServerMetrics.hpp"
+#include "server/SessionServices.hpp"
+#include "server/TopicRegistry.hpp"
+#include "server/SessionStream.hpp"
+#include "server/HeavyCommands.hpp"
 
 using asio::ip::tcp;
 
 // Session 類別負責管理單一的客戶端連線
 // 它繼承 enable_shared_from_this 以便安全地建立 shared_ptr
-class Session : public std::enable_shared_from_this<Session> {
+// 同時也是 TopicSubscriber，可以接收所訂閱主題的訊息 (或是作為其他節點連進來的聯邦連線)
+class Session : public std::enable_shared_from_this<Session>, public TopicSubscriber {
 public:
-    explicit Session(asio::ssl::stream<tcp::socket> stream, std::shared_ptr<spdlog::logger> logger) 
+    explicit Session(SessionStream stream, std::shared_ptr<const SessionServices> services) 
         : stream_(std::move(stream)), 
 		  strand_(asio::make_strand(stream_.get_executor())),
-		  remote_endpoint_str_(get_remote_endpoint_string()),
+		  // 交握期間沒有其他操作，因此交握的 strand 可以位於另一組 (保留給交握的) 執行緒上
+		  handshake_strand_(services->handshake_executor ? asio::make_strand(*services->handshake_executor) : strand_),
+		  remote_endpoint_str_(stream_.remote_endpoint_string()),
           is_closing_(false),
-          logger_(logger) {}
+          services_(std::move(services)),
+          logger_(services_->logger),
+          metrics_(services_->metrics) {
+        if (services_->config.rate_limit.session_enabled() || services_->source_limits) {
+            std::shared_ptr<SourceBuckets> source;
+            if (services_->source_limits) {
+                source = services_->source_limits->acquire(stream_.remote_address_string());
+            }
+            rate_limiter_.configure(services_->config.rate_limit, std::move(source));
+        }
+    }
 
     void start() {
-        // 在開始讀寫之前，必須先進行 TLS 交握
         auto self = shared_from_this();
-        stream_.async_handshake(asio::ssl::stream_base::server,
-            asio::bind_executor(strand_, [this, self](const asio::error_code& ec) {
+        if (!stream_.is_tls()) {
+            // Unix domain socket：不需要交握，對端的身分已由接受連線時的 SO_PEERCRED 確認
+            asio::post(strand_, [this, self]() {
+                logger_->info("Local connection established for client: {}", remote_endpoint_str_);
+                if (services_->authenticator) {
+                    // 本機的 sidecar 以 uid 作為認證的身分，不需要 token
+                    auth_.authenticated = true;
+                    auth_.subject = "uid:" + std::to_string(stream_.peer_credentials().uid);
+                }
+                on_established();
+            });
+            return;
+        }
+        // 在開始讀寫之前，必須先進行 TLS 交握
+        // 交握的中間步驟 (包含金鑰交換的運算) 都會在 handshake_strand_ 上執行
+        stream_.async_handshake(
+            asio::bind_executor(handshake_strand_, [this, self](const asio::error_code& ec) {
                 if (!ec) {
                     logger_->info("TLS handshake successful for client: {}", remote_endpoint_str_);
-                    do_read();
+                    if (services_->config.ktls) enable_kernel_tls();
+                    on_established();
                 } else {
                     logger_->error("TLS handshake failed for client {}: {}", remote_endpoint_str_, ec.message());
                     // 交握失敗，不需要手動關閉，Session 物件會自動銷毀
@@ -39,9 +76,57 @@ public:
 	~Session() {
         // 在解構時，我們只記錄日誌。關閉 socket 的操作將透過 RAII 和非同步操作的生命週期管理來自動處理。
         // 當這個日誌被印出時，代表 Session 物件即將被銷毀。
+		if (!subscribed_topics_.empty()) {
+			services_->topics->unsubscribe(this, subscribed_topics_);
+		}
+		if (is_peer_) {
+			services_->federation->remove_inbound_peer(this);
+		}
+		if (trace_connection_id_ != 0) {
+			services_->trace->record(trace_connection_id_, TRACE_CONNECTION_CLOSE, 0);
+		}
 		logger_->info("Session destroyed for client: {}", remote_endpoint_str_);
 	}
+
+    // 其他 Session 發布的訊息 (或聯邦的控制訊框)：與其他接收者共用同一份已編碼的訊框
+    // 一定要 post 並持有 self：呼叫端可能在持有 TopicRegistry 的鎖時呼叫，不能在這裡觸發解構
+    void deliver(std::shared_ptr<const std::vector<char>> frame, PriorityClass priority) override {
+        asio::post(strand_, [this, self = shared_from_this(), frame = std::move(frame), priority]() mutable {
+            if (is_closing_ || close_after_write_) return; // 排定關閉後不再轉送，否則寫入佇列可能永遠不會清空
+
+            OutPacket packet;
+            packet.external_data = frame->data();
+            packet.external_size = frame->size();
+            packet.owner = std::move(frame);
+            packet.priority = priority;
+            queue_packet(std::move(packet));
+        });
+    }
+
 private:
+    // 交握剛完成、還沒有任何寫入時，把寫入方向的加密交給核心
+    // 失敗時只在第一次記錄原因 (通常是核心沒有 tls 模組，每條連線都會一樣)
+    void enable_kernel_tls() {
+        const KernelTlsStatus status = stream_.enable_kernel_tx();
+        if (status == KernelTlsStatus::ENABLED) {
+            metrics_->ktls_enabled.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (metrics_->ktls_fallback.fetch_add(1, std::memory_order_relaxed) == 0) {
+            logger_->warn("Kernel TLS unavailable for client {} ({}), using user-space TLS",
+                          remote_endpoint_str_, kernel_tls_status_name(status));
+        }
+    }
+
+    // 連線建立完成 (TLS 交握成功，或 Unix domain socket 已接受)：開始讀取
+    void on_established() {
+        if (services_->trace) {
+            trace_connection_id_ = services_->trace->next_connection_id();
+            services_->trace->record(trace_connection_id_, TRACE_CONNECTION_OPEN, 0);
+        }
+        do_read();
+    }
+
     void close_session() {
         // 使用 strand 確保線程安全
         asio::post(strand_, [this, self = shared_from_this()]() {
@@ -49,136 +134,730 @@ private:
             is_closing_ = true;
             
             // 確保 socket 仍然開啟
-            if (stream_.lowest_layer().is_open()) {
-                asio::error_code ec;
-                // 優雅地關閉 SSL 連線
-                // async_shutdown 會嘗試發送 "close_notify"
+            if (stream_.is_open()) {
+                // 優雅地關閉連線
+                // TLS 連線的 async_shutdown 會嘗試發送 "close_notify"
                 stream_.async_shutdown([this, self](const asio::error_code& ec) {}); 
             }
             
             // 清空寫入佇列
-            write_packets_.clear();
+            write_scheduler_.clear();
+            if (throttle_timer_) throttle_timer_->cancel();
         });
     }
-    // 輔助函式，用於安全地獲取一次端點字串
-    std::string get_remote_endpoint_string() {
-        try {
-            return stream_.lowest_layer().remote_endpoint().address().to_string() + ":" + std::to_string(stream_.lowest_layer().remote_endpoint().port());
-        } catch (const std::exception& e) {
-            // 在 SSL 交握前獲取端點可能會失敗，這在某些平台上是正常的
-            return "unknown";
+    // 閒置的連線不持有讀取緩衝區：先只等待 socket 可讀，資料到達後才向執行緒的緩衝區池借用
+    void do_read() {
+        if (is_closing_ || close_after_write_) return; // 如果正在關閉，則不進行讀取
+
+        // OpenSSL 內部還有已收到但尚未交給我們的資料時，socket 不一定會再變成可讀，必須直接讀取
+        if (stream_.has_buffered_data()) {
+            read_available();
+            return;
         }
+
+        // 沒有未完成的訊框時歸還解析器的儲存空間 (寫入路徑在佇列寫空時歸還)
+        parser_.release_if_empty();
+
+        auto self = shared_from_this();
+        stream_.async_wait_read(
+            asio::bind_executor(strand_, [this, self](const asio::error_code& ec) {
+                if (is_closing_) return;
+                if (ec) {
+                    on_read_error(ec);
+                    return;
+                }
+                read_available();
+            }));
     }
 
-    void do_read() {
-        if (is_closing_) return; // 如果正在關閉，則不進行讀取
+    void on_read_error(const asio::error_code& ec) {
+        if (ec != asio::error::eof) {
+            logger_->error("Read error from {}: {}", remote_endpoint_str_, ec.message());
+        } else {
+            // 客戶端正常斷線 (EOF)
+            logger_->info("Client disconnected: {}", remote_endpoint_str_);
+        }
+        // 發生錯誤或客戶端斷線，不再繼續操作。
+        // shared_ptr `self` 會在此回呼函式結束時被釋放，
+        // 如果沒有其他非同步操作持有它，Session 將被銷毀。
+        // 在銷毀前，我們主動關閉 socket。
+        close_session();
+    }
 
+    void read_available() {
+        // 延遲取樣：同一條連線同時只追蹤一個訊框
+        if (services_->latency_tracer && !sample_ && services_->latency_tracer->sample()) {
+            begin_sample();
+        }
         auto self = shared_from_this();
-        stream_.async_read_some(asio::buffer(read_buffer_),
+        read_block_ = BufferPool::acquire_shared();
+        stream_.async_read_some(asio::buffer(read_block_.get(), BufferPool::buffer_size),
             // 使用 asio::bind_executor 將回呼函式綁定到 strand
             asio::bind_executor(strand_, [this, self](const asio::error_code& ec, std::size_t length) {
+                // 讀取緩衝區之後只由引用它的回音封包持有，全部寫出後自動歸還
+                std::shared_ptr<char> block = std::move(read_block_);
                 if (is_closing_) return;
 
                 if (ec) {
-                    if (ec != asio::error::eof) {
-                        logger_->error("Read error from {}: {}", remote_endpoint_str_, ec.message());
-                    } else {
-                        // 客戶端正常斷線 (EOF)
-                        logger_->info("Client disconnected: {}", remote_endpoint_str_);
-                    }
-                    // 發生錯誤或客戶端斷線，不再繼續操作。
-                    // shared_ptr `self` 會在此回呼函式結束時被釋放，
-                    // 如果沒有其他非同步操作持有它，Session 將被銷毀。
-                    // 在銷毀前，我們主動關閉 socket。
-                    close_session();
+                    on_read_error(ec);
                     return;
                 }
+                if (sampling_read_) sample_->stamp(FrameStamp::READ_DONE);
+                dispatch_frames(block.get(), length, block);
+            }));
+    }
 
-                // 1. 將收到的原始資料餵給解析器
-                parser_.push_data(read_buffer_.data(), length);
-
-                while (!is_closing_) {
-                    Frame frame;
-                    auto result = parser_.try_parse(frame);
-
-                    if (result == ParseResult::SUCCESS) {
-                        process_message(frame);
-                        // 成功解析一個，繼續迴圈嘗試下一個
-                    } else if (result == ParseResult::NEED_MORE_DATA) {
-                        // 資料不夠了，發起下一次讀取，然後退出迴圈
-                        do_read();
-                        return; // 退出回呼函式
-                    } else { // INVALID_HEADER or other errors
-                        logger_->error("Invalid frame from {}. Closing connection.", remote_endpoint_str_);
-                        // 不再需要手動呼叫 close()。直接返回，讓 Session 物件自然銷毀。
-                        close_session();
-                        return;
-                    }
-                }
+    // 分派 data 中的完整訊框 (先處理解析器中保存的資料)，分派完後決定何時繼續讀取
+    // 暫停讀取後繼續時以 data 為空呼叫，只處理保存的資料
+    void dispatch_frames(const char* data, std::size_t length, const std::shared_ptr<char>& block) {
+        // 1. 直接在讀取緩衝區上解析，完整的訊框不複製；分派期間產生的回覆先累積，分派完再一次寫出
+        std::size_t remaining = length;
+        ParseResult result = ParseResult::NEED_MORE_DATA;
+        uint64_t frame_count = 0;
+        bool parked = false;
+        dispatching_ = true;
+        while (!is_closing_ && !close_after_write_) {
+            FrameView frame;
+            result = parser_.next(data, remaining, frame);
+            if (result != ParseResult::SUCCESS) break;
+            ++frame_count;
+            if (sampling_read_) {
+                // 取樣這次讀取中的第一個訊框
+                sampling_read_ = false;
+                sampling_frame_ = true;
+                sample_->stamp(FrameStamp::PARSED);
+                sample_->command_id = frame.header.command_id;
+                sample_->payload_size = static_cast<uint32_t>(frame.size - sizeof(FrameHeader));
+            }
+
+            if (trace_connection_id_ != 0) {
+                services_->trace->record(trace_connection_id_, frame.header.command_id,
+                                         static_cast<uint32_t>(frame.size - sizeof(FrameHeader)));
+            }
+            current_frame_ = &frame;
+            current_frame_owner_ = frame.buffered ? nullptr : block;
+            if (sampling_frame_) sample_->stamp(FrameStamp::DISPATCHED);
+            process_message(frame.header.command_id, frame.payload());
+            current_frame_ = nullptr;
+            current_frame_owner_.reset();
+            if (sampling_frame_) {
+                // 沒有產生回覆 (例如訂閱或批次中的發布)：到分派結束為止
+                sampling_frame_ = false;
+                sample_->stamp(FrameStamp::ENQUEUED);
+                finish_sample();
+            }
+            // 交給工作執行緒的請求達到上限：停止分派，尚未分派的資料留在解析器中，等其中一個完成再繼續
+            if (pending_jobs_ >= max_pending_jobs) {
+                parser_.defer(data, remaining);
+                parked = true;
+                break;
+            }
+            // 成功解析一個，繼續迴圈嘗試下一個
+        }
+        dispatching_ = false;
+        if (sampling_read_) {
+            // 這次讀取沒有完整的訊框，放棄這個樣本
+            sampling_read_ = false;
+            sample_.reset();
+        }
+        if (!write_in_progress_) {
+            start_packet_write();
+        }
+
+        if (is_closing_ || close_after_write_) return;
+        if (result == ParseResult::INVALID_HEADER) {
+            logger_->error("Invalid frame from {}. Closing connection.", remote_endpoint_str_);
+            // 不再需要手動呼叫 close()。直接返回，讓 Session 物件自然銷毀。
+            close_session();
+            return;
+        }
+        if (parked) {
+            reads_parked_ = true;
+            metrics_->worker_read_pauses.fetch_add(1, std::memory_order_relaxed);
+        }
+        // 超過速率限制時暫停讀取，等令牌補足再繼續 (聯邦連線不受限制)
+        if (rate_limiter_.enabled() && !is_peer_) {
+            const auto verdict = rate_limiter_.charge(frame_count, length);
+            if (verdict.wait.count() > 0 && !parked) {
+                pause_reads(verdict);
+                return;
+            }
+        }
+        if (parked) return;
+        // 資料不夠了，發起下一次讀取
+        do_read();
+    }
+
+    // 暫停讀取一段時間：客戶端送出的資料留在 socket 緩衝區，TCP 視窗填滿後客戶端自然會慢下來
+    void pause_reads(const RateLimiter::Verdict& verdict) {
+        (verdict.by_source ? metrics_->throttled_source : metrics_->throttled_session)
+            .fetch_add(1, std::memory_order_relaxed);
+        metrics_->throttled_ns.fetch_add(static_cast<uint64_t>(verdict.wait.count()), std::memory_order_relaxed);
+
+        // 計時器只在第一次被限制時建立，不受限制的連線不需要負擔它的記憶體
+        if (!throttle_timer_) {
+            throttle_timer_ = std::make_unique<asio::steady_timer>(strand_);
+        }
+        throttle_timer_->expires_after(verdict.wait);
+        throttle_timer_->async_wait(
+            asio::bind_executor(strand_, [this, self = shared_from_this()](const asio::error_code& ec) {
+                if (ec || is_closing_) return;
+                do_read();
             }));
     }
 
-    void process_message(const Frame& frame) {
-        if (!is_closing_) {
-            do_write(frame);
+    // 分派一則訊息；payload 指向訊框 (或批次訊框) 的記憶體，只在此呼叫期間有效
+    void process_message(uint16_t command_id, std::string_view payload) {
+        if (is_closing_) return;
+
+        // 啟用認證時，通過認證前只接受認證訊框
+        if (services_->authenticator && !auth_.authenticated && command_id != CMD_AUTH_REQUEST) {
+            logger_->warn("Unauthenticated client {} sent command {}. Closing connection.",
+                          remote_endpoint_str_, command_id);
+            metrics_->auth_failed.fetch_add(1, std::memory_order_relaxed);
+            reject(AuthStatus::UNAUTHENTICATED);
+            return;
+        }
+
+        if (is_heavy_command(command_id)) {
+            dispatch_heavy(command_id, payload);
+            return;
+        }
+
+        switch (command_id) {
+            case CMD_AUTH_REQUEST:
+                handle_auth_request(payload);
+                break;
+            case CMD_PUBLISH_MESSAGE:
+                handle_publish(payload);
+                break;
+            case CMD_SUBSCRIBE_TOPIC:
+                handle_subscribe(command_id, payload);
+                break;
+            case CMD_REPLAY_REQUEST:
+                handle_replay_request(payload);
+                break;
+            case CMD_PEER_HELLO:
+                handle_peer_hello(payload);
+                break;
+            case CMD_PEER_FORWARD:
+                handle_peer_forward(payload);
+                break;
+            case CMD_BATCH:
+                handle_batch(payload);
+                break;
+            default:
+                do_write(command_id, payload);
+                break;
         }
     }
 
-    void do_write(const Frame& frame) {
+    void do_write(uint16_t command_id, std::string_view payload) {
         if (is_closing_) return;
+        if (in_batch_) return; // 批次中的回音由 CMD_BATCH_ACK 統一確認
         
+        // 回音與收到的訊框逐位元組相同：直接送出原本的位元組 (包含標頭)，不重新編碼
+        if (is_current_frame(command_id, payload)) {
+            echo_current_frame(priority_class_of(command_id));
+            return;
+        }
+
         //建立一個 std::vector<char> 來儲存封包資料
-        std::vector<char> packet = FrameBuilder::build(
-            static_cast<CommandID>(frame.header.command_id),
-            std::string(frame.payload.begin(), frame.payload.end())
-        );
-
-        // 將封包移入佇列。使用 bind_executor 確保此操作在 strand 中執行，避免多執行緒同時修改佇列
-        asio::post(strand_, [this, self = shared_from_this(), packet = std::move(packet)]() mutable {
-            if(is_closing_) return;
-
-            bool write_in_progress = !write_packets_.empty();
-            write_packets_.push_back(std::move(packet));
-            if (!write_in_progress) {
-                start_packet_write();
-            }
-        });
+        std::vector<char> packet = FrameBuilder::build(static_cast<CommandID>(command_id), payload);
+
+        enqueue_packet(std::move(packet), priority_class_of(command_id));
+    }
+
+    // 耗用 CPU 的指令：設定了工作執行緒時複製承載資料交給工作執行緒，io 執行緒繼續處理其他訊框與連線；
+    // 回覆送回 strand 後帶著原本的請求 ID 寫出，可能晚於之後的請求的回覆
+    // 批次中一律拒絕：一個批次可以裝進上千個請求，單一訊框就會佔用大量 CPU
+    void dispatch_heavy(uint16_t command_id, std::string_view payload) {
+        if (in_batch_) {
+            enqueue_packet(reject_heavy_command(command_id), priority_class_of(command_id));
+            return;
+        }
+        if (!services_->worker_executor) {
+            metrics_->worker_inline.fetch_add(1, std::memory_order_relaxed);
+            enqueue_packet(run_heavy_command(command_id, payload), priority_class_of(command_id));
+            return;
+        }
+        ++pending_jobs_;
+        metrics_->worker_jobs.fetch_add(1, std::memory_order_relaxed);
+        asio::post(*services_->worker_executor,
+            [this, self = shared_from_this(), command_id, request_id = current_request_id(),
+             payload = std::string(payload)]() {
+                OutPacket reply;
+                reply.data = run_heavy_command(command_id, payload);
+                if (!reply.data.empty()) set_request_id(reply.data.data(), request_id);
+                reply.priority = priority_class_of(command_id);
+                asio::post(strand_, [this, self, reply = std::move(reply)]() mutable {
+                    on_heavy_done(std::move(reply));
+                });
+            });
+    }
+
+    void on_heavy_done(OutPacket reply) {
+        --pending_jobs_;
+        if (is_closing_ || close_after_write_) return;
+        if (reply.data.empty()) {
+            logger_->error("Dropped a reply to {} that failed to encode", remote_endpoint_str_);
+        } else {
+            queue_packet(std::move(reply));
+        }
+        if (reads_parked_ && pending_jobs_ < max_pending_jobs) {
+            // 先分派暫停時保存在解析器中的訊框，之後才會再從 socket 讀取
+            reads_parked_ = false;
+            dispatch_frames(nullptr, 0, nullptr);
+        }
+    }
+
+    // payload 是否就是正在分派的訊框的承載資料 (而不是批次中的子訊息或聯邦轉送的訊框)
+    bool is_current_frame(uint16_t command_id, std::string_view payload) const {
+        return current_frame_ && current_frame_->header.command_id == command_id &&
+               current_frame_->payload().data() == payload.data() && current_frame_->payload().size() == payload.size();
+    }
+
+    // 原樣送回正在分派的訊框 (標頭中的請求 ID 也一併帶回)
+    // 訊框位於讀取緩衝區時以引用的方式送出 (零複製)；跨越讀取邊界的訊框只複製一次
+    void echo_current_frame(PriorityClass priority) {
+        OutPacket packet;
+        if (current_frame_owner_) {
+            packet.external_data = current_frame_->bytes;
+            packet.external_size = current_frame_->size;
+            packet.owner = current_frame_owner_;
+        } else {
+            packet.data.assign(current_frame_->bytes, current_frame_->bytes + current_frame_->size);
+        }
+        packet.priority = priority;
+        queue_packet(std::move(packet));
+    }
+
+    // 正在分派的訊框的請求 ID，回覆帶回相同的 ID；批次中的子訊息沒有自己的 ID
+    uint8_t current_request_id() const {
+        return current_frame_ && !in_batch_ ? current_frame_->header.request_id : 0;
+    }
+
+    // 批次：一次掃過所有子訊息並就地分派，子訊息的承載資料直接指向批次訊框，不會複製
+    // 子訊息不逐一回音，處理完畢後送出一個 CMD_BATCH_ACK (其他種類的回覆，例如認證結果，照常送出)
+    void handle_batch(std::string_view payload) {
+        if (in_batch_) {
+            logger_->error("Nested batch from {}. Closing connection.", remote_endpoint_str_);
+            close_session();
+            return;
+        }
+        in_batch_ = true;
+        BatchReader reader(payload.data(), payload.size());
+        BatchEntry entry;
+        uint32_t count = 0;
+        while (!is_closing_ && !close_after_write_ && reader.next(entry)) {
+            process_message(entry.command_id, entry.payload);
+            ++count;
+        }
+        in_batch_ = false;
+        metrics_->batch_frames.fetch_add(1, std::memory_order_relaxed);
+        metrics_->batch_messages.fetch_add(count, std::memory_order_relaxed);
+
+        if (reader.malformed()) {
+            logger_->error("Malformed batch from {}. Closing connection.", remote_endpoint_str_);
+            close_session();
+            return;
+        }
+        if (is_closing_ || close_after_write_) return;
+
+        enqueue_packet(FrameBuilder::build(BatchAck{count}), priority_class_of(CMD_BATCH_ACK));
+    }
+
+    // 認證請求 (承載資料即為 token)
+    void handle_auth_request(std::string_view payload) {
+        if (!services_->authenticator) {
+            // 未啟用認證：所有連線本來就視為已認證
+            send_auth_response(AuthStatus::OK, {});
+            return;
+        }
+        AuthRequest request;
+        if (!codec::decode(payload, request)) {
+            logger_->warn("Malformed auth request from {}", remote_endpoint_str_);
+            metrics_->auth_failed.fetch_add(1, std::memory_order_relaxed);
+            reject(AuthStatus::MALFORMED);
+            return;
+        }
+        const auto result = services_->authenticator->authenticate(std::string(request.token));
+        if (result.status != AuthStatus::OK) {
+            logger_->warn("Authentication failed for {}: {}", remote_endpoint_str_, auth_status_name(result.status));
+            metrics_->auth_failed.fetch_add(1, std::memory_order_relaxed);
+            reject(result.status);
+            return;
+        }
+        metrics_->auth_succeeded.fetch_add(1, std::memory_order_relaxed);
+        if (result.cache_hit) {
+            metrics_->auth_cache_hits.fetch_add(1, std::memory_order_relaxed);
+        }
+        auth_.authenticated = true;
+        auth_.subject = result.subject;
+        logger_->info("Client {} authenticated as '{}'", remote_endpoint_str_, auth_.subject);
+        send_auth_response(AuthStatus::OK, auth_.subject);
+    }
+
+    // CMD_AUTH_RESPONSE: 狀態 (uint8_t) + 認證的身分
+    void send_auth_response(AuthStatus status, std::string_view subject) {
+        enqueue_packet(FrameBuilder::build(AuthResponse{static_cast<uint8_t>(status), subject}),
+                       priority_class_of(CMD_AUTH_RESPONSE));
+    }
+
+    // 回覆失敗原因，寫出後關閉連線；之後收到的訊框一律忽略
+    // 必須在 strand 中呼叫；直接放入佇列，確保關閉前一定會寫出這個回覆
+    void reject(AuthStatus status) {
+        close_after_write_ = true;
+        // 停止訂閱與重播：持續送來的訊息會讓寫入佇列一直有資料，連線就不會在回覆寫出後關閉
+        if (!subscribed_topics_.empty()) {
+            services_->topics->unsubscribe(this, subscribed_topics_);
+            subscribed_topics_.clear();
+        }
+        replay_active_ = false;
+        enqueue_packet(FrameBuilder::build(AuthResponse{static_cast<uint8_t>(status), {}}),
+                       priority_class_of(CMD_AUTH_RESPONSE));
+    }
+
+    // 發布訊息：回音給發布者作為確認，並送給本地訂閱者與需要此主題的其他節點
+    void handle_publish(std::string_view payload) {
+        auto packet = std::make_shared<const std::vector<char>>(FrameBuilder::build(CMD_PUBLISH_MESSAGE, payload));
+        const PriorityClass priority = priority_class_of(CMD_PUBLISH_MESSAGE);
+        metrics_->published.fetch_add(1, std::memory_order_relaxed);
+
+        // 已發布的訊息以編碼完成的訊框原樣寫入訊息日誌 (只排入佇列，不等待寫入)
+        if (services_->message_log) {
+            services_->message_log->append(packet);
+        }
+
+        const std::string topic = publish_topic(payload.data(), payload.size());
+        const std::size_t delivered = services_->topics->publish(topic, packet, priority, this);
+        if (delivered > 0) {
+            metrics_->delivered.fetch_add(delivered, std::memory_order_relaxed);
+        }
+        if (services_->federation) {
+            services_->federation->forward(topic, *packet);
+        }
+
+        if (in_batch_) return; // 批次中的發布由 CMD_BATCH_ACK 統一確認
+
+        // 帶有請求 ID 的發布回音原本的訊框，帶回相同的 ID (給訂閱者的共用訊框不帶 ID)
+        if (current_request_id() != 0 && is_current_frame(CMD_PUBLISH_MESSAGE, payload)) {
+            echo_current_frame(priority);
+            return;
+        }
+
+        // 回音與訂閱者共用同一份訊框
+        OutPacket echo;
+        echo.external_data = packet->data();
+        echo.external_size = packet->size();
+        echo.owner = std::move(packet);
+        echo.priority = priority;
+        queue_packet(std::move(echo));
+    }
+
+    // 訂閱主題 (承載資料即為主題名稱)，並回音作為確認
+    void handle_subscribe(uint16_t command_id, std::string_view payload) {
+        SubscribeRequest request;
+        if (!codec::decode(payload, request)) {
+            logger_->error("Malformed subscribe request from {}. Closing connection.", remote_endpoint_str_);
+            close_session();
+            return;
+        }
+        std::string topic(request.topic);
+        if (std::find(subscribed_topics_.begin(), subscribed_topics_.end(), topic) == subscribed_topics_.end()) {
+            services_->topics->subscribe(topic, shared_from_this());
+            subscribed_topics_.push_back(std::move(topic));
+        }
+        do_write(command_id, payload);
+    }
+
+    // 另一個節點連進來：之後這條連線用來回報本節點需要的主題，並接收轉送的訊息
+    void handle_peer_hello(std::string_view payload) {
+        PeerHello hello;
+        if (!codec::decode(payload, hello)) {
+            logger_->error("Malformed PEER_HELLO from {}. Closing connection.", remote_endpoint_str_);
+            close_session();
+            return;
+        }
+        // 只有 Federation 簽發的節點身分 (peer/<節點名稱>) 可以成為聯邦連線 (不受來源速率限制、可以注入轉送的訊息)；
+        // 一般客戶端與以 uid 認證的本機連線一律拒絕。未啟用認證時沒有可以檢查的身分
+        if (services_->authenticator && auth_.subject.rfind("peer/", 0) != 0) {
+            logger_->warn("Client {} ('{}') sent PEER_HELLO without a peer identity. Closing connection.",
+                          remote_endpoint_str_, auth_.subject);
+            metrics_->auth_failed.fetch_add(1, std::memory_order_relaxed);
+            reject(AuthStatus::FORBIDDEN);
+            return;
+        }
+        if (!services_->federation) {
+            logger_->warn("Peer {} ({}) connected but federation is not enabled on this node. Closing connection.",
+                          hello.node_name, remote_endpoint_str_);
+            close_session();
+            return;
+        }
+        if (is_peer_) return;
+        is_peer_ = true;
+        logger_->info("Federation peer {} connected from {}", hello.node_name, remote_endpoint_str_);
+        services_->federation->add_inbound_peer(shared_from_this());
+    }
+
+    void handle_peer_forward(std::string_view payload) {
+        if (!is_peer_ || !services_->federation->deliver_forwarded(payload)) {
+            logger_->error("Unexpected or malformed forward batch from {}. Closing connection.", remote_endpoint_str_);
+            close_session();
+        }
+    }
+
+    // 客戶端要求從某個 offset 開始重播已發布的訊息
+    // 資料直接從映射的頁面寫出，每次只排入一個區塊，寫完後再讀取下一塊，避免一次佔用大量記憶體
+    void handle_replay_request(std::string_view payload) {
+        if (!services_->message_log) {
+            send_replay_response(REPLAY_LOG_DISABLED, 0);
+            return;
+        }
+        ReplayRequest request;
+        if (!codec::decode(payload, request)) {
+            send_replay_response(REPLAY_BAD_REQUEST, 0);
+            return;
+        }
+        logger_->info("Replay requested by {} from offset {}", remote_endpoint_str_, request.offset);
+
+        replay_offset_ = request.offset;
+        if (!replay_active_) {
+            replay_active_ = true;
+            queue_next_replay_chunk();
+        }
+        // 若已有重播進行中，下一個區塊會從新的 offset 開始
+    }
+
+    // 必須在 strand 中呼叫
+    void queue_next_replay_chunk() {
+        ReplayChunk chunk = services_->message_log->read(replay_offset_, max_replay_chunk_bytes);
+        if (chunk.size == 0) {
+            replay_active_ = false;
+            send_replay_response(REPLAY_COMPLETE, chunk.next_offset);
+            return;
+        }
+        replay_offset_ = chunk.next_offset;
+
+        OutPacket packet;
+        packet.external_data = chunk.data;
+        packet.external_size = chunk.size;
+        packet.owner = std::move(chunk.segment);
+        packet.priority = PriorityClass::BULK;
+        packet.replay = true;
+        queue_packet(std::move(packet));
+    }
+
+    void send_replay_response(ReplayStatus status, uint64_t next_offset) {
+        enqueue_packet(FrameBuilder::build(ReplayResponse{status, next_offset}), priority_class_of(CMD_REPLAY_RESPONSE));
+    }
+
+    // 將封包依其優先等級放入寫入排程器 (必須在 strand 中呼叫)
+    // 回覆目前分派中的訊框：帶回它的請求 ID (非同步產生的回覆沒有對應的訊框，ID 為 0)
+    // 空的封包是編碼失敗的回覆 (見 FrameBuilder::build)，不會送出
+    void enqueue_packet(std::vector<char> packet, PriorityClass priority) {
+        if (packet.empty()) {
+            logger_->error("Dropped a reply to {} that failed to encode", remote_endpoint_str_);
+            return;
+        }
+        set_request_id(packet.data(), current_request_id());
+        OutPacket out;
+        out.data = std::move(packet);
+        out.priority = priority;
+        queue_packet(std::move(out));
+    }
+
+    // 必須在 strand 中呼叫。分派同一次讀取的訊框期間只累積，分派結束後才開始寫出，讓回覆合併成同一批
+    void queue_packet(OutPacket packet) {
+        if (is_closing_) return;
+        if (sampling_frame_) {
+            // 取樣訊框的 (第一個) 回覆
+            sampling_frame_ = false;
+            packet.sampled = true;
+            sample_->stamp(FrameStamp::ENQUEUED);
+        }
+        write_scheduler_.push(std::move(packet));
+        if (!write_in_progress_ && !dispatching_) {
+            start_packet_write();
+        }
     }
 
     void start_packet_write() {
         // 這個函式必須在 strand 中被呼叫
-        if (is_closing_ || write_packets_.empty()) {
+        if (is_closing_ || write_scheduler_.empty()) {
+            write_in_progress_ = false;
+            release_write_memory();
             return; // 佇列已空，無需寫入
         }
+        write_in_progress_ = true;
+
+        // 依優先順序取出一批封包，合併成一次寫入
+        in_flight_packets_.clear();
+        write_scheduler_.collect(in_flight_packets_, max_coalesced_write_bytes,
+            [this](PriorityClass cls, std::chrono::nanoseconds delay) {
+                metrics_->write_queue_delay[static_cast<std::size_t>(cls)].record(delay.count());
+            });
+        metrics_->write_batches.fetch_add(1, std::memory_order_relaxed);
+        metrics_->write_packets.fetch_add(in_flight_packets_.size(), std::memory_order_relaxed);
+        if (sample_ && sample_->has(FrameStamp::ENQUEUED) && !sample_->has(FrameStamp::WRITE_STARTED)) {
+            for (const auto& packet : in_flight_packets_) {
+                if (packet.sampled) sample_->stamp(FrameStamp::WRITE_STARTED);
+            }
+        }
 
-        // 使用佇列最前端的封包進行非同步寫入
-        asio::async_write(stream_, asio::buffer(write_packets_.front()),
+        // Unix domain socket 沒有加密、kTLS 由核心加密，各封包直接以 buffer 序列一次寫出 (writev)，不需要複製
+        if (stream_.gather_writes()) {
+            write_buffers_.clear();
+            for (const auto& packet : in_flight_packets_) {
+                write_buffers_.push_back(asio::buffer(packet.bytes(), packet.size()));
+            }
+            asio::async_write(stream_, write_buffers_,
+                asio::bind_executor(strand_, [this, self = shared_from_this()](const asio::error_code& ec, std::size_t) {
+                    on_packets_written(ec);
+                }));
+            return;
+        }
+
+        // ssl::stream 每次 write_some 只會加密第一個 buffer，
+        // 因此多個封包先複製到連續的緩衝區，才能合併成同一個 TLS record 與同一次系統呼叫
+        // 只有一個封包時直接從它的記憶體寫出 (重播區塊即為映射的頁面)
+        // 合併用的緩衝區向執行緒的緩衝區池借用，寫完即歸還；超過池緩衝區大小時 (大量控制訊框) 才另外配置
+        asio::const_buffer buffer;
+        if (in_flight_packets_.size() == 1) {
+            buffer = asio::buffer(in_flight_packets_.front().bytes(), in_flight_packets_.front().size());
+        } else {
+            std::size_t total = 0;
+            for (const auto& packet : in_flight_packets_) total += packet.size();
+            char* out = nullptr;
+            if (total <= BufferPool::buffer_size) {
+                coalesce_lease_ = BufferPool::acquire();
+                out = coalesce_lease_.data();
+            } else {
+                coalesce_buffer_.resize(total);
+                out = coalesce_buffer_.data();
+            }
+            std::size_t offset = 0;
+            for (const auto& packet : in_flight_packets_) {
+                std::memcpy(out + offset, packet.bytes(), packet.size());
+                offset += packet.size();
+            }
+            buffer = asio::buffer(out, total);
+        }
+
+        asio::async_write(stream_, buffer,
             // 同樣將寫入的回呼函式綁定到 strand
             asio::bind_executor(strand_, [this, self = shared_from_this()](const asio::error_code& ec, std::size_t /*length*/) {
-                if(is_closing_) return;
+                on_packets_written(ec);
+            }));
+    }
 
-                if (ec) {
-                    logger_->error("Write error to {}: {}", remote_endpoint_str_, ec.message());
-                    close_session(); // 寫入失敗也關閉 session
-                    return; // 發生錯誤，不再繼續寫入
-                }
+    // 一批封包寫出完成 (在 strand 中呼叫)
+    void on_packets_written(const asio::error_code& ec) {
+        if(is_closing_) return;
 
-                // 寫入成功，從佇列中移除已傳送的封包
-                write_packets_.pop_front();
+        if (ec) {
+            logger_->error("Write error to {}: {}", remote_endpoint_str_, ec.message());
+            close_session(); // 寫入失敗也關閉 session
+            return; // 發生錯誤，不再繼續寫入
+        }
 
-                // 繼續寫入佇列中的下一個封包
-                start_packet_write();
-            }));
+        // 寫入成功，釋放已傳送的封包；若送出的是重播區塊，接著排入下一塊
+        bool replay_chunk_sent = false;
+        for (const auto& packet : in_flight_packets_) {
+            replay_chunk_sent |= packet.replay;
+        }
+        in_flight_packets_.clear();
+        coalesce_lease_.reset();
+        if (sample_ && sample_->has(FrameStamp::WRITE_STARTED)) {
+            sample_->stamp(FrameStamp::WRITTEN);
+            finish_sample();
+        }
+        if (replay_chunk_sent && replay_active_) {
+            queue_next_replay_chunk();
+        }
+        if (close_after_write_ && write_scheduler_.empty()) {
+            write_in_progress_ = false;
+            close_session();
+            return;
+        }
+
+        // 繼續寫入佇列中的下一批封包
+        start_packet_write();
+    }
+
+    // 開始取樣下一個讀到的訊框 (只在被取樣時配置)
+    void begin_sample() {
+        if (latency_connection_id_ == 0) {
+            latency_connection_id_ = services_->latency_tracer->next_connection_id();
+        }
+        sample_ = std::make_unique<FrameSample>();
+        sample_->connection_id = latency_connection_id_;
+        sample_->stamp(FrameStamp::READ_READY);
+        sampling_read_ = true;
+    }
+
+    // 樣本完成：各階段耗時列入統計數據，樣本交給追蹤器保存
+    void finish_sample() {
+        for (std::size_t stage = 0; stage < FRAME_STAGE_COUNT; ++stage) {
+            const int64_t ns = sample_->stage_ns(stage);
+            if (ns >= 0) metrics_->frame_stage_latency[stage].record(static_cast<uint64_t>(ns));
+        }
+        services_->latency_tracer->record(*sample_);
+        sample_.reset();
     }
 
-    asio::ssl::stream<tcp::socket> stream_;
+    // 沒有寫入進行中時歸還寫入路徑的儲存空間
+    void release_write_memory() {
+        write_scheduler_.release_memory();
+        if (in_flight_packets_.capacity() != 0) std::vector<OutPacket>().swap(in_flight_packets_);
+        if (coalesce_buffer_.capacity() != 0) std::vector<char>().swap(coalesce_buffer_);
+        if (write_buffers_.capacity() != 0) std::vector<asio::const_buffer>().swap(write_buffers_);
+    }
+
+    // 單次合併寫入的上限，對應一個 TLS record 的最大明文長度
+    static constexpr std::size_t max_coalesced_write_bytes = 16384;
+    // 每個重播區塊的大小上限 (大於合併上限，因此重播區塊總是單獨、零複製地寫出)
+    static constexpr std::size_t max_replay_chunk_bytes = 65536;
+
+    SessionStream stream_; // TLS over TCP，或本機的 Unix domain socket
     // 為每個 Session 建立一個 strand 來保證其操作的序列化
     asio::strand<asio::any_io_executor> strand_;
+    asio::strand<asio::any_io_executor> handshake_strand_; // TLS 交握使用的 strand
     std::string remote_endpoint_str_; // 儲存客戶端端點資訊
-    std::array<char, 1024> read_buffer_; // 用於接收原始資料的緩衝區
+    std::shared_ptr<char> read_block_; // 讀取期間才借用的緩衝區 (閒置時為空)；回音封包可以直接引用其中的訊框
+    const FrameView* current_frame_ = nullptr; // 正在分派的訊框 (原樣回音用)
+    std::shared_ptr<char> current_frame_owner_; // 訊框位於讀取緩衝區時，持有該緩衝區
+    bool dispatching_ = false; // 正在分派同一次讀取中的訊框
     FrameParser parser_; // Session 包含一個 FrameParser 成員
-    std::deque<std::vector<char>> write_packets_; // 寫入封包的佇列
+    WriteScheduler write_scheduler_; // 依優先等級排程的寫入佇列
+    std::vector<OutPacket> in_flight_packets_; // 正在寫出的這一批封包
+    BufferPool::Lease coalesce_lease_; // 合併多個封包用的連續緩衝區 (寫入期間才借用)
+    std::vector<char> coalesce_buffer_; // 合併後超過池緩衝區大小時使用
+    std::vector<asio::const_buffer> write_buffers_; // Unix domain socket 一次寫出的 buffer 序列
+    bool write_in_progress_ = false; // 是否有寫入正在進行
     bool is_closing_; // 是否正在關閉
+    bool replay_active_ = false; // 是否正在重播訊息日誌
+    uint64_t replay_offset_ = 0; // 下一個要重播的 offset
+    std::vector<std::string> subscribed_topics_; // 已訂閱的主題
+    bool is_peer_ = false; // 是否為其他節點連進來的聯邦連線
+    bool in_batch_ = false; // 是否正在分派批次中的子訊息
+    bool close_after_write_ = false; // 佇列中的回覆寫完後關閉連線 (例如認證失敗)
+    static constexpr uint32_t max_pending_jobs = 64; // 每條連線同時交給工作執行緒的請求數上限
+    uint32_t pending_jobs_ = 0; // 已交給工作執行緒、尚未回覆的請求數
+    bool reads_parked_ = false; // 因為 pending_jobs_ 達到上限而暫停讀取
+    uint32_t trace_connection_id_ = 0; // 流量軌跡中的連線 ID；0 表示未錄製
+    RateLimiter rate_limiter_; // 速率限制 (未設定時不做任何檢查)
+    std::unique_ptr<asio::steady_timer> throttle_timer_; // 被限制時用來延後下一次讀取
+    std::unique_ptr<FrameSample> sample_; // 正在追蹤的延遲樣本 (未取樣時為空)
+    uint32_t latency_connection_id_ = 0; // 延遲追蹤檔中的連線 ID (第一次被取樣時分配)
+    bool sampling_read_ = false; // 這次讀取中的第一個訊框要被取樣
+    bool sampling_frame_ = false; // 正在分派被取樣的訊框，它的第一個回覆要被標記
+    struct AuthState {
+        bool authenticated = false;
+        std::string subject; // token 代表的身分
+    } auth_;
+    std::shared_ptr<const SessionServices> services_; // 共用的服務與設定
     std::shared_ptr<spdlog::logger> logger_; // 用於記錄日誌
+    std::shared_ptr<ServerMetrics> metrics_; // 伺服器統計數據
 
 };
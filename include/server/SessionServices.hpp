@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <asio.hpp>
+#include "utils/Logger.hpp"
+#include "server/ServerConfig.hpp"
+#include "server/ServerMetrics.hpp"
+#include "storage/MessageLog.hpp"
+#include "storage/TraceFile.hpp"
+#include "server/TopicRegistry.hpp"
+#include "server/Federation.hpp"
+#include "server/RateLimiter.hpp"
+#include "server/LatencyTracer.hpp"
+#include "auth/TokenAuthenticator.hpp"
+
+// 由 ServerRunner 建立、所有 Session 共用的服務與設定
+// 新增跨 Session 的功能時在此加入欄位，避免 Server / Session 的建構參數不斷增加
+struct SessionServices {
+    std::shared_ptr<spdlog::logger> logger;
+    std::shared_ptr<ServerMetrics> metrics;
+    ServerConfig config;
+
+    // 若有設定，TLS 交握會在這個 executor (保留的交握執行緒) 上進行
+    std::optional<asio::any_io_executor> handshake_executor;
+
+    // 若有設定，耗用 CPU 的指令會在這個 executor (工作執行緒) 上執行，回覆再送回 Session 的 strand
+    std::optional<asio::any_io_executor> worker_executor;
+
+    // 已發布訊息的持久化日誌；未啟用時為空
+    std::shared_ptr<MessageLog> message_log;
+
+    // token 認證；未啟用時為空，所有連線視為已認證
+    std::shared_ptr<TokenAuthenticator> authenticator;
+
+    // 本節點的主題訂閱表
+    std::shared_ptr<TopicRegistry> topics;
+
+    // 多節點聯邦；沒有設定任何 peer 時為空
+    std::shared_ptr<Federation> federation;
+
+    // 流量軌跡錄製 (每個收到的訊框一筆紀錄)；未啟用時為空
+    std::shared_ptr<TraceRecorder> trace;
+
+    // 每個來源 IP 共用的速率限制令牌桶；沒有設定來源限制時為空
+    std::shared_ptr<SourceRateLimits> source_limits;
+
+    // 逐訊框延遲取樣；未啟用時為空
+    std::shared_ptr<LatencyTracer> latency_tracer;
+};
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <asio.hpp>
+#include <asio/ssl.hpp>
+#include "server/KernelTls.hpp"
+#if defined(ASIO_HAS_LOCAL_SOCKETS)
+#include <sys/socket.h>
+#endif
+
+using asio::ip::tcp;
+
+// Unix domain socket 對端行程的身分 (由核心在連線時記錄，對端無法偽造)
+struct PeerCredentials {
+    int64_t pid = -1;
+    int64_t uid = -1;
+    int64_t gid = -1;
+
+    bool known() const { return uid >= 0; }
+};
+
+#if defined(ASIO_HAS_LOCAL_SOCKETS)
+// 讀取對端的 SO_PEERCRED；平台不支援或失敗時回傳未知的身分
+inline PeerCredentials read_peer_credentials(asio::local::stream_protocol::socket& socket) {
+    PeerCredentials credentials;
+#if defined(SO_PEERCRED)
+    struct ucred cred {};
+    socklen_t length = sizeof(cred);
+    if (::getsockopt(socket.native_handle(), SOL_SOCKET, SO_PEERCRED, &cred, &length) == 0) {
+        credentials.pid = cred.pid;
+        credentials.uid = cred.uid;
+        credentials.gid = cred.gid;
+    }
+#else
+    (void)socket;
+#endif
+    return credentials;
+}
+#endif
+
+/**
+ * @brief Session 使用的連線：TCP 上的 TLS，或同一台主機上的 Unix domain socket (不加密)
+ *
+ * 兩種連線說同樣的訊框協定、走同樣的分派流程，只有建立連線 (TLS 交握) 與關閉的方式不同。
+ * Unix domain socket 的信任來自 socket 檔案的權限與核心提供的對端身分 (SO_PEERCRED)，
+ * 不需要 TLS，也不經過 TCP 協定堆疊。
+ *
+ * TLS 連線可以在交握後把寫入方向的加密交給核心 (kTLS)：之後寫入直接交給 TCP socket，
+ * 讀取仍由 OpenSSL 解密。
+ *
+ * 符合 asio 的 AsyncReadStream / AsyncWriteStream，可以直接交給 asio::async_write；
+ * 每次操作只多一個分支判斷。
+ */
+class SessionStream {
+public:
+    using executor_type = asio::any_io_executor;
+
+    explicit SessionStream(asio::ssl::stream<tcp::socket> tls) : tls_(std::move(tls)) {}
+
+#if defined(ASIO_HAS_LOCAL_SOCKETS)
+    SessionStream(asio::local::stream_protocol::socket socket, PeerCredentials credentials)
+        : local_(std::move(socket)), credentials_(credentials) {}
+#endif
+
+    executor_type get_executor() {
+#if defined(ASIO_HAS_LOCAL_SOCKETS)
+        if (local_) return local_->get_executor();
+#endif
+        return tls_->get_executor();
+    }
+
+    // 是否需要 TLS 交握 (TCP 連線)
+    bool is_tls() const { return tls_.has_value(); }
+
+    // 寫入是否可以一次交出整個 buffer 序列 (Unix domain socket，或寫入方向已由核心加密)
+    bool gather_writes() const { return !tls_ || kernel_tx_; }
+
+    // 交握完成後嘗試把寫入方向的加密交給核心；失敗時連線維持原本的 user-space TLS
+    KernelTlsStatus enable_kernel_tx() {
+        if (!tls_) return KernelTlsStatus::PROTOCOL_UNSUPPORTED;
+        const auto status = KernelTls::enable_tx(tls_->native_handle(), tls_->next_layer().native_handle());
+        kernel_tx_ = status == KernelTlsStatus::ENABLED;
+        return status;
+    }
+
+    // Unix domain socket 對端的身分；TCP 連線為未知
+    const PeerCredentials& peer_credentials() const { return credentials_; }
+
+    template <typename Handler>
+    void async_handshake(Handler&& handler) {
+        tls_->async_handshake(asio::ssl::stream_base::server, std::forward<Handler>(handler));
+    }
+
+    // OpenSSL 內部是否還有已收到但尚未交給我們的資料 (此時 socket 不一定會再變成可讀)
+    bool has_buffered_data() {
+        if (!tls_) return false;
+        SSL* ssl = tls_->native_handle();
+        return SSL_pending(ssl) > 0 || BIO_ctrl_pending(SSL_get_rbio(ssl)) > 0;
+    }
+
+    // 等待 socket 變成可讀 (不讀取資料)
+    template <typename Handler>
+    void async_wait_read(Handler&& handler) {
+#if defined(ASIO_HAS_LOCAL_SOCKETS)
+        if (local_) {
+            local_->async_wait(asio::socket_base::wait_read, std::forward<Handler>(handler));
+            return;
+        }
+#endif
+        tls_->next_layer().async_wait(tcp::socket::wait_read, std::forward<Handler>(handler));
+    }
+
+    template <typename MutableBufferSequence, typename Handler>
+    void async_read_some(const MutableBufferSequence& buffers, Handler&& handler) {
+#if defined(ASIO_HAS_LOCAL_SOCKETS)
+        if (local_) {
+            local_->async_read_some(buffers, std::forward<Handler>(handler));
+            return;
+        }
+#endif
+        tls_->async_read_some(buffers, std::forward<Handler>(handler));
+    }
+
+    // Unix domain socket 與 kTLS 一次寫出整個 buffer 序列 (writev)；ssl::stream 每次只加密第一個 buffer
+    template <typename ConstBufferSequence, typename Handler>
+    void async_write_some(const ConstBufferSequence& buffers, Handler&& handler) {
+#if defined(ASIO_HAS_LOCAL_SOCKETS)
+        if (local_) {
+            local_->async_write_some(buffers, std::forward<Handler>(handler));
+            return;
+        }
+#endif
+        if (kernel_tx_) {
+            tls_->next_layer().async_write_some(buffers, std::forward<Handler>(handler));
+            return;
+        }
+        tls_->async_write_some(buffers, std::forward<Handler>(handler));
+    }
+
+    bool is_open() const {
+#if defined(ASIO_HAS_LOCAL_SOCKETS)
+        if (local_) return local_->is_open();
+#endif
+        return tls_->lowest_layer().is_open();
+    }
+
+    // TLS 連線送出 close_notify；Unix domain socket 直接關閉雙向
+    // 寫入方向已交給核心時，OpenSSL 不能再寫出任何 record，close_notify 改由核心加密送出
+    template <typename Handler>
+    void async_shutdown(Handler&& handler) {
+#if defined(ASIO_HAS_LOCAL_SOCKETS)
+        if (local_) {
+            asio::error_code ec;
+            local_->shutdown(asio::socket_base::shutdown_both, ec);
+            asio::post(local_->get_executor(), [handler = std::forward<Handler>(handler), ec]() mutable { handler(ec); });
+            return;
+        }
+#endif
+        if (kernel_tx_) {
+            KernelTls::send_close_notify(tls_->next_layer().native_handle());
+            asio::error_code ec;
+            tls_->next_layer().shutdown(tcp::socket::shutdown_both, ec);
+            asio::post(tls_->get_executor(), [handler = std::forward<Handler>(handler), ec]() mutable { handler(ec); });
+            return;
+        }
+        tls_->async_shutdown(std::forward<Handler>(handler));
+    }
+
+    // 日誌中顯示的對端 (IP:埠，或 Unix domain socket 對端的 pid 與 uid)
+    std::string remote_endpoint_string() {
+        if (!tls_) {
+            return "unix:pid=" + std::to_string(credentials_.pid) + ",uid=" + std::to_string(credentials_.uid);
+        }
+        asio::error_code ec;
+        const auto endpoint = tls_->lowest_layer().remote_endpoint(ec);
+        // 在 SSL 交握前獲取端點可能會失敗，這在某些平台上是正常的
+        return ec ? std::string("unknown") : endpoint.address().to_string() + ":" + std::to_string(endpoint.port());
+    }
+
+    // 來源 (不含埠號)，同一來源的連線共用速率限制；Unix domain socket 以對端的 uid 為來源
+    std::string remote_address_string() {
+        if (!tls_) return "unix:uid=" + std::to_string(credentials_.uid);
+        asio::error_code ec;
+        const auto endpoint = tls_->lowest_layer().remote_endpoint(ec);
+        return ec ? std::string("unknown") : endpoint.address().to_string();
+    }
+
+private:
+    std::optional<asio::ssl::stream<tcp::socket>> tls_;
+#if defined(ASIO_HAS_LOCAL_SOCKETS)
+    std::optional<asio::local::stream_protocol::socket> local_;
+#endif
+    PeerCredentials credentials_;
+    bool kernel_tx_ = false; // 寫入方向已由核心加密 (kTLS)
+};
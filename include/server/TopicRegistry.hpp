@@ -0,0 +1,124 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <shared_mutex>
+#include <functional>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include "server/WriteScheduler.hpp"
+
+// 可以接收主題訊息的對象 (Session)
+class TopicSubscriber {
+public:
+    virtual ~TopicSubscriber() = default;
+
+    // 將一個已編碼完成的訊框排入寫出佇列；frame 由所有接收者共用，不會被複製
+    // 可由任何執行緒呼叫，實作必須自行切換到所屬的 strand
+    virtual void deliver(std::shared_ptr<const std::vector<char>> frame, PriorityClass priority) = 0;
+};
+
+// 取出 CMD_PUBLISH_MESSAGE 承載資料中的主題名稱
+// 格式為「主題 + '\0' + 內容」；沒有 '\0' 的訊息屬於預設主題 (空字串)
+inline std::string publish_topic(const char* payload, std::size_t size) {
+    const char* end = static_cast<const char*>(std::memchr(payload, '\0', size));
+    return end ? std::string(payload, end) : std::string();
+}
+
+// 本節點的主題訂閱表，可由所有 io 執行緒同時存取
+//
+// 發布時只持有共享鎖 (shared lock)，訂閱與取消訂閱才需要獨占鎖。
+// 某個主題的第一個訂閱者出現或最後一個訂閱者離開時會呼叫 interest callback，
+// 讓聯邦 (Federation) 通知其他節點是否需要轉送這個主題。
+class TopicRegistry {
+public:
+    // (topic, interested)：interested 為 true 表示本節點開始需要這個主題
+    using InterestCallback = std::function<void(const std::string&, bool)>;
+
+    // 必須在開始服務之前設定。callback 會在持有獨占鎖時被呼叫 (確保新增/移除的通知順序)，
+    // 因此不可阻塞，也不可再呼叫 TopicRegistry
+    void set_interest_callback(InterestCallback callback) {
+        interest_callback_ = std::move(callback);
+    }
+
+    void subscribe(const std::string& topic, const std::shared_ptr<TopicSubscriber>& subscriber) {
+        std::unique_lock lock(mutex_);
+        auto& subscribers = topics_[topic];
+        for (const auto& entry : subscribers) {
+            if (entry.key == subscriber.get()) return; // 已經訂閱過
+        }
+        subscribers.push_back({subscriber.get(), subscriber});
+        if (subscribers.size() == 1 && interest_callback_) {
+            interest_callback_(topic, true);
+        }
+    }
+
+    // 移除訂閱者的所有訂閱 (Session 解構時呼叫，此時 weak_ptr 已失效，因此以指標比對)
+    void unsubscribe(const TopicSubscriber* subscriber, const std::vector<std::string>& topics) {
+        std::unique_lock lock(mutex_);
+        for (const auto& topic : topics) {
+            auto it = topics_.find(topic);
+            if (it == topics_.end()) continue;
+            auto& subscribers = it->second;
+            subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(),
+                                             [&](const Entry& entry) { return entry.key == subscriber; }),
+                              subscribers.end());
+            if (subscribers.empty()) {
+                topics_.erase(it);
+                if (interest_callback_) interest_callback_(topic, false);
+            }
+        }
+    }
+
+    // 將訊框送給主題的所有本地訂閱者 (exclude 除外)，回傳送出的份數
+    std::size_t publish(const std::string& topic, const std::shared_ptr<const std::vector<char>>& frame,
+                        PriorityClass priority, const TopicSubscriber* exclude = nullptr) {
+        std::vector<std::shared_ptr<TopicSubscriber>> targets;
+        {
+            std::shared_lock lock(mutex_);
+            auto it = topics_.find(topic);
+            if (it == topics_.end()) return 0;
+            targets.reserve(it->second.size());
+            for (const auto& entry : it->second) {
+                if (entry.key == exclude) continue;
+                if (auto subscriber = entry.subscriber.lock()) {
+                    targets.push_back(std::move(subscriber));
+                }
+            }
+        }
+        // 在鎖外送出並釋放 shared_ptr：最後一個參考可能觸發 Session 解構，而解構時需要獨占鎖
+        for (const auto& subscriber : targets) {
+            subscriber->deliver(frame, priority);
+        }
+        return targets.size();
+    }
+
+    // 在獨占鎖內取得目前所有有訂閱者的主題，讓呼叫端可以「取得快照並開始接收後續通知」而不遺漏變化
+    void with_topics(const std::function<void(const std::vector<std::string>&)>& fn) const {
+        std::unique_lock lock(mutex_);
+        std::vector<std::string> topics;
+        topics.reserve(topics_.size());
+        for (const auto& [topic, subscribers] : topics_) {
+            topics.push_back(topic);
+        }
+        fn(topics);
+    }
+
+    std::size_t topic_count() const {
+        std::shared_lock lock(mutex_);
+        return topics_.size();
+    }
+
+private:
+    struct Entry {
+        const TopicSubscriber* key;
+        std::weak_ptr<TopicSubscriber> subscriber;
+    };
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, std::vector<Entry>> topics_;
+    InterestCallback interest_callback_;
+};
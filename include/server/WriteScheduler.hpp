@@ -0,0 +1,208 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include "frame/FrameHeader.hpp"
+
+// 寫入優先等級
+// - CONTROL：認證、心跳、訂閱等控制訊框，嚴格優先 (strict priority)，永遠最先送出
+// - STANDARD / BULK：一般與大量資料，以加權公平佇列 (deficit round robin) 分享剩餘頻寬
+enum class PriorityClass : uint8_t {
+    CONTROL = 0,
+    STANDARD = 1,
+    BULK = 2,
+};
+
+inline constexpr std::size_t PRIORITY_CLASS_COUNT = 3;
+
+inline const char* priority_class_name(PriorityClass cls) {
+    switch (cls) {
+        case PriorityClass::CONTROL: return "control";
+        case PriorityClass::STANDARD: return "standard";
+        case PriorityClass::BULK: return "bulk";
+    }
+    return "unknown";
+}
+
+// 每個 CommandID 所屬的優先等級；未列出的指令視為 STANDARD
+inline PriorityClass priority_class_of(uint16_t command_id) {
+    switch (command_id) {
+        case CMD_AUTH_REQUEST:
+        case CMD_AUTH_RESPONSE:
+        case CMD_SUBSCRIBE_TOPIC:
+        case CMD_HEARTBEAT:
+            return PriorityClass::CONTROL;
+        case CMD_PUBLISH_MESSAGE:
+        case CMD_REPLAY_RESPONSE: // 重播結束標記必須排在重播資料之後
+            return PriorityClass::BULK;
+        default:
+            return PriorityClass::STANDARD;
+    }
+}
+
+// 待寫出的封包
+struct OutPacket {
+    std::vector<char> data; // 封包自有的資料
+    // 零複製：資料位於外部共享的記憶體 (例如訊息日誌的映射頁面)，由 owner 維持其生命週期
+    std::shared_ptr<const void> owner;
+    const char* external_data = nullptr;
+    std::size_t external_size = 0;
+    PriorityClass priority = PriorityClass::STANDARD;
+    std::chrono::steady_clock::time_point enqueued_at;
+    bool replay = false; // 是否為訊息重播的資料區塊
+    bool sampled = false; // 是否為延遲取樣訊框的回覆
+
+    const char* bytes() const { return owner ? external_data : data.data(); }
+    std::size_t size() const { return owner ? external_size : data.size(); }
+};
+
+// 單一優先等級的 FIFO 佇列
+//
+// 以 vector 加上讀取位置實作：預設建構與清空後不持有任何堆積記憶體
+// (libstdc++ 的 std::deque 即使是空的也會配置約 600 位元組)，大量閒置連線的每條佇列都是零成本。
+class PacketQueue {
+public:
+    bool empty() const { return head_ == packets_.size(); }
+    std::size_t size() const { return packets_.size() - head_; }
+    OutPacket& front() { return packets_[head_]; }
+
+    void push_back(OutPacket packet) {
+        // 佇列一直沒有清空時，定期把已取出的前段移除，避免 vector 無限增長 (攤銷 O(1))
+        if (head_ >= 64 && head_ * 2 >= packets_.size()) {
+            packets_.erase(packets_.begin(), packets_.begin() + static_cast<std::ptrdiff_t>(head_));
+            head_ = 0;
+        }
+        packets_.push_back(std::move(packet));
+    }
+
+    void pop_front() {
+        packets_[head_] = OutPacket{}; // 立即釋放封包資料與 owner
+        if (++head_ == packets_.size()) {
+            packets_.clear();
+            head_ = 0;
+        }
+    }
+
+    void clear() {
+        packets_.clear();
+        head_ = 0;
+    }
+
+    // 佇列為空時歸還底層儲存空間
+    void release() {
+        if (empty()) {
+            std::vector<OutPacket>().swap(packets_);
+            head_ = 0;
+        }
+    }
+
+private:
+    std::vector<OutPacket> packets_;
+    std::size_t head_ = 0;
+};
+
+// 單一 Session 的寫入排程器 (非執行緒安全，必須在 Session 的 strand 中使用)
+//
+// 每次寫入時由 collect() 依優先順序挑出一批封包合併成一次寫入：
+// 先取出所有 CONTROL 封包，再以 deficit round robin 依權重輪流取出 STANDARD 與 BULK 封包，
+// 直到達到單次寫入的位元組上限。控制訊框最多只需等待「目前正在寫出的那一批」完成。
+class WriteScheduler {
+public:
+    using DelayCallback = std::function<void(PriorityClass, std::chrono::nanoseconds)>;
+
+    // weights：STANDARD 與 BULK 的權重；quantum_bytes：每一輪每單位權重可送出的位元組數
+    explicit WriteScheduler(std::array<uint32_t, PRIORITY_CLASS_COUNT> weights = {0, 4, 1},
+                            std::size_t quantum_bytes = 4096)
+        : weights_(weights),
+          quantum_bytes_(quantum_bytes) {
+        // 權重為 0 的類別永遠取不到額度，至少給 1
+        for (auto& weight : weights_) {
+            if (weight == 0) weight = 1;
+        }
+    }
+
+    void push(std::vector<char> data, PriorityClass priority) {
+        OutPacket packet;
+        packet.data = std::move(data);
+        packet.priority = priority;
+        push(std::move(packet));
+    }
+
+    void push(OutPacket packet) {
+        packet.enqueued_at = std::chrono::steady_clock::now();
+        queues_[static_cast<std::size_t>(packet.priority)].push_back(std::move(packet));
+    }
+
+    bool empty() const {
+        for (const auto& queue : queues_) {
+            if (!queue.empty()) return false;
+        }
+        return true;
+    }
+
+    void clear() {
+        for (auto& queue : queues_) queue.clear();
+        deficits_.fill(0);
+    }
+
+    // 歸還空佇列的儲存空間 (連線閒置時呼叫)
+    void release_memory() {
+        for (auto& queue : queues_) queue.release();
+    }
+
+    // 依排程順序取出最多 max_bytes 的封包 (至少一個) 附加到 out
+    // on_delay 會收到每個封包的優先等級與排隊時間，用於統計
+    void collect(std::vector<OutPacket>& out, std::size_t max_bytes, const DelayCallback& on_delay = {}) {
+        const auto now = std::chrono::steady_clock::now();
+        std::size_t bytes = 0;
+
+        auto take = [&](PacketQueue& queue) {
+            OutPacket& packet = queue.front();
+            bytes += packet.size();
+            if (on_delay) on_delay(packet.priority, now - packet.enqueued_at);
+            out.push_back(std::move(packet));
+            queue.pop_front();
+        };
+
+        // 1. 嚴格優先：控制訊框全部先送 (控制訊框很小，不受位元組上限限制)
+        auto& control = queues_[static_cast<std::size_t>(PriorityClass::CONTROL)];
+        while (!control.empty()) take(control);
+
+        // 2. 加權公平：deficit round robin
+        //    批次中已有封包時，超過上限的封包留到下一批 (大型的零複製區塊因此會單獨寫出)
+        while (true) {
+            bool any_pending = false;
+            for (std::size_t cls = 1; cls < PRIORITY_CLASS_COUNT; ++cls) {
+                auto& queue = queues_[next_class_];
+                const std::size_t current = next_class_;
+                next_class_ = (next_class_ % (PRIORITY_CLASS_COUNT - 1)) + 1;
+                if (queue.empty()) {
+                    deficits_[current] = 0; // 閒置的類別不累積額度
+                    continue;
+                }
+                any_pending = true;
+                deficits_[current] += weights_[current] * quantum_bytes_;
+                while (!queue.empty()) {
+                    const std::size_t size = queue.front().size();
+                    if (size > deficits_[current]) break;
+                    if (!out.empty() && bytes + size > max_bytes) return; // 這一批已滿
+                    deficits_[current] -= size;
+                    take(queue);
+                }
+                if (queue.empty()) deficits_[current] = 0;
+            }
+            if (!any_pending) return;
+        }
+    }
+
+private:
+    std::array<PacketQueue, PRIORITY_CLASS_COUNT> queues_;
+    std::array<uint32_t, PRIORITY_CLASS_COUNT> weights_;
+    std::array<std::size_t, PRIORITY_CLASS_COUNT> deficits_{};
+    std::size_t quantum_bytes_;
+    std::size_t next_class_ = 1; // 下一個輪到的加權類別 (跳過 CONTROL)
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <stdexcept>
+#include <system_error>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// 以讀寫模式映射到記憶體的檔案 (固定大小)
+// 檔案不存在時會建立並預先配置到 size 位元組；已存在時沿用其原本大小
+class MappedFile {
+public:
+    MappedFile(const std::string& path, std::size_t size) {
+        try {
+            open_and_map(path, size);
+        } catch (...) {
+            release(); // 建構失敗時解構子不會執行，先釋放已取得的資源
+            throw;
+        }
+    }
+
+    ~MappedFile() {
+        release();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    char* data() { return data_; }
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+    // 要求作業系統將已修改的頁面寫回磁碟 (非同步，不等待完成)
+    void flush_async() {
+#if defined(_WIN32)
+        FlushViewOfFile(data_, 0);
+#else
+        ::msync(data_, size_, MS_ASYNC);
+#endif
+    }
+
+private:
+    void open_and_map(const std::string& path, std::size_t size) {
+#if defined(_WIN32)
+        file_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                            OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) throw_last_error("CreateFile " + path);
+
+        LARGE_INTEGER existing{};
+        GetFileSizeEx(file_, &existing);
+        size_ = existing.QuadPart > 0 ? static_cast<std::size_t>(existing.QuadPart) : size;
+
+        const auto high = static_cast<DWORD>(static_cast<unsigned long long>(size_) >> 32);
+        const auto low = static_cast<DWORD>(size_ & 0xFFFFFFFFull);
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READWRITE, high, low, nullptr);
+        if (!mapping_) throw_last_error("CreateFileMapping " + path);
+
+        data_ = static_cast<char*>(MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, size_));
+        if (!data_) throw_last_error("MapViewOfFile " + path);
+#else
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd_ < 0) throw_last_error("open " + path);
+
+        struct stat st {};
+        ::fstat(fd_, &st);
+        size_ = st.st_size > 0 ? static_cast<std::size_t>(st.st_size) : size;
+        if (st.st_size == 0 && ::ftruncate(fd_, static_cast<off_t>(size_)) != 0) {
+            throw_last_error("ftruncate " + path);
+        }
+
+        void* addr = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (addr == MAP_FAILED) throw_last_error("mmap " + path);
+        data_ = static_cast<char*>(addr);
+#endif
+    }
+
+    void release() {
+#if defined(_WIN32)
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (data_) ::munmap(data_, size_);
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+#endif
+        data_ = nullptr;
+    }
+
+    [[noreturn]] static void throw_last_error(const std::string& what) {
+#if defined(_WIN32)
+        throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), what);
+#else
+        throw std::system_error(errno, std::generic_category(), what);
+#endif
+    }
+
+    char* data_ = nullptr;
+    std::size_t size_ = 0;
+#if defined(_WIN32)
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
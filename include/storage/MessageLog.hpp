@@ -0,0 +1,379 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include "frame/FrameHeader.hpp"
+#include "storage/MappedFile.hpp"
+#include "utils/Logger.hpp"
+
+/**
+ * @brief 以記憶體映射檔案實作的僅附加 (append-only) 訊息日誌
+ *
+ * - 訊息以「已編碼完成的訊框」(FrameHeader + Payload) 原樣儲存，重播時不需重新編碼
+ * - 日誌切分為多個固定大小的區段 (segment) 檔案，檔名為該區段第一則訊息的 offset
+ * - offset 是訊息的流水號；每個區段每隔 index_interval 則訊息記錄一次 (offset, 檔案位置)，
+ *   形成稀疏索引，查詢時先二分搜尋索引，再沿著訊框長度往後走
+ * - 附加由專用執行緒完成，io 執行緒只需把訊框放入待寫佇列
+ */
+
+class LogSegment;
+
+// 一段可直接寫入 socket 的重播資料，指向映射的頁面 (零複製)
+struct ReplayChunk {
+    std::shared_ptr<const LogSegment> segment; // 持有區段，確保映射在寫出前保持有效
+    const char* data = nullptr;
+    std::size_t size = 0;
+    uint64_t first_offset = 0;   // 第一則訊息的 offset
+    uint64_t next_offset = 0;    // 下一次讀取應使用的 offset
+    std::size_t message_count = 0;
+};
+
+class LogSegment {
+public:
+    LogSegment(const std::filesystem::path& path, uint64_t base_offset, std::size_t capacity, uint32_t index_interval)
+        : path_(path),
+          base_offset_(base_offset),
+          index_interval_(std::max<uint32_t>(1, index_interval)),
+          file_(std::make_unique<MappedFile>(path.string(), capacity)) {}
+
+    ~LogSegment() {
+        if (deleted_) {
+            // 先解除映射再刪除檔案 (Windows 無法刪除仍在映射中的檔案)
+            file_.reset();
+            std::error_code ec;
+            std::filesystem::remove(path_, ec);
+        }
+    }
+
+    uint64_t base_offset() const { return base_offset_; }
+    uint64_t end_offset() const { return base_offset_ + committed_count_.load(std::memory_order_acquire); }
+    std::size_t capacity() const { return file_->size(); }
+
+    // --- 以下僅由附加執行緒呼叫 ---
+
+    bool has_room(std::size_t size) const { return write_pos_ + size <= file_->size(); }
+
+    void append(const char* frame, std::size_t size) {
+        char* dst = file_->data() + write_pos_;
+        // 先寫入長度以外的內容，最後才寫入 total_length：
+        // 行程中途崩潰時，復原程序看到非零長度就代表該訊框已完整寫入
+        std::memcpy(dst + sizeof(uint32_t), frame + sizeof(uint32_t), size - sizeof(uint32_t));
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(dst, frame, sizeof(uint32_t));
+
+        if (count_ % index_interval_ == 0) {
+            std::lock_guard<std::mutex> lock(index_mutex_);
+            index_.push_back({base_offset_ + count_, write_pos_});
+        }
+        write_pos_ += size;
+        ++count_;
+
+        // 先公開位元組數再公開訊息數，讀取端依相反順序讀取即可得到一致的視圖
+        committed_bytes_.store(write_pos_, std::memory_order_release);
+        committed_count_.store(count_, std::memory_order_release);
+    }
+
+    // 重新開啟既有的區段時，掃描訊框以重建寫入位置與稀疏索引
+    void recover() {
+        const char* data = file_->data();
+        while (write_pos_ + sizeof(FrameHeader) <= file_->size()) {
+            FrameHeader header;
+            std::memcpy(&header, data + write_pos_, sizeof(FrameHeader));
+            decode_header(header);
+            if (header.total_length < sizeof(FrameHeader) || write_pos_ + header.total_length > file_->size()) {
+                break; // 0 代表尚未使用的空間；其他不合法的長度視為損毀的尾端
+            }
+            if (count_ % index_interval_ == 0) {
+                index_.push_back({base_offset_ + count_, write_pos_});
+            }
+            write_pos_ += header.total_length;
+            ++count_;
+        }
+        committed_bytes_.store(write_pos_, std::memory_order_release);
+        committed_count_.store(count_, std::memory_order_release);
+    }
+
+    void flush_async() { file_->flush_async(); }
+
+    // 標記為已刪除：最後一個持有者釋放後才真正刪除檔案
+    void mark_deleted() { deleted_ = true; }
+
+    // --- 讀取端 (任何執行緒) ---
+
+    // 讀取從 offset 開始、總長度最多 max_bytes 的完整訊框 (至少一則)
+    // offset 必須位於 [base_offset, end_offset) 之內
+    std::size_t locate(uint64_t offset, std::size_t max_bytes, const char*& out_data, std::size_t& out_count) const {
+        const uint64_t count = committed_count_.load(std::memory_order_acquire);
+        const std::size_t committed = committed_bytes_.load(std::memory_order_acquire);
+        const char* data = file_->data();
+
+        // 1. 二分搜尋稀疏索引，找到 offset 之前最近的索引點
+        uint64_t current = base_offset_;
+        std::size_t pos = 0;
+        {
+            std::lock_guard<std::mutex> lock(index_mutex_);
+            auto it = std::upper_bound(index_.begin(), index_.end(), offset,
+                                       [](uint64_t value, const IndexEntry& entry) { return value < entry.offset; });
+            if (it != index_.begin()) {
+                --it;
+                current = it->offset;
+                pos = it->position;
+            }
+        }
+
+        // 2. 沿著訊框長度往後走到目標 offset
+        while (current < offset && current < base_offset_ + count) {
+            pos += frame_length_at(data + pos);
+            ++current;
+        }
+
+        // 3. 收集完整訊框直到達到位元組上限
+        const std::size_t start = pos;
+        out_count = 0;
+        while (current < base_offset_ + count && pos < committed) {
+            const std::size_t length = frame_length_at(data + pos);
+            if (out_count > 0 && pos + length - start > max_bytes) break;
+            pos += length;
+            ++current;
+            ++out_count;
+        }
+        out_data = data + start;
+        return pos - start;
+    }
+
+private:
+    struct IndexEntry {
+        uint64_t offset;
+        std::size_t position;
+    };
+
+    static std::size_t frame_length_at(const char* p) {
+        uint32_t length;
+        std::memcpy(&length, p, sizeof(length));
+        return asio::detail::socket_ops::network_to_host_long(length);
+    }
+
+    std::filesystem::path path_;
+    uint64_t base_offset_;
+    uint32_t index_interval_;
+    std::unique_ptr<MappedFile> file_;
+
+    // 附加執行緒私有的狀態
+    std::size_t write_pos_ = 0;
+    uint64_t count_ = 0;
+
+    // 提供給讀取端的已提交狀態
+    std::atomic<std::size_t> committed_bytes_{0};
+    std::atomic<uint64_t> committed_count_{0};
+
+    mutable std::mutex index_mutex_;
+    std::vector<IndexEntry> index_;
+    bool deleted_ = false;
+};
+
+class MessageLog {
+public:
+    struct Options {
+        std::string directory;
+        std::size_t segment_bytes = 64 * 1024 * 1024; // 每個區段檔案的大小
+        uint32_t index_interval = 64;                  // 稀疏索引的間隔 (訊息數)
+        std::size_t max_segments = 0;                  // 保留的區段數上限，0 表示不限制
+        std::size_t max_pending_bytes = 64 * 1024 * 1024; // 待寫佇列的上限，超過時丟棄新的訊息
+    };
+
+    MessageLog(Options options, std::shared_ptr<spdlog::logger> logger)
+        : options_(std::move(options)),
+          logger_(logger) {
+        std::filesystem::create_directories(options_.directory);
+        open_existing_segments();
+        if (segments_.empty()) {
+            roll_segment(0);
+        }
+        logger_->info("Message log opened at {}: offsets [{}, {}), {} segment(s)",
+                      options_.directory, first_offset(), next_offset(), segments_.size());
+        appender_ = std::thread([this] { append_loop(); });
+    }
+
+    ~MessageLog() {
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            stopping_ = true;
+        }
+        pending_cv_.notify_one();
+        if (appender_.joinable()) appender_.join();
+
+        std::lock_guard<std::mutex> lock(segments_mutex_);
+        for (auto& segment : segments_) segment->flush_async();
+    }
+
+    MessageLog(const MessageLog&) = delete;
+    MessageLog& operator=(const MessageLog&) = delete;
+
+    // 將一個已編碼的訊框排入待寫佇列 (不等待寫入完成)
+    // 與回音、訂閱者共用同一份訊框，呼叫端只增加引用計數，不複製
+    // 只在放入佇列時短暫持有鎖；佇列超過上限時丟棄並回傳 false
+    bool append(std::shared_ptr<const std::vector<char>> frame) {
+        if (frame->size() < sizeof(FrameHeader) || frame->size() > options_.segment_bytes) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            if (pending_bytes_ + frame->size() > options_.max_pending_bytes) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            pending_bytes_ += frame->size();
+            pending_.push_back(std::move(frame));
+        }
+        pending_cv_.notify_one();
+        return true;
+    }
+
+    // 等待目前所有待寫的訊息都寫入映射檔案 (測試與效能測試使用)
+    void sync() {
+        std::unique_lock<std::mutex> lock(pending_mutex_);
+        drained_cv_.wait(lock, [this] { return pending_.empty() && !writing_; });
+    }
+
+    // 讀取從 offset 開始的資料，最多 max_bytes (至少一則完整訊息)
+    // offset 早於最舊的區段時從最舊的訊息開始；沒有新資料時回傳 size == 0 的區塊
+    ReplayChunk read(uint64_t offset, std::size_t max_bytes) const {
+        std::shared_ptr<LogSegment> segment;
+        {
+            std::lock_guard<std::mutex> lock(segments_mutex_);
+            if (segments_.empty()) return ReplayChunk{};
+            offset = std::max(offset, segments_.front()->base_offset());
+            // 找到 base_offset <= offset 的最後一個區段
+            auto it = std::upper_bound(segments_.begin(), segments_.end(), offset,
+                                       [](uint64_t value, const std::shared_ptr<LogSegment>& s) {
+                                           return value < s->base_offset();
+                                       });
+            segment = *(--it);
+        }
+
+        ReplayChunk chunk;
+        chunk.first_offset = offset;
+        chunk.next_offset = offset;
+        if (offset >= segment->end_offset()) {
+            return chunk; // 已追上最新的訊息
+        }
+        chunk.size = segment->locate(offset, max_bytes, chunk.data, chunk.message_count);
+        chunk.next_offset = offset + chunk.message_count;
+        chunk.segment = std::move(segment);
+        return chunk;
+    }
+
+    uint64_t first_offset() const {
+        std::lock_guard<std::mutex> lock(segments_mutex_);
+        return segments_.empty() ? 0 : segments_.front()->base_offset();
+    }
+
+    // 下一則訊息將使用的 offset (已提交的訊息數)
+    uint64_t next_offset() const {
+        std::lock_guard<std::mutex> lock(segments_mutex_);
+        return segments_.empty() ? 0 : segments_.back()->end_offset();
+    }
+
+    uint64_t appended_count() const { return appended_.load(std::memory_order_relaxed); }
+    uint64_t dropped_count() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    void append_loop() {
+        std::vector<std::shared_ptr<const std::vector<char>>> batch;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(pending_mutex_);
+                pending_cv_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+                if (pending_.empty() && stopping_) return;
+                batch.swap(pending_);
+                pending_bytes_ = 0;
+                writing_ = true;
+            }
+
+            for (const auto& frame : batch) {
+                LogSegment* active = segments_.back().get(); // 只有這條執行緒會修改 segments_
+                if (!active->has_room(frame->size())) {
+                    active->flush_async();
+                    roll_segment(active->end_offset());
+                    active = segments_.back().get();
+                }
+                active->append(frame->data(), frame->size());
+            }
+            appended_.fetch_add(batch.size(), std::memory_order_relaxed);
+            batch.clear();
+
+            {
+                std::lock_guard<std::mutex> lock(pending_mutex_);
+                writing_ = false;
+            }
+            drained_cv_.notify_all();
+        }
+    }
+
+    std::filesystem::path segment_path(uint64_t base_offset) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%020llu.log", static_cast<unsigned long long>(base_offset));
+        return std::filesystem::path(options_.directory) / name;
+    }
+
+    // 建立新的區段，並依保留上限移除最舊的區段
+    void roll_segment(uint64_t base_offset) {
+        auto segment = std::make_shared<LogSegment>(segment_path(base_offset), base_offset,
+                                                    options_.segment_bytes, options_.index_interval);
+        std::lock_guard<std::mutex> lock(segments_mutex_);
+        segments_.push_back(std::move(segment));
+        while (options_.max_segments > 0 && segments_.size() > options_.max_segments) {
+            // 仍在重播中的讀取端持有 shared_ptr，檔案會在它們釋放後才被刪除
+            segments_.front()->mark_deleted();
+            segments_.pop_front();
+        }
+    }
+
+    void open_existing_segments() {
+        std::vector<uint64_t> bases;
+        for (const auto& entry : std::filesystem::directory_iterator(options_.directory)) {
+            if (entry.path().extension() != ".log") continue;
+            try {
+                bases.push_back(std::stoull(entry.path().stem().string()));
+            } catch (const std::exception&) {
+                // 忽略不是區段檔的檔案
+            }
+        }
+        std::sort(bases.begin(), bases.end());
+        for (uint64_t base : bases) {
+            auto segment = std::make_shared<LogSegment>(segment_path(base), base,
+                                                        options_.segment_bytes, options_.index_interval);
+            segment->recover();
+            segments_.push_back(std::move(segment));
+        }
+    }
+
+    Options options_;
+    std::shared_ptr<spdlog::logger> logger_;
+
+    mutable std::mutex segments_mutex_; // 保護 segments_ 容器本身 (新增/移除區段)
+    std::deque<std::shared_ptr<LogSegment>> segments_;
+
+    std::mutex pending_mutex_;
+    std::condition_variable pending_cv_;
+    std::condition_variable drained_cv_;
+    std::vector<std::shared_ptr<const std::vector<char>>> pending_;
+    std::size_t pending_bytes_ = 0;
+    bool writing_ = false;
+    bool stopping_ = false;
+
+    std::atomic<uint64_t> appended_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::thread appender_;
+};
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 流量軌跡 (traffic trace) 檔案
+ *
+ * 伺服器端的錄製器 (TraceRecorder) 把每個收到的訊框記錄成一筆固定大小的紀錄，
+ * client-app 的重播模式讀取後依原本的時間與大小重新送出，用於以真實的流量形狀做壓力測試。
+ * 軌跡只記錄時間、連線、指令與大小，不記錄承載資料本身 (不會洩漏 token 或訊息內容)。
+ *
+ * 檔案格式 (所有整數皆為 little endian)：
+ *
+ *     檔頭 16 bytes：magic "HCSTRACE" (8) + 版本 (u32) + 每筆紀錄的大小 (u32)
+ *     紀錄 18 bytes：時間 (u64，自錄製開始的奈秒) + 連線 ID (u32) + 指令 ID (u16) + 承載大小 (u32)
+ *
+ * 指令 ID 0 與 0xFFFF 不是協定中的指令，分別表示連線建立 (交握完成) 與連線關閉。
+ */
+
+struct TraceRecord {
+    uint64_t timestamp_ns = 0;
+    uint32_t connection_id = 0;
+    uint16_t command_id = 0;
+    uint32_t payload_size = 0;
+};
+
+inline constexpr uint16_t TRACE_CONNECTION_OPEN = 0;
+inline constexpr uint16_t TRACE_CONNECTION_CLOSE = 0xFFFF;
+
+namespace trace_format {
+
+inline constexpr char magic[8] = {'H', 'C', 'S', 'T', 'R', 'A', 'C', 'E'};
+inline constexpr uint32_t version = 1;
+inline constexpr std::size_t header_size = 16;
+inline constexpr std::size_t record_size = 18;
+
+inline void put_le(char* out, uint64_t value, std::size_t bytes) {
+    for (std::size_t i = 0; i < bytes; ++i) {
+        out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+inline uint64_t get_le(const char* in, std::size_t bytes) {
+    uint64_t value = 0;
+    for (std::size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+inline void encode(const TraceRecord& record, char* out) {
+    put_le(out, record.timestamp_ns, 8);
+    put_le(out + 8, record.connection_id, 4);
+    put_le(out + 12, record.command_id, 2);
+    put_le(out + 14, record.payload_size, 4);
+}
+
+inline TraceRecord decode(const char* in) {
+    TraceRecord record;
+    record.timestamp_ns = get_le(in, 8);
+    record.connection_id = static_cast<uint32_t>(get_le(in + 8, 4));
+    record.command_id = static_cast<uint16_t>(get_le(in + 12, 2));
+    record.payload_size = static_cast<uint32_t>(get_le(in + 14, 4));
+    return record;
+}
+
+} // namespace trace_format
+
+// 伺服器端的錄製器 (任何執行緒皆可呼叫 record)
+//
+// 紀錄先累積在「記錄時所在執行緒」的緩衝區 (只有寫檔時才會與寫檔的執行緒競爭)，時間在任何鎖之外取得。
+// 某條執行緒的緩衝區滿了時，由它把所有緩衝區的紀錄依時間合併後整批寫入檔案。
+// 重播依檔案順序排程，所以檔案中的時間不能倒退：取得時間後尚未放進緩衝區的紀錄可能晚一點才出現，
+// 因此中途寫檔只寫出比 reorder_window 更早的紀錄，其餘留到下一次；
+// 極少數晚於此窗口才出現的紀錄，時間會被調整成已寫出的最後時間。
+class TraceRecorder {
+public:
+    explicit TraceRecorder(const std::string& path, std::size_t flush_bytes = 64 * 1024)
+        : path_(path),
+          flush_records_(std::max<std::size_t>(flush_bytes / trace_format::record_size, 1)),
+          id_(next_recorder_id().fetch_add(1, std::memory_order_relaxed)),
+          start_(std::chrono::steady_clock::now()) {
+        file_ = std::fopen(path.c_str(), "wb");
+        if (!file_) {
+            throw std::runtime_error("Cannot open trace file " + path);
+        }
+        char header[trace_format::header_size];
+        std::memcpy(header, trace_format::magic, sizeof(trace_format::magic));
+        trace_format::put_le(header + 8, trace_format::version, 4);
+        trace_format::put_le(header + 12, trace_format::record_size, 4);
+        std::fwrite(header, 1, sizeof(header), file_);
+    }
+
+    ~TraceRecorder() {
+        flush();
+        std::fclose(file_);
+    }
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    // 中途寫檔時保留在記憶體中的最近時間範圍
+    static constexpr uint64_t reorder_window_ns = 100'000'000; // 100ms
+
+    // 為新連線分配軌跡中的連線 ID
+    uint32_t next_connection_id() { return next_connection_id_.fetch_add(1, std::memory_order_relaxed); }
+
+    void record(uint32_t connection_id, uint16_t command_id, uint32_t payload_size) {
+        TraceRecord record;
+        record.timestamp_ns = elapsed_ns();
+        record.connection_id = connection_id;
+        record.command_id = command_id;
+        record.payload_size = payload_size;
+
+        Buffer& buffer = local_buffer();
+        bool full = false;
+        {
+            std::lock_guard<std::mutex> lock(buffer.mutex);
+            buffer.records.push_back(record);
+            full = buffer.records.size() >= flush_records_;
+        }
+        recorded_.fetch_add(1, std::memory_order_relaxed);
+        if (full) {
+            write_merged(record.timestamp_ns > reorder_window_ns ? record.timestamp_ns - reorder_window_ns : 0);
+        }
+    }
+
+    // 把所有緩衝區中的紀錄寫入檔案
+    void flush() {
+        write_merged(UINT64_MAX);
+        std::lock_guard<std::mutex> file_lock(file_mutex_);
+        std::fflush(file_);
+    }
+
+    uint64_t recorded() const { return recorded_.load(std::memory_order_relaxed); }
+
+    const std::string& path() const { return path_; }
+
+private:
+    struct Buffer {
+        std::mutex mutex;
+        std::vector<TraceRecord> records;
+    };
+
+    uint64_t elapsed_ns() const {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_).count());
+    }
+
+    // 目前執行緒在這個錄製器中的緩衝區 (第一次記錄時建立並登記)
+    Buffer& local_buffer() {
+        struct Local {
+            uint64_t recorder_id = 0;
+            std::shared_ptr<Buffer> buffer;
+        };
+        thread_local Local local;
+        if (local.recorder_id != id_) {
+            local.buffer = std::make_shared<Buffer>();
+            local.recorder_id = id_;
+            std::lock_guard<std::mutex> lock(buffers_mutex_);
+            buffers_.push_back(local.buffer);
+        }
+        return *local.buffer;
+    }
+
+    // 收集所有緩衝區的紀錄，依時間合併後寫出時間不晚於 cutoff_ns 的部分
+    void write_merged(uint64_t cutoff_ns) {
+        std::lock_guard<std::mutex> file_lock(file_mutex_);
+        {
+            std::lock_guard<std::mutex> lock(buffers_mutex_);
+            for (const auto& buffer : buffers_) {
+                std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+                held_.insert(held_.end(), buffer->records.begin(), buffer->records.end());
+                buffer->records.clear();
+            }
+        }
+        // 同一條執行緒的紀錄時間本來就依序，穩定排序保持它們的相對順序
+        std::stable_sort(held_.begin(), held_.end(), [](const TraceRecord& a, const TraceRecord& b) {
+            return a.timestamp_ns < b.timestamp_ns;
+        });
+        const auto end = std::upper_bound(held_.begin(), held_.end(), cutoff_ns,
+                                          [](uint64_t cutoff, const TraceRecord& r) { return cutoff < r.timestamp_ns; });
+        std::vector<char> out(static_cast<std::size_t>(end - held_.begin()) * trace_format::record_size);
+        char* cursor = out.data();
+        for (auto it = held_.begin(); it != end; ++it) {
+            it->timestamp_ns = std::max(it->timestamp_ns, written_ns_);
+            written_ns_ = it->timestamp_ns;
+            trace_format::encode(*it, cursor);
+            cursor += trace_format::record_size;
+        }
+        held_.erase(held_.begin(), end);
+        std::fwrite(out.data(), 1, out.size(), file_);
+    }
+
+    static std::atomic<uint64_t>& next_recorder_id() {
+        static std::atomic<uint64_t> id{1};
+        return id;
+    }
+
+    std::string path_;
+    const std::size_t flush_records_; // 單一執行緒緩衝區累積到這個筆數時寫檔
+    const uint64_t id_;
+    std::chrono::steady_clock::time_point start_;
+    std::FILE* file_ = nullptr;
+    std::atomic<uint32_t> next_connection_id_{1};
+    std::atomic<uint64_t> recorded_{0};
+
+    std::mutex buffers_mutex_;
+    std::vector<std::shared_ptr<Buffer>> buffers_;
+
+    std::mutex file_mutex_;           // 保護以下成員與檔案
+    std::vector<TraceRecord> held_;   // 已從緩衝區取出、尚未寫出的紀錄 (依時間排序)
+    uint64_t written_ns_ = 0;         // 已寫出的最後時間
+};
+
+// 讀取整個軌跡檔；格式錯誤時拋出例外。檔尾不完整的紀錄 (錄製中途被中斷) 會被忽略
+inline std::vector<TraceRecord> read_trace(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        throw std::runtime_error("Cannot open trace file " + path);
+    }
+    char header[trace_format::header_size];
+    const bool header_ok = std::fread(header, 1, sizeof(header), file) == sizeof(header) &&
+                           std::memcmp(header, trace_format::magic, sizeof(trace_format::magic)) == 0 &&
+                           trace_format::get_le(header + 8, 4) == trace_format::version &&
+                           trace_format::get_le(header + 12, 4) == trace_format::record_size;
+    if (!header_ok) {
+        std::fclose(file);
+        throw std::runtime_error("Not a trace file (or unsupported version): " + path);
+    }
+
+    std::vector<TraceRecord> records;
+    char chunk[trace_format::record_size * 4096];
+    std::size_t length = 0;
+    while ((length = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        for (std::size_t pos = 0; pos + trace_format::record_size <= length; pos += trace_format::record_size) {
+            records.push_back(trace_format::decode(chunk + pos));
+        }
+        if (length % trace_format::record_size != 0) break; // 只有檔尾會讀到不完整的紀錄
+    }
+    std::fclose(file);
+    return records;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+// 每條執行緒各自的固定大小緩衝區池 (不需要鎖)
+//
+// 大量閒置連線不應各自持有讀寫緩衝區：只有在資料到達 (或正在寫出) 時才從目前執行緒的池中借用，
+// 用完立即歸還。緩衝區歸還到「歸還時所在的執行緒」的池，每條執行緒最多快取 max_cached_per_thread 個。
+class BufferPool {
+public:
+    // 一個 TLS record 的最大明文長度：一次讀取最多解密出這麼多資料
+    static constexpr std::size_t buffer_size = 16384;
+    static constexpr std::size_t max_cached_per_thread = 256;
+
+    // 借用中的緩衝區；解構或 reset() 時歸還
+    class Lease {
+    public:
+        Lease() = default;
+        explicit Lease(std::unique_ptr<char[]> buffer) : buffer_(std::move(buffer)) {}
+        Lease(Lease&&) noexcept = default;
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                reset();
+                buffer_ = std::move(other.buffer_);
+            }
+            return *this;
+        }
+        ~Lease() { reset(); }
+
+        char* data() { return buffer_.get(); }
+        static constexpr std::size_t size() { return buffer_size; }
+        explicit operator bool() const { return static_cast<bool>(buffer_); }
+
+        void reset() {
+            if (buffer_) recycle(std::move(buffer_));
+        }
+
+        // 放棄所有權 (交給 acquire_shared 的 shared_ptr 管理)
+        char* release() { return buffer_.release(); }
+
+    private:
+        std::unique_ptr<char[]> buffer_;
+    };
+
+    static Lease acquire() {
+        auto& cache = free_list();
+        if (cache.empty()) {
+            return Lease(std::unique_ptr<char[]>(new char[buffer_size]));
+        }
+        Lease lease(std::move(cache.back()));
+        cache.pop_back();
+        return lease;
+    }
+
+    // 以 shared_ptr 借用，最後一個持有者釋放時才歸還：
+    // 讓待寫出的封包可以直接引用讀取緩衝區中的位元組 (例如原樣回音)
+    static std::shared_ptr<char> acquire_shared() {
+        return std::shared_ptr<char>(acquire().release(), [](char* buffer) {
+            recycle(std::unique_ptr<char[]>(buffer));
+        });
+    }
+
+private:
+    static void recycle(std::unique_ptr<char[]> buffer) {
+        auto& cache = free_list();
+        if (cache.size() < max_cached_per_thread) {
+            cache.push_back(std::move(buffer));
+        }
+    }
+
+    static std::vector<std::unique_ptr<char[]>>& free_list() {
+        thread_local std::vector<std::unique_ptr<char[]>> cache;
+        return cache;
+    }
+};
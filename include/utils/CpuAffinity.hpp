@@ -0,0 +1,126 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <set>
+#include <thread>
+#include <stdexcept>
+#include <filesystem>
+#include <algorithm>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/**
+ * @brief CPU 親和性 (affinity) 與 NUMA 拓撲的輔助函式
+ *
+ * CPU 清單使用與 taskset / numactl 相同的格式，例如 "0-3,8,10-11"。
+ */
+
+// 將 "0-3,8" 這類字串解析為排序後、不重複的 CPU 編號清單
+inline std::vector<int> parse_cpu_list(const std::string& text) {
+    std::set<int> cpus;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        std::size_t comma = text.find(',', pos);
+        if (comma == std::string::npos) comma = text.size();
+        const std::string item = text.substr(pos, comma - pos);
+        pos = comma + 1;
+        if (item.empty()) continue;
+
+        const std::size_t dash = item.find('-');
+        const int first = std::stoi(item.substr(0, dash));
+        const int last = (dash == std::string::npos) ? first : std::stoi(item.substr(dash + 1));
+        if (first < 0 || last < first) {
+            throw std::invalid_argument("Invalid CPU range: " + item);
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.insert(cpu);
+        }
+    }
+    return std::vector<int>(cpus.begin(), cpus.end());
+}
+
+// 將 CPU 清單轉回 "0-3,8" 格式，方便寫入日誌
+inline std::string format_cpu_list(const std::vector<int>& cpus) {
+    std::string out;
+    for (std::size_t i = 0; i < cpus.size(); ++i) {
+        std::size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) ++j;
+        if (!out.empty()) out += ",";
+        out += std::to_string(cpus[i]);
+        if (j > i) out += "-" + std::to_string(cpus[j]);
+        i = j;
+    }
+    return out.empty() ? "any" : out;
+}
+
+// 目前行程被允許使用的 CPU (會反映 taskset 等外部限制)
+inline std::vector<int> available_cpus() {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        std::vector<int> cpus;
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+#endif
+    std::vector<int> cpus(std::max(1u, std::thread::hardware_concurrency()));
+    for (std::size_t i = 0; i < cpus.size(); ++i) cpus[i] = static_cast<int>(i);
+    return cpus;
+}
+
+// 將呼叫端執行緒綁定到指定的 CPU 集合；清單為空時不做任何事
+// 成功回傳 true，平台不支援或系統呼叫失敗時回傳 false
+inline bool pin_current_thread(const std::vector<int>& cpus) {
+    if (cpus.empty()) return true;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus) {
+        if (cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) mask |= (DWORD_PTR(1) << cpu);
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+    return false;
+#endif
+}
+
+// 查詢 CPU 所屬的 NUMA 節點；無法得知時回傳 -1
+inline int numa_node_of_cpu(int cpu) {
+#if defined(__linux__)
+    std::error_code ec;
+    const std::filesystem::path dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        const std::string name = entry.path().filename().string();
+        if (name.rfind("node", 0) == 0 && name.size() > 4) {
+            try {
+                return std::stoi(name.substr(4));
+            } catch (const std::exception&) {
+                return -1;
+            }
+        }
+    }
+#endif
+    (void)cpu;
+    return -1;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <asio.hpp>
+
+// 回傳 asio 在編譯期選定的 socket I/O 後端名稱，用於啟動日誌
+// (ASIO_HAS_IO_URING_AS_DEFAULT 由 asio 在 ASIO_HAS_IO_URING + ASIO_DISABLE_EPOLL 時定義)
+inline const char* io_backend_name() {
+#if defined(ASIO_HAS_IO_URING_AS_DEFAULT)
+    return "io_uring";
+#elif defined(ASIO_HAS_IOCP)
+    return "iocp";
+#elif defined(ASIO_HAS_EPOLL) && defined(ASIO_HAS_IO_URING)
+    return "epoll (io_uring for files only)";
+#elif defined(ASIO_HAS_EPOLL)
+    return "epoll";
+#elif defined(ASIO_HAS_KQUEUE)
+    return "kqueue";
+#elif defined(ASIO_HAS_DEV_POLL)
+    return "/dev/poll";
+#else
+    return "select";
+#endif
+}
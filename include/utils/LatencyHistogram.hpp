@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <bit>
+#include <string>
+#include <sstream>
+#include <charconv>
+
+// 以對數分桶的延遲直方圖 (單位：奈秒)，可由多條執行緒同時記錄
+//
+// 每個 2 的冪次區間再細分為 SUB_BUCKETS 個子桶，相對誤差約 1/SUB_BUCKETS，
+// 記錄只需要一次 relaxed 的 fetch_add，不需要鎖也不會配置記憶體
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 3;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    void record(uint64_t value_ns) {
+        buckets_[bucket_index(value_ns)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        uint64_t prev_max = max_.load(std::memory_order_relaxed);
+        while (value_ns > prev_max &&
+               !max_.compare_exchange_weak(prev_max, value_ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    // 將另一個直方圖的內容累加進來 (例如合併多個執行緒或行程的結果)
+    void merge(const LatencyHistogram& other) {
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            const uint64_t n = other.buckets_[i].load(std::memory_order_relaxed);
+            if (n) buckets_[i].fetch_add(n, std::memory_order_relaxed);
+        }
+        count_.fetch_add(other.count(), std::memory_order_relaxed);
+        uint64_t other_max = other.max();
+        uint64_t prev_max = max_.load(std::memory_order_relaxed);
+        while (other_max > prev_max &&
+               !max_.compare_exchange_weak(prev_max, other_max, std::memory_order_relaxed)) {
+        }
+    }
+
+    // 以文字序列化 (「max 桶索引:次數 ...」，只列出非空的桶)，用於把其他行程的結果傳回來合併
+    std::string serialize() const {
+        std::string out = std::to_string(max());
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            const uint64_t n = buckets_[i].load(std::memory_order_relaxed);
+            if (n) out += " " + std::to_string(i) + ":" + std::to_string(n);
+        }
+        return out;
+    }
+
+    // 將 serialize() 的結果累加進來；格式錯誤時回傳 false (已讀到的部分仍會累加)
+    bool merge_serialized(const std::string& text) {
+        std::istringstream in(text);
+        uint64_t other_max = 0;
+        if (!(in >> other_max)) return false;
+        std::string item;
+        while (in >> item) {
+            const std::size_t colon = item.find(':');
+            if (colon == std::string::npos) return false;
+            int index = -1;
+            uint64_t n = 0;
+            const char* end = item.data() + item.size();
+            if (std::from_chars(item.data(), item.data() + colon, index).ptr != item.data() + colon ||
+                std::from_chars(item.data() + colon + 1, end, n).ptr != end ||
+                index < 0 || index >= BUCKET_COUNT) {
+                return false;
+            }
+            buckets_[index].fetch_add(n, std::memory_order_relaxed);
+            count_.fetch_add(n, std::memory_order_relaxed);
+        }
+        uint64_t prev_max = max_.load(std::memory_order_relaxed);
+        while (other_max > prev_max &&
+               !max_.compare_exchange_weak(prev_max, other_max, std::memory_order_relaxed)) {
+        }
+        return true;
+    }
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    // 回傳第 p 百分位 (0 < p <= 100) 所在子桶的上界；沒有資料時回傳 0
+    uint64_t percentile(double p) const {
+        const uint64_t total = count();
+        if (total == 0) return 0;
+        uint64_t target = static_cast<uint64_t>(total * p / 100.0);
+        if (target == 0) target = 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= target) {
+                const uint64_t upper = bucket_upper_bound(i);
+                return upper < max() ? upper : max();
+            }
+        }
+        return max();
+    }
+
+    void reset() {
+        for (auto& bucket : buckets_) bucket.store(0, std::memory_order_relaxed);
+        count_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    static int bucket_index(uint64_t value) {
+        if (value < SUB_BUCKETS) return static_cast<int>(value);
+        // 最高位元的位置決定區間，其後 SUB_BUCKET_BITS 個位元決定子桶
+        const int msb = 63 - std::countl_zero(value);
+        const int shift = msb - SUB_BUCKET_BITS;
+        const int sub = static_cast<int>((value >> shift) & (SUB_BUCKETS - 1));
+        return (shift + 1) * SUB_BUCKETS + sub;
+    }
+
+    static uint64_t bucket_upper_bound(int index) {
+        if (index < SUB_BUCKETS) return static_cast<uint64_t>(index);
+        const int shift = index / SUB_BUCKETS - 1;
+        const uint64_t sub = static_cast<uint64_t>(index % SUB_BUCKETS);
+        const uint64_t lower = (uint64_t(SUB_BUCKETS) + sub) << shift;
+        return lower + ((uint64_t(1) << shift) - 1);
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> max_{0};
+};
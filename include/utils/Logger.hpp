@@ -8,7 +8,7 @@
 #include <string>
 #include <iostream>
 
-std::shared_ptr<spdlog::logger> create_logger(const std::string& name, const std::string& filePath, 
+inline std::shared_ptr<spdlog::logger> create_logger(const std::string& name, const std::string& filePath, 
         const std::string& pattern = "[%Y-%m-%d %H:%M:%S][%t][%^%l%$] %v", 
         const std::string& json_pattern = {"{\"date\": \"%Y-%m-%d\", \"time\": \"%H:%M:%S\", \"level\": \"%^%l%$\", \"process\": %P, \"thread\": %t, \"message\": \"%v\"}"} ){
      try {
@@ -4,16 +4,47 @@
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <cerrno>
+#include <csignal>
+#include <system_error>
 #include <asio.hpp>
 #include <asio/ssl.hpp>
+#if defined(__linux__)
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/wait.h>
+#endif
 #include "frame/FrameHeader.hpp" // 引用 FrameHeader
+#include "frame/FrameBuilder.hpp"
+#include "frame/FrameParser.hpp"
+#include "frame/Messages.hpp"
 #include "utils/Logger.hpp"      // 新增：整合日誌系統
+#include "utils/IoBackend.hpp"
+#include "storage/TraceFile.hpp"
+#include "utils/LatencyHistogram.hpp"
+#include "utils/CpuAffinity.hpp"
 
 using asio::ip::tcp;
 
 // --- 全域設定 ---
 const std::string HOST = "127.0.0.1";
-const short PORT = 12345;
+short PORT = 12345; // 可由命令列覆寫
+std::string TOKEN;   // 伺服器啟用認證時使用的 token (--token)
+int BATCH_SIZE = 1;  // 每個請求打包的訊息數 (--batch)；大於 1 時以 CMD_BATCH 送出
+double RATE_PER_CONNECTION = 0; // 每條連線的目標請求速率 (--rate 的總速率除以連線數)；0 表示只依 sleep_time
+std::string UNIX_SOCKET;        // 非空時請求連線改走伺服器的 Unix domain socket (--unix PATH)，不使用 TLS
+uint32_t DIGEST_ROUNDS = 0;     // > 0 時請求改為 CMD_DIGEST_REQUEST (--digest-rounds R，伺服器端耗用 CPU 的指令)
+int PIPELINE_DEPTH = 1;         // 每條連線同時未回覆的請求數 (--pipeline N)；大於 1 時以請求 ID 對應回覆
 
 // --- 全域計數器與旗標 ---
 std::atomic<uint64_t> success_count(0);
@@ -21,12 +52,65 @@ std::atomic<uint64_t> failure_count(0);
 std::atomic<uint64_t> content_match_count(0); // 新增：用於計算內容驗證成功的次數
 std::atomic<uint64_t> total_latency_ns(0);    // 新增：用於累計所有成功請求的總延遲（奈秒）
 std::atomic<bool> stop_test(false);
+std::atomic<uint64_t> subscriber_received(0); // 訂閱者收到的發布訊息數
+std::atomic<uint64_t> messages_sent(0);       // 成功送出並得到確認的訊息數 (批次模式下每個請求有多則訊息)
+std::atomic<uint64_t> out_of_order_replies(0); // 管線模式下比更早送出的請求先回來的回覆數
+std::atomic<uint64_t> idle_connected(0);      // 已完成交握 (與認證) 的閒置連線數
+std::atomic<int> idle_threads_ready(0);       // 已建立完所有連線的閒置連線執行緒數
+
+// --- 連線翻轉 (churn) 模式：反覆「連線、交握、送 K 個訊框、關閉」 ---
+int CHURN_FRAMES = -1;     // >= 0 時啟用，每條連線送出的訊框數 (--churn K)
+double CHURN_RATE = 0;     // 所有執行緒合計的目標連線速率 (連線/秒，--churn-rate)；0 表示不限速
+bool CHURN_RESUME = true;  // 是否以上一條連線的 session 恢復交握 (--no-resume 關閉)
+std::atomic<uint64_t> churn_connects(0); // 完成整個週期的連線數
+
+// --- 軌跡重播模式：依伺服器錄製的軌跡 (--trace-record) 重現每條連線的訊框時間與大小 ---
+std::string REPLAY_TRACE;    // 軌跡檔 (--replay FILE)；非空時啟用
+double REPLAY_SPEED = 1.0;   // 時間軸加速倍數 (--replay-speed X)
+std::atomic<uint64_t> replay_connections(0);  // 成功建立 (交握完成) 的連線數
+std::atomic<uint64_t> replay_frames_sent(0);  // 已寫出的訊框數
+std::atomic<uint64_t> replay_replies(0);      // 收到的回覆訊框數
+std::atomic<int> replay_threads_done(0);
+
+// --- 多行程模式：協調者 (--processes N) 以 fork + exec 啟動 N 個 client-app 工作行程 ---
+int WORKER_REPORT_FD = -1;  // 工作行程：準備好時寫入一個位元組，結束時寫入結果
+int WORKER_START_FD = -1;   // 工作行程：讀到 EOF (協調者關閉寫入端) 時所有工作行程同時開始
+
+// 回覆的承載資料大小；標頭的長度不合法時 (小於標頭或超過 64KB) 視為連線錯誤
+inline std::size_t reply_body_size(const FrameHeader& header) {
+    if (!FrameParser::valid_length(header.total_length)) {
+        throw std::runtime_error("Invalid reply length " + std::to_string(header.total_length));
+    }
+    return header.total_length - sizeof(FrameHeader);
+}
+
+// 若有設定 token，在交握後先送出 CMD_AUTH_REQUEST 並等待結果 (同步)
+template <typename Stream>
+void authenticate(Stream& stream) {
+    if (TOKEN.empty()) return;
+
+    asio::write(stream, asio::buffer(FrameBuilder::build(AuthRequest{TOKEN})));
+
+    FrameHeader reply;
+    asio::read(stream, asio::buffer(&reply, sizeof(FrameHeader)));
+    decode_header(reply);
+    std::vector<char> body(reply_body_size(reply));
+    asio::read(stream, asio::buffer(body));
+    AuthResponse response;
+    if (!codec::decode(reply.command_id, std::string_view(body.data(), body.size()), response) || response.status != 0) {
+        throw std::runtime_error("Authentication rejected (status " +
+                                 std::to_string(body.empty() ? -1 : static_cast<int>(response.status)) + ")");
+    }
+}
 
 class QpsClient {
 public:
     // 修改建構函式以接收 SSL context
     QpsClient(asio::io_context& io_context, asio::ssl::context& ssl_context, const std::string& message, int sleep_time, std::vector<uint64_t>* thread_latencies, std::shared_ptr<spdlog::logger> logger)
         : stream_(io_context, ssl_context),
+#if defined(ASIO_HAS_LOCAL_SOCKETS)
+          local_socket_(io_context),
+#endif
           resolver_(io_context),
           message_(message),
           request_body_(message.begin(), message.end()),
@@ -63,22 +147,46 @@ public:
         // 這樣在迴圈中只需要一次 write 操作
         request_packet_.resize(sizeof(FrameHeader) + request_body_.size());
         asio::buffer_copy(asio::buffer(request_packet_), buffers);
+
+        // 批次模式：同一則訊息重複 BATCH_SIZE 次打包成一個 CMD_BATCH 訊框，伺服器以一個 CMD_BATCH_ACK 確認
+        if (BATCH_SIZE > 1) {
+            BatchBuilder batch;
+            for (int i = 0; i < BATCH_SIZE; ++i) {
+                if (!batch.add(CMD_PUBLISH_MESSAGE, message_)) {
+                    throw std::invalid_argument("Batch of " + std::to_string(BATCH_SIZE) + " messages exceeds the frame size limit");
+                }
+            }
+            request_packet_ = batch.build();
+        }
+        // 摘要模式：同一則訊息作為資料，伺服器計算 DIGEST_ROUNDS 次 SHA-256
+        if (DIGEST_ROUNDS > 0) {
+            request_packet_ = FrameBuilder::build(DigestRequest{DIGEST_ROUNDS, message_});
+        }
     }
 
     // 執行 QPS 測試迴圈
     void run() {
         try {
+#if defined(ASIO_HAS_LOCAL_SOCKETS)
+            if (!UNIX_SOCKET.empty()) {
+                // 本機連線：不經過 TCP 與 TLS，伺服器以 SO_PEERCRED 確認身分
+                local_socket_.connect(asio::local::stream_protocol::endpoint(UNIX_SOCKET));
+                logger_->info("Connected to server unix socket {}", UNIX_SOCKET);
+                authenticate(local_socket_);
+                request_loop(local_socket_);
+                asio::error_code ec;
+                local_socket_.shutdown(asio::socket_base::shutdown_both, ec);
+                return;
+            }
+#endif
             // 連線到 TCP 層
             asio::connect(stream_.lowest_layer(), endpoints_);
 
             // 進行 TLS 交握
             stream_.handshake(asio::ssl::stream_base::client);
             logger_->info("TLS handshake successful with server {}:{}", HOST, PORT);
-
-            // 當 stop_test 旗標為 false 時，持續收發
-            while (!stop_test.load(std::memory_order_relaxed)) {
-                send_and_receive(sleep_time_);
-            }
+            authenticate(stream_);
+            request_loop(stream_);
 
             // --- 優雅關閉 TLS 連線 ---
             // 這會發送 close_notify 訊息給伺服器
@@ -102,36 +210,57 @@ public:
     }
 
 private:
-    void send_and_receive(int sleep_time) {
+    // 當 stop_test 旗標為 false 時，持續收發
+    // 設定目標速率時依固定的時間表送出；延遲從預定的送出時間起算，跟不上時排隊的時間也計入延遲
+    template <typename Stream>
+    void request_loop(Stream& stream) {
+        if (PIPELINE_DEPTH > 1) {
+            pipelined_loop(stream);
+            return;
+        }
+        const auto interval = std::chrono::nanoseconds(
+            RATE_PER_CONNECTION > 0 ? static_cast<int64_t>(1e9 / RATE_PER_CONNECTION) : 0);
+        auto next_send = std::chrono::steady_clock::now();
+        while (!stop_test.load(std::memory_order_relaxed)) {
+            if (interval.count() > 0) {
+                std::this_thread::sleep_until(next_send);
+                send_and_receive(stream, 0, next_send);
+                next_send += interval;
+            } else {
+                send_and_receive(stream, sleep_time_, std::chrono::steady_clock::now());
+            }
+        }
+    }
+
+    // request_start_time：請求的開始時間 (限速模式下為預定的送出時間)
+    template <typename Stream>
+    void send_and_receive(Stream& stream, int sleep_time, std::chrono::steady_clock::time_point request_start_time) {
         try {
-            // 記錄請求開始時間
-            auto request_start_time = std::chrono::high_resolution_clock::now();
 
             // 1. 同步寫入 (已預先打包好)
-            asio::write(stream_, asio::buffer(request_packet_));
+            asio::write(stream, asio::buffer(request_packet_));
 
             // 2. 同步讀取回音 Header
             FrameHeader reply_header;
-            asio::read(stream_, asio::buffer(&reply_header, sizeof(FrameHeader)));
+            asio::read(stream, asio::buffer(&reply_header, sizeof(FrameHeader)));
             decode_header(reply_header);
 
             // 3. 同步讀取回音 Body
-            const size_t body_length = reply_header.total_length - sizeof(FrameHeader);
+            const size_t body_length = reply_body_size(reply_header);
             if (body_length > 0) {
                 std::vector<char> reply_body(body_length);
-                asio::read(stream_, asio::buffer(reply_body));
+                asio::read(stream, asio::buffer(reply_body));
                 
-                // 啟用內容驗證
-                if (reply_body.size() == request_body_.size() && 
-                    std::equal(reply_body.begin(), reply_body.end(), request_body_.begin())) {
+                if (reply_matches(reply_header, reply_body)) {
                     content_match_count++;
                 }
             }
+            messages_sent += BATCH_SIZE;
             // 只要成功收發（沒有拋出例外），就計為一次成功請求
             success_count++;
 
             // 計算並累加本次請求的延遲
-            auto request_end_time = std::chrono::high_resolution_clock::now();
+            auto request_end_time = std::chrono::steady_clock::now();
             auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(request_end_time - request_start_time);
             uint64_t latency_ns = latency.count();
             total_latency_ns += latency_ns;
@@ -139,7 +268,9 @@ private:
             // 直接寫入執行緒自己的向量，無需加鎖
             thread_latencies_->push_back(latency_ns);
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(sleep_time)); 
+            if (sleep_time > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(sleep_time));
+            }
             
         } catch (const std::exception& e) {
             failure_count++;
@@ -156,8 +287,87 @@ private:
         }
     }
 
-    tcp::resolver resolver_;
+    // 管線模式：先送出 PIPELINE_DEPTH 個帶有請求 ID (1..N) 的請求，之後每收到一個回覆，
+    // 依回覆的 ID 計算延遲，並以同一個 ID 送出下一個請求；停止時等待剩下的回覆
+    // 伺服器把耗用 CPU 的請求交給工作執行緒時，回覆不一定依送出的順序回來
+    template <typename Stream>
+    void pipelined_loop(Stream& stream) {
+        const int depth = PIPELINE_DEPTH;
+        std::vector<std::vector<char>> packets(depth + 1, request_packet_);
+        std::vector<std::chrono::steady_clock::time_point> sent_at(depth + 1);
+        std::vector<uint64_t> sequence(depth + 1, 0); // 每個 ID 目前的請求是第幾個送出的
+        uint64_t next_sequence = 0;
+        int outstanding = 0;
+        auto send = [&](int id) {
+            sent_at[id] = std::chrono::steady_clock::now();
+            sequence[id] = next_sequence++;
+            asio::write(stream, asio::buffer(packets[id]));
+            ++outstanding;
+        };
+        try {
+            for (int id = 1; id <= depth; ++id) {
+                set_request_id(packets[id].data(), static_cast<uint8_t>(id));
+                send(id);
+            }
+            std::vector<char> reply_body;
+            while (outstanding > 0) {
+                FrameHeader reply_header;
+                asio::read(stream, asio::buffer(&reply_header, sizeof(FrameHeader)));
+                decode_header(reply_header);
+                reply_body.resize(reply_body_size(reply_header));
+                asio::read(stream, asio::buffer(reply_body));
+
+                const int id = reply_header.request_id;
+                if (id == 0 || id > depth) throw std::runtime_error("Reply with unknown request id " + std::to_string(id));
+                --outstanding;
+                // 還有更早送出的請求沒有回覆
+                for (int other = 1; other <= depth; ++other) {
+                    if (other != id && sequence[other] < sequence[id]) {
+                        out_of_order_replies++;
+                        break;
+                    }
+                }
+                sequence[id] = std::numeric_limits<uint64_t>::max();
+                if (reply_matches(reply_header, reply_body)) {
+                    content_match_count++;
+                }
+                messages_sent += BATCH_SIZE;
+                success_count++;
+                const uint64_t latency_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - sent_at[id]).count();
+                total_latency_ns += latency_ns;
+                thread_latencies_->push_back(latency_ns);
+
+                if (!stop_test.load(std::memory_order_relaxed)) send(id);
+            }
+        } catch (const std::exception& e) {
+            failure_count++;
+            logger_->error("Pipelined send/receive error: {}", e.what());
+            stop_test.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    // 回覆內容驗證：回音與請求相同、批次確認全部的訊息、摘要請求成功
+    bool reply_matches(const FrameHeader& reply_header, const std::vector<char>& reply_body) const {
+        const std::string_view body(reply_body.data(), reply_body.size());
+        if (DIGEST_ROUNDS > 0) {
+            DigestResponse response;
+            return codec::decode(reply_header.command_id, body, response) && response.status == DIGEST_OK &&
+                   response.digest.size() == 32;
+        }
+        if (BATCH_SIZE > 1) {
+            BatchAck ack;
+            return codec::decode(reply_header.command_id, body, ack) && ack.count == static_cast<uint32_t>(BATCH_SIZE);
+        }
+        return reply_body.size() == request_body_.size() &&
+               std::equal(reply_body.begin(), reply_body.end(), request_body_.begin());
+    }
+
     asio::ssl::stream<tcp::socket> stream_;
+#if defined(ASIO_HAS_LOCAL_SOCKETS)
+    asio::local::stream_protocol::socket local_socket_; // --unix 模式使用
+#endif
+    tcp::resolver resolver_;
     tcp::resolver::results_type endpoints_;
     std::string message_;
     std::vector<char> request_body_;
@@ -167,6 +377,514 @@ private:
     std::shared_ptr<spdlog::logger> logger_; // 日誌記錄器
 };
 
+// 每條 churn 執行緒的交握延遲 (奈秒)，完整交握與 session 恢復分開記錄
+struct HandshakeLatencies {
+    std::vector<uint64_t> full;
+    std::vector<uint64_t> resumed;
+};
+
+class ChurnClient {
+public:
+    ChurnClient(asio::io_context& io_context, asio::ssl::context& ssl_context, const std::string& message,
+                double rate_per_thread, HandshakeLatencies* latencies, std::shared_ptr<spdlog::logger> logger)
+        : io_context_(io_context),
+          ssl_context_(ssl_context),
+          message_(message),
+          request_packet_(FrameBuilder::build(CMD_PUBLISH_MESSAGE, message)),
+          interval_(rate_per_thread > 0 ? std::chrono::nanoseconds(static_cast<int64_t>(1e9 / rate_per_thread))
+                                        : std::chrono::nanoseconds(0)),
+          latencies_(latencies),
+          logger_(std::move(logger)) {
+        tcp::resolver resolver(io_context_);
+        endpoints_ = resolver.resolve(HOST, std::to_string(PORT));
+    }
+
+    ~ChurnClient() {
+        if (session_) SSL_SESSION_free(session_);
+    }
+
+    void run() {
+        auto next_start = std::chrono::steady_clock::now();
+        while (!stop_test.load(std::memory_order_relaxed)) {
+            // 以固定間隔排程，落後時不補發 (避免一次湧入大量連線)
+            if (interval_.count() > 0) {
+                std::this_thread::sleep_until(next_start);
+                next_start = std::max(next_start + interval_, std::chrono::steady_clock::now() - interval_);
+            }
+            try {
+                run_once();
+                churn_connects.fetch_add(1, std::memory_order_relaxed);
+            } catch (const std::exception& e) {
+                failure_count++;
+                logger_->error("Churn connection failed: {}", e.what());
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+    }
+
+private:
+    void run_once() {
+        asio::ssl::stream<tcp::socket> stream(io_context_, ssl_context_);
+        SSL* ssl = stream.native_handle();
+        SSL_set_tlsext_host_name(ssl, HOST.c_str());
+        if (CHURN_RESUME && session_) {
+            SSL_set_session(ssl, session_);
+        }
+
+        asio::connect(stream.lowest_layer(), endpoints_);
+        const auto handshake_start = std::chrono::steady_clock::now();
+        stream.handshake(asio::ssl::stream_base::client);
+        const uint64_t handshake_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - handshake_start).count();
+        (SSL_session_reused(ssl) ? latencies_->resumed : latencies_->full).push_back(handshake_ns);
+
+        authenticate(stream);
+        for (int i = 0; i < CHURN_FRAMES; ++i) {
+            asio::write(stream, asio::buffer(request_packet_));
+            FrameHeader reply;
+            asio::read(stream, asio::buffer(&reply, sizeof(FrameHeader)));
+            decode_header(reply);
+            reply_body_.resize(reply_body_size(reply));
+            asio::read(stream, asio::buffer(reply_body_));
+            success_count++;
+            if (std::string_view(reply_body_.data(), reply_body_.size()) == message_) {
+                content_match_count++;
+            }
+        }
+
+        // 送出 close_notify 並等待伺服器的 close_notify，正常關閉的 session 才能被恢復
+        asio::error_code ec;
+        stream.shutdown(ec);
+
+        // TLS 1.3 的 session ticket 在交握之後才送達；等待 close_notify 時也會處理 ticket，因此關閉後才取出 session
+        if (CHURN_RESUME) {
+            SSL_SESSION* session = SSL_get1_session(ssl);
+            if (session && SSL_SESSION_is_resumable(session)) {
+                if (session_) SSL_SESSION_free(session_);
+                session_ = session;
+            } else if (session) {
+                SSL_SESSION_free(session);
+            }
+        }
+    }
+
+    asio::io_context& io_context_;
+    asio::ssl::context& ssl_context_;
+    tcp::resolver::results_type endpoints_;
+    std::string message_;
+    std::vector<char> request_packet_;
+    std::vector<char> reply_body_;
+    std::chrono::nanoseconds interval_;
+    SSL_SESSION* session_ = nullptr; // 最近一次可恢復的 session
+    HandshakeLatencies* latencies_;
+    std::shared_ptr<spdlog::logger> logger_;
+};
+
+void run_churn_thread(const std::string& message, double rate_per_thread, HandshakeLatencies* latencies,
+                      std::shared_ptr<spdlog::logger> logger) {
+    try {
+        asio::io_context io_context;
+        asio::ssl::context ssl_context(asio::ssl::context::tls_client);
+        ssl_context.set_verify_mode(asio::ssl::verify_peer);
+        ssl_context.load_verify_file("certs/server.crt");
+        ssl_context.set_options(
+            asio::ssl::context::default_workarounds |
+            asio::ssl::context::no_sslv2 |
+            asio::ssl::context::no_sslv3 |
+            asio::ssl::context::no_tlsv1 |
+            asio::ssl::context::no_tlsv1_1);
+
+        ChurnClient client(io_context, ssl_context, message, rate_per_thread, latencies, logger);
+        client.run();
+    } catch (const std::exception& e) {
+        failure_count++;
+        if (logger) {
+            logger->error("Unhandled exception in churn thread: {}", e.what());
+        }
+    }
+}
+
+// 重播中的一條連線 (非同步，只在所屬執行緒的 io_context 上執行)
+// 交握完成前要送出的訊框先排隊；關閉時先寫完已排隊的訊框，再取消讀取並送出 close_notify
+class ReplayConnection : public std::enable_shared_from_this<ReplayConnection> {
+public:
+    ReplayConnection(asio::io_context& io_context, asio::ssl::context& ssl_context,
+                     const tcp::resolver::results_type& endpoints, std::shared_ptr<spdlog::logger> logger)
+        : stream_(io_context, ssl_context), endpoints_(endpoints), logger_(std::move(logger)) {}
+
+    void open() {
+        SSL_set_tlsext_host_name(stream_.native_handle(), HOST.c_str());
+        asio::async_connect(stream_.lowest_layer(), endpoints_,
+            [this, self = shared_from_this()](const asio::error_code& ec, const tcp::endpoint&) {
+                if (ec) return fail("connect", ec);
+                stream_.async_handshake(asio::ssl::stream_base::client,
+                    [this, self](const asio::error_code& ec) {
+                        if (ec) return fail("handshake", ec);
+                        replay_connections.fetch_add(1, std::memory_order_relaxed);
+                        ready_ = true;
+                        if (!TOKEN.empty()) {
+                            pending_.push_front(FrameBuilder::build(AuthRequest{TOKEN}));
+                        }
+                        read_header();
+                        write_next();
+                    });
+            });
+    }
+
+    void send(std::vector<char> frame) {
+        if (failed_ || close_requested_) return;
+        pending_.push_back(std::move(frame));
+        write_next();
+    }
+
+    void close() {
+        close_requested_ = true;
+        write_next();
+    }
+
+private:
+    void write_next() {
+        if (!ready_ || writing_ || failed_) return;
+        if (pending_.empty()) {
+            if (close_requested_ && !shutting_down_) {
+                // 取消進行中的讀取，讀取的回呼收到 operation_aborted 後才送出 close_notify
+                shutting_down_ = true;
+                asio::error_code ec;
+                stream_.lowest_layer().cancel(ec);
+            }
+            return;
+        }
+        writing_ = true;
+        asio::async_write(stream_, asio::buffer(pending_.front()),
+            [this, self = shared_from_this()](const asio::error_code& ec, std::size_t) {
+                writing_ = false;
+                if (ec) return fail("write", ec);
+                if (pending_.front().size() >= sizeof(FrameHeader)) {
+                    replay_frames_sent.fetch_add(1, std::memory_order_relaxed);
+                }
+                pending_.pop_front();
+                write_next();
+            });
+    }
+
+    void read_header() {
+        // 取消時讀取可能剛好已完成 (回呼已排入佇列)，此時不再發起新的讀取，直接進入關閉
+        if (shutting_down_) return on_read_end(asio::error::operation_aborted);
+        asio::async_read(stream_, asio::buffer(&reply_header_, sizeof(FrameHeader)),
+            [this, self = shared_from_this()](const asio::error_code& ec, std::size_t) {
+                if (ec) return on_read_end(shutting_down_ ? asio::error::operation_aborted : ec);
+                decode_header(reply_header_);
+                if (!FrameParser::valid_length(reply_header_.total_length)) {
+                    return on_read_end(asio::error::invalid_argument);
+                }
+                reply_body_.resize(reply_header_.total_length - sizeof(FrameHeader));
+                asio::async_read(stream_, asio::buffer(reply_body_),
+                    [this, self](const asio::error_code& ec, std::size_t) {
+                        if (ec) return on_read_end(shutting_down_ ? asio::error::operation_aborted : ec);
+                        if (reply_header_.command_id == CMD_AUTH_RESPONSE) {
+                            AuthResponse response;
+                            if (!codec::decode(std::string_view(reply_body_.data(), reply_body_.size()), response) ||
+                                response.status != 0) {
+                                logger_->error("Replay connection rejected by authentication");
+                            }
+                        } else {
+                            replay_replies.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        read_header();
+                    });
+            });
+    }
+
+    void on_read_end(const asio::error_code& ec) {
+        if (shutting_down_ && ec == asio::error::operation_aborted) {
+            stream_.async_shutdown([self = shared_from_this()](const asio::error_code&) {});
+            return;
+        }
+        if (!close_requested_) fail("read", ec);
+    }
+
+    void fail(const char* what, const asio::error_code& ec) {
+        if (failed_) return;
+        failed_ = true;
+        pending_.clear();
+        failure_count++;
+        logger_->error("Replay connection {} error: {}", what, ec.message());
+        asio::error_code ignored;
+        stream_.lowest_layer().close(ignored);
+    }
+
+    asio::ssl::stream<tcp::socket> stream_;
+    const tcp::resolver::results_type& endpoints_;
+    std::shared_ptr<spdlog::logger> logger_;
+    std::deque<std::vector<char>> pending_;
+    FrameHeader reply_header_{};
+    std::vector<char> reply_body_;
+    bool ready_ = false;
+    bool writing_ = false;
+    bool failed_ = false;
+    bool close_requested_ = false;
+    bool shutting_down_ = false;
+};
+
+// 依軌跡中的指令與大小產生要送出的訊框 (軌跡不含承載資料)
+// 回傳空 vector 表示不重播這筆紀錄：認證由重播連線自行處理 (--token)，節點之間的聯邦指令不由客戶端送出
+std::vector<char> build_replay_frame(uint16_t command_id, uint32_t payload_size) {
+    switch (command_id) {
+        case CMD_AUTH_REQUEST:
+        case CMD_PEER_HELLO:
+        case CMD_PEER_INTEREST:
+        case CMD_PEER_FORWARD:
+            return {};
+        case CMD_REPLAY_REQUEST:
+            // 固定大小的請求，從 offset 0 開始重播
+            return FrameBuilder::build(ReplayRequest{0});
+        case CMD_BATCH: {
+            // 以一則同樣總大小的發布訊息組成合法的批次
+            BatchBuilder batch;
+            const std::size_t body = payload_size > sizeof(BatchEntryHeader) ? payload_size - sizeof(BatchEntryHeader) : 0;
+            batch.add(CMD_PUBLISH_MESSAGE, std::string(body, 'x'));
+            return batch.build();
+        }
+        default: {
+            std::vector<char> frame(sizeof(FrameHeader) + payload_size, 'x');
+            FrameHeader header;
+            encode_header(header, static_cast<uint32_t>(frame.size()), static_cast<CommandID>(command_id));
+            std::memcpy(frame.data(), &header, sizeof(FrameHeader));
+            return frame;
+        }
+    }
+}
+
+// 一條重播執行緒：負責軌跡中的一部分連線，依 (加速後的) 時間軸送出每一筆紀錄
+// lateness 收集每筆紀錄實際處理時間比排定時間晚了多少 (奈秒)，用來判斷客戶端本身是否跟得上
+void run_replay_thread(const std::vector<TraceRecord>* records, std::vector<uint64_t>* lateness,
+                       std::shared_ptr<spdlog::logger> logger) {
+    try {
+        asio::io_context io_context;
+        asio::ssl::context ssl_context(asio::ssl::context::tls_client);
+        ssl_context.set_verify_mode(asio::ssl::verify_peer);
+        ssl_context.load_verify_file("certs/server.crt");
+        tcp::resolver resolver(io_context);
+        const auto endpoints = resolver.resolve(HOST, std::to_string(PORT));
+
+        std::map<uint32_t, std::shared_ptr<ReplayConnection>> connections;
+        auto connection_for = [&](uint32_t id) {
+            auto& connection = connections[id];
+            if (!connection) {
+                connection = std::make_shared<ReplayConnection>(io_context, ssl_context, endpoints, logger);
+                connection->open();
+            }
+            return connection;
+        };
+        auto close_all = [&] {
+            for (auto& entry : connections) entry.second->close();
+            connections.clear();
+        };
+
+        asio::steady_timer timer(io_context);
+        const auto start = std::chrono::steady_clock::now();
+        std::size_t next = 0;
+        std::function<void()> schedule_next = [&] {
+            if (next == records->size() || stop_test.load(std::memory_order_relaxed)) {
+                close_all();
+                return;
+            }
+            const auto due = start + std::chrono::nanoseconds(
+                static_cast<int64_t>((*records)[next].timestamp_ns / REPLAY_SPEED));
+            timer.expires_at(due);
+            timer.async_wait([&](const asio::error_code& ec) {
+                if (ec) return;
+                const auto now = std::chrono::steady_clock::now();
+                // 處理所有已到期的紀錄
+                while (next < records->size()) {
+                    const TraceRecord& record = (*records)[next];
+                    const auto scheduled = start + std::chrono::nanoseconds(
+                        static_cast<int64_t>(record.timestamp_ns / REPLAY_SPEED));
+                    if (scheduled > now) break;
+                    lateness->push_back(static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(now - scheduled).count()));
+                    if (record.command_id == TRACE_CONNECTION_OPEN) {
+                        connection_for(record.connection_id);
+                    } else if (record.command_id == TRACE_CONNECTION_CLOSE) {
+                        auto it = connections.find(record.connection_id);
+                        if (it != connections.end()) {
+                            it->second->close();
+                            connections.erase(it);
+                        }
+                    } else {
+                        auto frame = build_replay_frame(record.command_id, record.payload_size);
+                        if (!frame.empty()) connection_for(record.connection_id)->send(std::move(frame));
+                    }
+                    ++next;
+                }
+                schedule_next();
+            });
+        };
+        schedule_next();
+
+        // 軌跡結束且所有連線都關閉後 io_context 會自然沒有工作；測試時間到時提前關閉所有連線
+        bool stopping = false;
+        while (!io_context.stopped()) {
+            io_context.run_for(std::chrono::milliseconds(100));
+            if (stop_test.load(std::memory_order_relaxed) && !stopping) {
+                stopping = true;
+                timer.cancel();
+                close_all();
+                io_context.run_for(std::chrono::seconds(1));
+                break;
+            }
+        }
+    } catch (const std::exception& e) {
+        failure_count++;
+        if (logger) {
+            logger->error("Unhandled exception in replay thread: {}", e.what());
+        }
+    }
+    replay_threads_done.fetch_add(1);
+}
+
+// 讀取 /proc/net/netstat 的 TcpExt 計數器 (例如 ListenOverflows、ListenDrops)；非 Linux 平台回傳空表
+std::map<std::string, uint64_t> read_tcp_ext_counters() {
+    std::map<std::string, uint64_t> counters;
+    std::ifstream file("/proc/net/netstat");
+    std::string names, values;
+    while (std::getline(file, names) && std::getline(file, values)) {
+        if (names.rfind("TcpExt:", 0) != 0) continue;
+        std::istringstream name_stream(names), value_stream(values);
+        std::string name, value;
+        name_stream >> name;
+        value_stream >> value; // 略過 "TcpExt:" 前綴
+        while (name_stream >> name && value_stream >> value) {
+            counters[name] = std::stoull(value);
+        }
+        break;
+    }
+    return counters;
+}
+
+// 印出一組延遲樣本 (奈秒) 的分佈
+void log_latency_distribution(const std::shared_ptr<spdlog::logger>& logger, const char* label, std::vector<uint64_t> samples) {
+    if (samples.empty()) {
+        logger->info("{}: no samples", label);
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) {
+        const std::size_t index = std::min(samples.size() - 1, static_cast<std::size_t>(samples.size() * q));
+        return samples[index] / 1e6;
+    };
+    logger->info("{}: {} handshakes, p50 {:.3f} ms, p90 {:.3f} ms, p99 {:.3f} ms, max {:.3f} ms",
+                 label, samples.size(), at(0.5), at(0.9), at(0.99), samples.back() / 1e6);
+}
+
+// 訂閱者：訂閱主題後只接收伺服器推送的訊息並計數 (用於量測 fan-out 與多節點轉送的吞吐量)
+class SubscriberClient {
+public:
+    SubscriberClient(asio::io_context& io_context, asio::ssl::context& ssl_context, const std::string& topic, std::shared_ptr<spdlog::logger> logger)
+        : stream_(io_context, ssl_context),
+          topic_(topic),
+          logger_(logger) {}
+
+    void run(asio::io_context& io_context) {
+        tcp::resolver resolver(io_context);
+        asio::connect(stream_.lowest_layer(), resolver.resolve(HOST, std::to_string(PORT)));
+        stream_.handshake(asio::ssl::stream_base::client);
+        authenticate(stream_);
+
+        FrameHeader header;
+        encode_header(header, sizeof(FrameHeader) + topic_.size(), CMD_SUBSCRIBE_TOPIC);
+        std::vector<char> request(sizeof(FrameHeader) + topic_.size());
+        std::memcpy(request.data(), &header, sizeof(FrameHeader));
+        std::memcpy(request.data() + sizeof(FrameHeader), topic_.data(), topic_.size());
+        asio::write(stream_, asio::buffer(request));
+        logger_->info("Subscriber connected to {}:{} (topic '{}')", HOST, PORT, topic_);
+
+        // 非同步讀取，主迴圈定期檢查停止旗標
+        read_header();
+        while (!stop_test.load(std::memory_order_relaxed) && !io_context.stopped()) {
+            io_context.run_for(std::chrono::milliseconds(100));
+        }
+    }
+
+private:
+    void read_header() {
+        asio::async_read(stream_, asio::buffer(&header_, sizeof(FrameHeader)),
+            [this](const asio::error_code& ec, std::size_t) {
+                if (ec) return;
+                decode_header(header_);
+                if (!FrameParser::valid_length(header_.total_length)) {
+                    logger_->error("Subscriber received invalid frame length {}", header_.total_length);
+                    return; // 視為連線錯誤，停止讀取
+                }
+                body_.resize(header_.total_length - sizeof(FrameHeader));
+                asio::async_read(stream_, asio::buffer(body_),
+                    [this](const asio::error_code& ec, std::size_t) {
+                        if (ec) return;
+                        if (header_.command_id == CMD_PUBLISH_MESSAGE) {
+                            subscriber_received.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        read_header();
+                    });
+            });
+    }
+
+    asio::ssl::stream<tcp::socket> stream_;
+    std::string topic_;
+    FrameHeader header_{};
+    std::vector<char> body_;
+    std::shared_ptr<spdlog::logger> logger_;
+};
+
+void run_subscriber_thread(std::shared_ptr<spdlog::logger> logger) {
+    try {
+        asio::io_context io_context;
+        asio::ssl::context ssl_context(asio::ssl::context::tls_client);
+        ssl_context.set_verify_mode(asio::ssl::verify_peer);
+        ssl_context.load_verify_file("certs/server.crt");
+
+        // 一般的發布訊息沒有主題前綴，屬於預設主題 (空字串)
+        SubscriberClient client(io_context, ssl_context, "", logger);
+        client.run(io_context);
+    } catch (const std::exception& e) {
+        if (logger) {
+            logger->error("Subscriber failed: {}", e.what());
+        }
+    }
+}
+
+// 建立 count 條完成交握 (與認證) 後不再送出任何資料的連線，並保持到測試結束
+// 用於量測伺服器上每條閒置連線的記憶體成本
+void run_idle_thread(int count, std::shared_ptr<spdlog::logger> logger) {
+    try {
+        asio::io_context io_context;
+        asio::ssl::context ssl_context(asio::ssl::context::tls_client);
+        ssl_context.set_verify_mode(asio::ssl::verify_peer);
+        ssl_context.load_verify_file("certs/server.crt");
+
+        std::vector<std::unique_ptr<asio::ssl::stream<tcp::socket>>> streams;
+        streams.reserve(count);
+        tcp::resolver resolver(io_context);
+        const auto endpoints = resolver.resolve(HOST, std::to_string(PORT));
+        for (int i = 0; i < count && !stop_test.load(std::memory_order_relaxed); ++i) {
+            auto stream = std::make_unique<asio::ssl::stream<tcp::socket>>(io_context, ssl_context);
+            asio::connect(stream->lowest_layer(), endpoints);
+            stream->handshake(asio::ssl::stream_base::client);
+            authenticate(*stream);
+            streams.push_back(std::move(stream));
+            idle_connected.fetch_add(1, std::memory_order_relaxed);
+        }
+        idle_threads_ready.fetch_add(1);
+        while (!stop_test.load(std::memory_order_relaxed)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    } catch (const std::exception& e) {
+        idle_threads_ready.fetch_add(1);
+        if (logger) {
+            logger->error("Idle connection thread failed after {} connections: {}", idle_connected.load(), e.what());
+        }
+    }
+}
+
 void run_qps_thread(const std::string& message, int sleep_time, std::vector<uint64_t>* thread_latencies, std::shared_ptr<spdlog::logger> logger) {
     try {
         // 為每個執行緒建立自己的 io_context 和 ssl_context
@@ -202,21 +920,340 @@ void run_qps_thread(const std::string& message, int sleep_time, std::vector<uint
 }
 
 
+// --- 多行程模式 ---
+// 單一行程的客戶端 (TLS 加解密、排程) 可能比伺服器先到極限；協調者把連線數與目標速率平均分給 N 個工作行程，
+// 每個工作行程綁定到一顆 CPU，準備好後同時開始，結束時把計數與延遲直方圖傳回協調者合併成一份報告。
+// 工作行程就是以相同參數 (連線數與速率換成自己的份額) 重新執行的 client-app，透過兩個管道與協調者溝通：
+//   report 管道：準備好時寫入 'R'，結束時寫入「名稱 值」一行一項的結果
+//   start 管道：所有工作行程都準備好後協調者關閉寫入端，工作行程讀到 EOF 即開始
+
+// 工作行程的結果 (協調者合併後也使用同一個結構)
+struct WorkerReport {
+    uint64_t success = 0;
+    uint64_t failure = 0;
+    uint64_t content_match = 0;
+    uint64_t messages = 0;
+    uint64_t total_latency_ns = 0;
+    uint64_t subscriber_received = 0;
+    uint64_t churn_connects = 0;
+    uint64_t out_of_order = 0;
+    uint64_t elapsed_ns = 0;
+    LatencyHistogram latency;
+    LatencyHistogram handshake_full;
+    LatencyHistogram handshake_resumed;
+
+    std::string serialize() const {
+        std::string out;
+        auto line = [&](const char* name, const std::string& value) { out += std::string(name) + " " + value + "\n"; };
+        line("success", std::to_string(success));
+        line("failure", std::to_string(failure));
+        line("content_match", std::to_string(content_match));
+        line("messages", std::to_string(messages));
+        line("total_latency_ns", std::to_string(total_latency_ns));
+        line("subscriber_received", std::to_string(subscriber_received));
+        line("churn_connects", std::to_string(churn_connects));
+        line("out_of_order", std::to_string(out_of_order));
+        line("elapsed_ns", std::to_string(elapsed_ns));
+        line("latency", latency.serialize());
+        line("handshake_full", handshake_full.serialize());
+        line("handshake_resumed", handshake_resumed.serialize());
+        return out;
+    }
+
+    // 將另一個工作行程的結果累加進來 (經過時間取最大值)；格式錯誤時回傳 false
+    bool merge_serialized(const std::string& text) {
+        std::istringstream in(text);
+        std::string line;
+        while (std::getline(in, line)) {
+            const std::size_t space = line.find(' ');
+            if (space == std::string::npos) return false;
+            const std::string name = line.substr(0, space);
+            const std::string value = line.substr(space + 1);
+            if (name == "latency") {
+                if (!latency.merge_serialized(value)) return false;
+            } else if (name == "handshake_full") {
+                if (!handshake_full.merge_serialized(value)) return false;
+            } else if (name == "handshake_resumed") {
+                if (!handshake_resumed.merge_serialized(value)) return false;
+            } else {
+                const uint64_t n = std::stoull(value);
+                if (name == "success") success += n;
+                else if (name == "failure") failure += n;
+                else if (name == "content_match") content_match += n;
+                else if (name == "messages") messages += n;
+                else if (name == "total_latency_ns") total_latency_ns += n;
+                else if (name == "subscriber_received") subscriber_received += n;
+                else if (name == "churn_connects") churn_connects += n;
+                else if (name == "out_of_order") out_of_order += n;
+                else if (name == "elapsed_ns") elapsed_ns = std::max(elapsed_ns, n);
+            }
+        }
+        return true;
+    }
+};
+
+#if defined(__linux__)
+// 寫完整個緩衝區 (管道可能只寫入一部分)
+bool write_all(int fd, const std::string& data) {
+    std::size_t written = 0;
+    while (written < data.size()) {
+        const ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        written += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+#endif
+
+// 工作行程：通知協調者已準備好，並等待開始訊號 (非工作行程時直接返回)
+void wait_for_start() {
+#if defined(__linux__)
+    if (WORKER_REPORT_FD < 0) return;
+    write_all(WORKER_REPORT_FD, "R");
+    char byte;
+    while (::read(WORKER_START_FD, &byte, 1) != 0) {
+        if (errno != EINTR) break;
+    }
+    ::close(WORKER_START_FD);
+#endif
+}
+
+// 工作行程：把結果傳回協調者
+void send_worker_report(const WorkerReport& report) {
+#if defined(__linux__)
+    if (WORKER_REPORT_FD < 0) return;
+    write_all(WORKER_REPORT_FD, report.serialize());
+    ::close(WORKER_REPORT_FD);
+#else
+    (void)report;
+#endif
+}
+
+// 合併後的報告
+void log_merged_report(const std::shared_ptr<spdlog::logger>& logger, const WorkerReport& total, int processes) {
+    const double elapsed_s = total.elapsed_ns / 1e9;
+    logger->info("--- Test Finished ({} processes) ---", processes);
+    logger->info("Actual duration: {:.2f} seconds (slowest worker)", elapsed_s);
+    logger->info("Total successful requests: {}", total.success);
+    logger->info("  - Content matched: {}", total.content_match);
+    logger->info("Total failed requests: {}", total.failure);
+    if (total.subscriber_received > 0) {
+        logger->info("Subscriber deliveries: {} ({:.2f} msg/s)", total.subscriber_received,
+                     elapsed_s > 0 ? total.subscriber_received / elapsed_s : 0.0);
+    }
+    auto ms = [](uint64_t ns) { return ns / 1e6; };
+    if (CHURN_FRAMES >= 0) {
+        logger->info("Connections: {} ({:.2f} conn/s, {} frames each, resumption {})", total.churn_connects,
+                     elapsed_s > 0 ? total.churn_connects / elapsed_s : 0.0, CHURN_FRAMES, CHURN_RESUME ? "on" : "off");
+        for (const auto& [label, histogram] : {std::pair<const char*, const LatencyHistogram*>{"Full handshakes", &total.handshake_full},
+                                               {"Resumed handshakes", &total.handshake_resumed}}) {
+            if (histogram->count() == 0) {
+                logger->info("{}: no samples", label);
+                continue;
+            }
+            logger->info("{}: {} handshakes, p50 {:.3f} ms, p90 {:.3f} ms, p99 {:.3f} ms, max {:.3f} ms", label,
+                         histogram->count(), ms(histogram->percentile(50)), ms(histogram->percentile(90)),
+                         ms(histogram->percentile(99)), ms(histogram->max()));
+        }
+    } else if (elapsed_s > 0 && total.success > 0) {
+        logger->info("Average QPS: {:.2f} req/s", total.success / elapsed_s);
+        if (BATCH_SIZE > 1) {
+            logger->info("Messages: {:.2f} msg/s ({} per batch)", total.messages / elapsed_s, BATCH_SIZE);
+        }
+        if (PIPELINE_DEPTH > 1) {
+            logger->info("Pipelined replies: {} of {} arrived before an earlier request's reply", total.out_of_order,
+                         total.success);
+        }
+        logger->info("Average Latency: {:.2f} ms", ms(total.total_latency_ns) / total.success);
+        logger->info("  - P50 Latency: {:.2f} ms", ms(total.latency.percentile(50)));
+        logger->info("  - P90 Latency: {:.2f} ms", ms(total.latency.percentile(90)));
+        logger->info("  - P99 Latency: {:.2f} ms", ms(total.latency.percentile(99)));
+        logger->info("  - P99.9 Latency: {:.2f} ms", ms(total.latency.percentile(99.9)));
+        logger->info("  - Max Latency: {:.2f} ms", ms(total.latency.max()));
+        logger->info("Packet Accuracy: {:.2f} %", 100.0 * total.content_match / total.success);
+    } else {
+        logger->warn("No successful requests were completed during the test.");
+        logger->info("Average QPS: 0.00 req/s");
+    }
+    logger->info("----------------------------------------");
+}
+
+#if defined(__linux__)
+// 協調者：啟動 processes 個工作行程，同步開始並合併結果；回傳行程的結束碼
+int run_orchestrator(int argc, char* argv[], int processes, const std::vector<int>& cpus, double total_rate,
+                     int subscribers, int idle_connections, const std::shared_ptr<spdlog::logger>& logger) {
+    const int concurrent_clients = std::stoi(argv[1]);
+    // 份額：總數平均分配，餘數分給前面的工作行程
+    auto share = [&](int total, int index) { return total / processes + (index < total % processes ? 1 : 0); };
+
+    // 工作行程的參數：協調者專用的選項與需要分配的選項拿掉，之後再加上自己的份額
+    std::vector<std::string> base_args(argv, argv + 5);
+    for (int i = 5; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--processes" || arg == "--worker-cpus" || arg == "--rate" || arg == "--churn-rate" ||
+            arg == "--subscribers" || arg == "--idle-connections") {
+            ++i;
+            continue;
+        }
+        base_args.push_back(arg);
+    }
+
+    struct Worker {
+        pid_t pid = -1;
+        int report_fd = -1;
+        int cpu = -1;
+        int clients = 0;
+    };
+    std::vector<Worker> workers(processes);
+
+    int start_pipe[2];
+    if (::pipe2(start_pipe, O_CLOEXEC) != 0) throw std::system_error(errno, std::generic_category(), "pipe2");
+
+    auto kill_workers = [&]() {
+        for (const auto& worker : workers) {
+            if (worker.pid > 0) ::kill(worker.pid, SIGTERM);
+        }
+    };
+
+    for (int w = 0; w < processes; ++w) {
+        Worker& worker = workers[w];
+        worker.clients = share(concurrent_clients, w);
+        worker.cpu = cpus.empty() ? -1 : cpus[w % cpus.size()];
+
+        int report_pipe[2];
+        if (::pipe2(report_pipe, O_CLOEXEC) != 0) {
+            kill_workers();
+            throw std::system_error(errno, std::generic_category(), "pipe2");
+        }
+
+        // exec 前先準備好參數 (fork 後的子行程只呼叫 async-signal-safe 的函式)
+        std::vector<std::string> args = base_args;
+        args[1] = std::to_string(worker.clients);
+        auto add = [&](const char* name, const std::string& value) {
+            args.push_back(name);
+            args.push_back(value);
+        };
+        if (total_rate > 0) add("--rate", std::to_string(total_rate * worker.clients / concurrent_clients));
+        if (CHURN_RATE > 0) add("--churn-rate", std::to_string(CHURN_RATE * worker.clients / concurrent_clients));
+        if (share(subscribers, w) > 0) add("--subscribers", std::to_string(share(subscribers, w)));
+        if (share(idle_connections, w) > 0) add("--idle-connections", std::to_string(share(idle_connections, w)));
+        add("--worker-report-fd", std::to_string(report_pipe[1]));
+        add("--worker-start-fd", std::to_string(start_pipe[0]));
+        std::vector<char*> exec_argv;
+        for (auto& arg : args) exec_argv.push_back(arg.data());
+        exec_argv.push_back(nullptr);
+
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        if (worker.cpu >= 0) CPU_SET(worker.cpu, &cpu_set);
+
+        const pid_t pid = ::fork();
+        if (pid < 0) {
+            ::close(report_pipe[0]);
+            ::close(report_pipe[1]);
+            kill_workers();
+            throw std::system_error(errno, std::generic_category(), "fork");
+        }
+        if (pid == 0) {
+            // 子行程：綁定 CPU，讓兩個管道在 exec 後保留下來，重新執行自己
+            if (worker.cpu >= 0) ::sched_setaffinity(0, sizeof(cpu_set), &cpu_set);
+            ::fcntl(report_pipe[1], F_SETFD, 0);
+            ::fcntl(start_pipe[0], F_SETFD, 0);
+            ::execv("/proc/self/exe", exec_argv.data());
+            ::_exit(127);
+        }
+        ::close(report_pipe[1]);
+        worker.pid = pid;
+        worker.report_fd = report_pipe[0];
+    }
+    ::close(start_pipe[0]);
+
+    std::vector<int> used_cpus;
+    for (const auto& worker : workers) {
+        if (worker.cpu >= 0) used_cpus.push_back(worker.cpu);
+    }
+    logger->info("Orchestrating {} worker processes (CPUs {}), {} clients, target rate {}", processes,
+                 used_cpus.empty() ? std::string("unpinned") : format_cpu_list(used_cpus), concurrent_clients,
+                 total_rate > 0 ? fmt::format("{:.0f} req/s", total_rate) : std::string("unlimited"));
+
+    // 等待每個工作行程都建立好連線 (收到 'R')；有工作行程提早結束時中止
+    bool ready = true;
+    for (const auto& worker : workers) {
+        char byte = 0;
+        ssize_t n;
+        do {
+            n = ::read(worker.report_fd, &byte, 1);
+        } while (n < 0 && errno == EINTR);
+        if (n != 1 || byte != 'R') {
+            logger->error("Worker {} (pid {}) exited before it was ready", &worker - workers.data(), worker.pid);
+            ready = false;
+            break;
+        }
+    }
+    if (!ready) kill_workers();
+    // 關閉寫入端：所有工作行程同時讀到 EOF 而開始 (中止時則讓還在等待的工作行程結束)
+    ::close(start_pipe[1]);
+
+    WorkerReport total;
+    bool complete = ready;
+    for (const auto& worker : workers) {
+        std::string text;
+        char buffer[4096];
+        ssize_t n;
+        while ((n = ::read(worker.report_fd, buffer, sizeof(buffer))) != 0) {
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            text.append(buffer, static_cast<std::size_t>(n));
+        }
+        ::close(worker.report_fd);
+        int status = 0;
+        while (::waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) {
+        }
+        if (!ready) continue;
+        if (text.empty() || !total.merge_serialized(text)) {
+            logger->error("Worker {} (pid {}) did not report results (status {})", &worker - workers.data(),
+                          worker.pid, WIFEXITED(status) ? WEXITSTATUS(status) : -WTERMSIG(status));
+            complete = false;
+        }
+    }
+    if (!ready) return 1;
+
+    log_merged_report(logger, total, processes);
+    return complete ? 0 : 1;
+}
+#endif
+
 int main(int argc, char* argv[]) {
 
      // 初始化spdlog的執行緒池(8192個佇列大小, 1個執行緒)
     spdlog::init_thread_pool(8192, 1); 
 
+    // 工作行程各自寫入自己的日誌檔，且只輸出警告以上 (結果由協調者輸出)
+    const bool is_worker = std::find_if(argv, argv + argc, [](const char* arg) {
+        return std::strcmp(arg, "--worker-report-fd") == 0;
+    }) != argv + argc;
+#if defined(__linux__)
+    const std::string log_file = is_worker ? "logs/client." + std::to_string(::getpid()) + ".log" : "logs/client.log";
+#else
+    const std::string log_file = "logs/client.log";
+#endif
+
     // 建立一個名為 "client" 的 logger，同時輸出到控制台和檔案
-    auto logger = create_logger("client", "logs/client.log", "[%Y-%m-%d %H:%M:%S][%t][%^%l%$] %v");
+    auto logger = create_logger("client", log_file, "[%Y-%m-%d %H:%M:%S][%t][%^%l%$] %v");
 
     if(!logger) {
         std::cerr << "Logger initialization failed. Exiting." << std::endl;
         return 1;
     }
+    if (is_worker) {
+        logger->set_level(spdlog::level::warn);
+    }
 
-    if (argc != 5) {
-        logger->error("Usage: {} <concurrent_clients> <duration_seconds> <sleep_time_ms> <message>", argv[0]);
+    if (argc < 5) {
+        logger->error("Usage: {} <concurrent_clients> <duration_seconds> <sleep_time_ms> <message> [--port P] [--subscribers N] [--token TOKEN] [--batch N] [--idle-connections N] [--churn K] [--churn-rate R] [--no-resume] [--replay TRACE] [--replay-speed X] [--rate R] [--processes N] [--worker-cpus LIST] [--unix PATH] [--digest-rounds R] [--pipeline N]", argv[0]);
         logger->error("Example: {} 100 60 10 \"Hello, World!\"", argv[0]);
         return 1;
     }
@@ -226,17 +1263,161 @@ int main(int argc, char* argv[]) {
         const int duration_seconds = std::stoi(argv[2]);
         const int sleep_time = std::stoi(argv[3]);
         const std::string message = argv[4];
+        int subscribers = 0;
+        int idle_connections = 0;
+        int processes = 1;
+        std::vector<int> worker_cpus;
+        double total_rate = 0;
+        // 選用參數
+        for (int i = 5; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--no-resume") {
+                CHURN_RESUME = false;
+                continue;
+            }
+            if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+            if (arg == "--port") {
+                PORT = static_cast<short>(std::stoi(argv[++i]));
+            } else if (arg == "--subscribers") {
+                subscribers = std::stoi(argv[++i]);
+            } else if (arg == "--token") {
+                TOKEN = argv[++i];
+            } else if (arg == "--batch") {
+                BATCH_SIZE = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--idle-connections") {
+                idle_connections = std::stoi(argv[++i]);
+            } else if (arg == "--churn") {
+                CHURN_FRAMES = std::max(0, std::stoi(argv[++i]));
+            } else if (arg == "--churn-rate") {
+                CHURN_RATE = std::stod(argv[++i]);
+            } else if (arg == "--replay") {
+                REPLAY_TRACE = argv[++i];
+            } else if (arg == "--replay-speed") {
+                REPLAY_SPEED = std::stod(argv[++i]);
+                if (REPLAY_SPEED <= 0) throw std::invalid_argument("--replay-speed must be positive");
+            } else if (arg == "--unix") {
+                UNIX_SOCKET = argv[++i];
+            } else if (arg == "--digest-rounds") {
+                DIGEST_ROUNDS = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (arg == "--pipeline") {
+                PIPELINE_DEPTH = std::clamp(std::stoi(argv[++i]), 1, 255);
+            } else if (arg == "--rate") {
+                total_rate = std::stod(argv[++i]);
+            } else if (arg == "--processes") {
+                processes = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--worker-cpus") {
+                worker_cpus = parse_cpu_list(argv[++i]);
+            } else if (arg == "--worker-report-fd") {
+                WORKER_REPORT_FD = std::stoi(argv[++i]);
+            } else if (arg == "--worker-start-fd") {
+                WORKER_START_FD = std::stoi(argv[++i]);
+            } else {
+                throw std::invalid_argument("Unknown option " + arg);
+            }
+        }
+        if (DIGEST_ROUNDS > 0 && BATCH_SIZE > 1) {
+            throw std::invalid_argument("--digest-rounds cannot be combined with --batch");
+        }
+        if (PIPELINE_DEPTH > 1 && total_rate > 0) {
+            throw std::invalid_argument("--pipeline cannot be combined with --rate");
+        }
+        if (total_rate > 0 && concurrent_clients > 0) {
+            RATE_PER_CONNECTION = total_rate / concurrent_clients;
+        }
+
+        if (!UNIX_SOCKET.empty()) {
+#if defined(ASIO_HAS_LOCAL_SOCKETS)
+            if (CHURN_FRAMES >= 0 || !REPLAY_TRACE.empty()) {
+                throw std::invalid_argument("--unix only applies to the request/echo test");
+            }
+#else
+            throw std::invalid_argument("--unix is not supported on this platform");
+#endif
+        }
 
-        logger->info("Starting QPS test with: Concurrent Clients={}, Duration={}s, Sleep Time={}ms, Target={}:{}", 
-                            concurrent_clients, duration_seconds, sleep_time, HOST, PORT);
+        if (processes > 1) {
+#if defined(__linux__)
+            if (!REPLAY_TRACE.empty()) throw std::invalid_argument("--replay cannot be combined with --processes");
+            if (WORKER_REPORT_FD >= 0) throw std::invalid_argument("--processes cannot be used in a worker");
+            if (concurrent_clients <= 0) throw std::invalid_argument("--processes needs at least one client");
+            processes = std::min(processes, concurrent_clients);
+            const int code = run_orchestrator(argc, argv, processes, worker_cpus.empty() ? available_cpus() : worker_cpus,
+                                              total_rate, subscribers, idle_connections, logger);
+            spdlog::shutdown();
+            return code;
+#else
+            throw std::invalid_argument("--processes is only supported on Linux");
+#endif
+        }
+
+        logger->info("Starting QPS test with: Concurrent Clients={}, Duration={}s, Sleep Time={}ms, Target={}", 
+                            concurrent_clients, duration_seconds, sleep_time,
+                            UNIX_SOCKET.empty() ? HOST + ":" + std::to_string(PORT) : "unix:" + UNIX_SOCKET);
+        logger->info("I/O backend: {}", io_backend_name());
         logger->info("----------------------------------------");
         
+        // 訂閱者先連線，確保測試開始時已在接收
+        std::vector<std::thread> subscriber_threads;
+        for (int i = 0; i < subscribers; ++i) {
+            subscriber_threads.emplace_back(run_subscriber_thread, logger);
+        }
+        if (subscribers > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        }
+
+        // 閒置連線先全部建立完成，測試時間從之後開始計算
+        std::vector<std::thread> idle_threads;
+        const int idle_thread_count = std::min(idle_connections, 8);
+        for (int i = 0; i < idle_thread_count; ++i) {
+            const int count = idle_connections / idle_thread_count + (i < idle_connections % idle_thread_count ? 1 : 0);
+            idle_threads.emplace_back(run_idle_thread, count, logger);
+        }
+        if (idle_thread_count > 0) {
+            while (idle_threads_ready.load() < idle_thread_count) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+            logger->info("Idle connections open: {}", idle_connected.load());
+        }
+
+        // 工作行程：等所有工作行程都準備好後同時開始
+        wait_for_start();
+
         // 為每個執行緒準備一個獨立的延遲向量
         std::vector<std::vector<uint64_t>> all_threads_latencies(concurrent_clients);
+        std::vector<HandshakeLatencies> all_threads_handshakes(concurrent_clients);
+        const auto tcp_ext_before = read_tcp_ext_counters();
+
+        // 重播模式：軌跡中的連線依連線 ID 分配到各執行緒 (同一條連線的紀錄都在同一條執行緒上，保持順序)
+        std::vector<std::vector<TraceRecord>> replay_records;
+        if (!REPLAY_TRACE.empty()) {
+            if (concurrent_clients <= 0) throw std::invalid_argument("Replay needs at least one client thread");
+            auto records = read_trace(REPLAY_TRACE);
+            replay_records.resize(concurrent_clients);
+            std::size_t connection_count = 0;
+            // 時間軸從軌跡中的第一筆紀錄開始 (略過伺服器啟動到第一條連線之間的空檔)
+            const uint64_t base_ns = records.empty() ? 0 : records.front().timestamp_ns;
+            for (auto& record : records) {
+                record.timestamp_ns -= base_ns;
+                replay_records[record.connection_id % concurrent_clients].push_back(record);
+                connection_count += record.command_id == TRACE_CONNECTION_OPEN;
+            }
+            const double trace_seconds = records.empty() ? 0 : records.back().timestamp_ns / 1e9;
+            logger->info("Replaying {} records ({} connections, {:.2f} s of traffic) at {}x speed on {} threads",
+                         records.size(), connection_count, trace_seconds, REPLAY_SPEED, concurrent_clients);
+        }
 
         // 啟動所有工作執行緒
         std::vector<std::thread> threads;
         for (int i = 0; i < concurrent_clients; ++i) {
+            if (!REPLAY_TRACE.empty()) {
+                threads.emplace_back(run_replay_thread, &replay_records[i], &all_threads_latencies[i], logger);
+                continue;
+            }
+            if (CHURN_FRAMES >= 0) {
+                threads.emplace_back(run_churn_thread, std::ref(message), CHURN_RATE / concurrent_clients,
+                                     &all_threads_handshakes[i], logger);
+                continue;
+            }
             // 將對應的延遲向量指標傳遞給執行緒
             threads.emplace_back(run_qps_thread, std::ref(message), sleep_time, &all_threads_latencies[i], logger);
         }
@@ -244,8 +1425,15 @@ int main(int argc, char* argv[]) {
         // 開始計時
         auto start_time = std::chrono::high_resolution_clock::now();
 
-        // 等待指定的測試時間
-        std::this_thread::sleep_for(std::chrono::seconds(duration_seconds));
+        // 等待指定的測試時間 (重播模式在軌跡播完時提前結束)
+        if (!REPLAY_TRACE.empty()) {
+            const auto deadline = start_time + std::chrono::seconds(duration_seconds);
+            while (replay_threads_done.load() < concurrent_clients && std::chrono::high_resolution_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+        } else {
+            std::this_thread::sleep_for(std::chrono::seconds(duration_seconds));
+        }
 
         // 時間到，設定停止旗標
         stop_test.store(true);
@@ -256,18 +1444,84 @@ int main(int argc, char* argv[]) {
                 t.join();
             }
         }
+        for (auto& t : subscriber_threads) {
+            t.join();
+        }
+        for (auto& t : idle_threads) {
+            t.join();
+        }
         
         auto end_time = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double> elapsed = end_time - start_time;
 
+        if (WORKER_REPORT_FD >= 0) {
+            WorkerReport report;
+            report.success = success_count.load();
+            report.failure = failure_count.load();
+            report.content_match = content_match_count.load();
+            report.messages = messages_sent.load();
+            report.total_latency_ns = total_latency_ns.load();
+            report.subscriber_received = subscriber_received.load();
+            report.churn_connects = churn_connects.load();
+            report.out_of_order = out_of_order_replies.load();
+            report.elapsed_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count());
+            for (const auto& thread_lats : all_threads_latencies) {
+                for (uint64_t latency : thread_lats) report.latency.record(latency);
+            }
+            for (const auto& thread_handshakes : all_threads_handshakes) {
+                for (uint64_t latency : thread_handshakes.full) report.handshake_full.record(latency);
+                for (uint64_t latency : thread_handshakes.resumed) report.handshake_resumed.record(latency);
+            }
+            send_worker_report(report);
+        }
+
         logger->info("--- Test Finished ---");
         logger->info("Actual duration: {:.2f} seconds", elapsed.count());
         logger->info("Total successful requests: {}", success_count.load());
         logger->info("  - Content matched: {}", content_match_count.load());
         logger->info("Total failed requests: {}", failure_count.load());
+        if (subscribers > 0) {
+            logger->info("Subscriber deliveries: {} ({:.2f} msg/s across {} subscribers)", subscriber_received.load(),
+                         subscriber_received.load() / elapsed.count(), subscribers);
+        }
         
         uint64_t final_success_count = success_count.load();
-        if (elapsed.count() > 0 && final_success_count > 0) {
+        if (!REPLAY_TRACE.empty()) {
+            // 重播模式：送出的訊框與收到的回覆，以及客戶端相對於軌跡時間軸的延遲 (判斷客戶端是否跟得上)
+            logger->info("Replay: {} connections, {} frames sent ({:.2f} frames/s), {} replies",
+                         replay_connections.load(), replay_frames_sent.load(),
+                         replay_frames_sent.load() / elapsed.count(), replay_replies.load());
+            std::vector<uint64_t> lateness;
+            for (const auto& thread_lateness : all_threads_latencies) {
+                lateness.insert(lateness.end(), thread_lateness.begin(), thread_lateness.end());
+            }
+            if (!lateness.empty()) {
+                std::sort(lateness.begin(), lateness.end());
+                logger->info("Schedule lateness: p50 {:.3f} ms, p99 {:.3f} ms, max {:.3f} ms",
+                             lateness[lateness.size() / 2] / 1e6,
+                             lateness[std::min(lateness.size() - 1, static_cast<std::size_t>(lateness.size() * 0.99))] / 1e6,
+                             lateness.back() / 1e6);
+            }
+        } else if (CHURN_FRAMES >= 0) {
+            // 翻轉模式：連線速率、完整/恢復交握的延遲分佈，以及核心的 accept 佇列溢位 (整台主機的計數)
+            logger->info("Connections: {} ({:.2f} conn/s, {} frames each, resumption {})", churn_connects.load(),
+                         churn_connects.load() / elapsed.count(), CHURN_FRAMES, CHURN_RESUME ? "on" : "off");
+            HandshakeLatencies combined;
+            for (const auto& thread_handshakes : all_threads_handshakes) {
+                combined.full.insert(combined.full.end(), thread_handshakes.full.begin(), thread_handshakes.full.end());
+                combined.resumed.insert(combined.resumed.end(), thread_handshakes.resumed.begin(), thread_handshakes.resumed.end());
+            }
+            log_latency_distribution(logger, "Full handshakes", std::move(combined.full));
+            log_latency_distribution(logger, "Resumed handshakes", std::move(combined.resumed));
+            const auto tcp_ext_after = read_tcp_ext_counters();
+            for (const char* name : {"ListenOverflows", "ListenDrops"}) {
+                const auto before = tcp_ext_before.find(name);
+                const auto after = tcp_ext_after.find(name);
+                if (before != tcp_ext_before.end() && after != tcp_ext_after.end()) {
+                    logger->info("{} (host-wide, during test): {}", name, after->second - before->second);
+                }
+            }
+        } else if (elapsed.count() > 0 && final_success_count > 0) {
             double qps = final_success_count / elapsed.count();
             double avg_latency_ms = (total_latency_ns.load() / 1e6) / final_success_count; // 轉換為毫秒
             double accuracy_rate = (static_cast<double>(content_match_count.load()) / final_success_count) * 100.0;
@@ -297,6 +1551,13 @@ int main(int argc, char* argv[]) {
             }
 
             logger->info("Average QPS: {:.2f} req/s", qps);
+            if (BATCH_SIZE > 1) {
+                logger->info("Messages: {:.2f} msg/s ({} per batch)", messages_sent.load() / elapsed.count(), BATCH_SIZE);
+            }
+            if (PIPELINE_DEPTH > 1) {
+                logger->info("Pipelined replies: {} of {} arrived before an earlier request's reply",
+                             out_of_order_replies.load(), final_success_count);
+            }
             logger->info("Average Latency: {:.2f} ms", avg_latency_ms);
             logger->info("  - Min Latency: {:.2f} ms", min_latency_ms);
             logger->info("  - Max Latency: {:.2f} ms", max_latency_ms);
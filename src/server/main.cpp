@@ -6,13 +6,142 @@
 #include "utils/Logger.hpp"
 #include <asio/signal_set.hpp>
 #include <iostream>
+#include <string>
+#include <sstream>
+#include <functional>
+
+// 解析命令列選項；遇到未知選項時回傳 false
+// issue_subject 非空時只簽發 token 並結束，不啟動伺服器
+static bool parse_options(int argc, char* argv[], std::size_t& thread_count, ServerConfig& config,
+                          std::string& issue_subject, long long& token_ttl_s) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        // 所有帶值的選項都需要下一個參數
+        auto next_value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+            return argv[++i];
+        };
+
+        if (arg == "--port") {
+            config.port = static_cast<unsigned short>(std::stoul(next_value()));
+        } else if (arg == "--peer") {
+            config.peers.push_back(next_value());
+        } else if (arg == "--auth-keys") {
+            config.auth_keys_file = next_value();
+        } else if (arg == "--auth-cache") {
+            config.auth_cache_capacity = std::stoul(next_value());
+        } else if (arg == "--issue-token") {
+            issue_subject = next_value();
+        } else if (arg == "--token-ttl") {
+            token_ttl_s = std::stoll(next_value());
+        } else if (arg == "--threads") {
+            thread_count = std::stoul(next_value());
+        } else if (arg == "--io-cpus") {
+            config.io_cpus = parse_cpu_list(next_value());
+        } else if (arg == "--numa-local") {
+            config.numa_local = true;
+        } else if (arg == "--handshake-threads") {
+            config.handshake_threads = std::stoul(next_value());
+        } else if (arg == "--handshake-cpus") {
+            config.handshake_cpus = parse_cpu_list(next_value());
+        } else if (arg == "--worker-threads") {
+            config.worker_threads = std::stoul(next_value());
+        } else if (arg == "--worker-cpus") {
+            config.worker_cpus = parse_cpu_list(next_value());
+        } else if (arg == "--logger-cpus") {
+            config.logger_cpus = parse_cpu_list(next_value());
+        } else if (arg == "--busy-poll") {
+            config.busy_poll_us = std::stoul(next_value());
+        } else if (arg == "--metrics-interval") {
+            config.metrics_interval_s = std::stoul(next_value());
+        } else if (arg == "--message-log") {
+            config.message_log_dir = next_value();
+        } else if (arg == "--message-log-segment-mb") {
+            config.message_log_segment_mb = std::stoul(next_value());
+        } else if (arg == "--message-log-max-segments") {
+            config.message_log_max_segments = std::stoul(next_value());
+        } else if (arg == "--trace-record") {
+            config.trace_file = next_value();
+        } else if (arg == "--rate-limit-fps") {
+            config.rate_limit.session_frames_per_s = std::stod(next_value());
+        } else if (arg == "--rate-limit-bps") {
+            config.rate_limit.session_bytes_per_s = std::stod(next_value());
+        } else if (arg == "--source-rate-limit-fps") {
+            config.rate_limit.source_frames_per_s = std::stod(next_value());
+        } else if (arg == "--source-rate-limit-bps") {
+            config.rate_limit.source_bytes_per_s = std::stod(next_value());
+        } else if (arg == "--rate-limit-burst-ms") {
+            config.rate_limit.burst_ms = std::stoul(next_value());
+        } else if (arg == "--latency-sample") {
+            config.latency_sample_interval = std::stoul(next_value());
+        } else if (arg == "--latency-trace") {
+            config.latency_trace_file = next_value();
+        } else if (arg == "--unix-socket") {
+            config.unix_socket_path = next_value();
+        } else if (arg == "--unix-socket-mode") {
+            config.unix_socket_mode = std::stoul(next_value(), nullptr, 8);
+        } else if (arg == "--unix-allow-uid") {
+            // 以逗號分隔的 uid 清單
+            std::stringstream list(next_value());
+            std::string uid;
+            while (std::getline(list, uid, ',')) {
+                if (!uid.empty()) config.unix_allowed_uids.push_back(std::stol(uid));
+            }
+        } else if (arg == "--ktls") {
+            config.ktls = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
 
-int main() {
+int main(int argc, char* argv[]) {
 
     // _CrtSetDbgFlag ( _CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF );
 
+    std::size_t thread_count = 0;
+    ServerConfig config;
+    std::string issue_subject;
+    long long token_ttl_s = 24 * 3600;
+    try {
+        if (!parse_options(argc, argv, thread_count, config, issue_subject, token_ttl_s)) {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--port P] [--peer HOST:PORT]... [--threads N] [--io-cpus LIST] [--numa-local]"
+                         " [--handshake-threads N] [--handshake-cpus LIST] [--logger-cpus LIST]"
+                         " [--worker-threads N] [--worker-cpus LIST]"
+                         " [--busy-poll US] [--metrics-interval S]"
+                         " [--message-log DIR] [--message-log-segment-mb N] [--message-log-max-segments N]"
+                         " [--auth-keys FILE] [--auth-cache N] [--trace-record FILE]"
+                         " [--rate-limit-fps N] [--rate-limit-bps N] [--source-rate-limit-fps N]"
+                         " [--source-rate-limit-bps N] [--rate-limit-burst-ms MS]"
+                         " [--latency-sample N] [--latency-trace FILE]"
+                         " [--unix-socket PATH] [--unix-socket-mode OCTAL] [--unix-allow-uid UID,...]"
+                         " [--ktls]" << std::endl;
+            std::cerr << "       " << argv[0] << " --auth-keys FILE --issue-token SUBJECT [--token-ttl S]" << std::endl;
+            std::cerr << "LIST uses the taskset format, e.g. 0-3,8" << std::endl;
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid option: " << e.what() << std::endl;
+        return 1;
+    }
+
+    // 簽發 token 給客戶端使用 (以金鑰檔的第一把金鑰簽章)
+    if (!issue_subject.empty()) {
+        try {
+            TokenAuthenticator authenticator(TokenAuthenticator::load_keys(config.auth_keys_file));
+            std::cout << authenticator.issue(issue_subject, std::chrono::seconds(token_ttl_s)) << std::endl;
+            return 0;
+        } catch (const std::exception& e) {
+            std::cerr << "Cannot issue token: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
     // 初始化spdlog的執行緒池(8192個佇列大小, 1個執行緒)
-    spdlog::init_thread_pool(8192, 1); 
+    // 若有保留 CPU 給日誌，日誌執行緒一啟動就綁定過去
+    spdlog::init_thread_pool(8192, 1, [cpus = config.logger_cpus] { pin_current_thread(cpus); }); 
 
     // 建立一個名為 "server" 的 logger，同時輸出到控制台和檔案
     auto logger = create_logger("server", "logs/server.log", "[%Y-%m-%d %H:%M:%S][%t][%^%l%$] %v");
@@ -26,13 +155,23 @@ int main() {
         
         logger->info("Starting server...");
 
-        const short port = 12345;
-        const auto thread_count = std::thread::hardware_concurrency();
+        const short port = static_cast<short>(config.port);
+        logger->info("Port: {}", config.port);
+        if (!config.peers.empty()) {
+            logger->info("Federation peers: {}", fmt::join(config.peers, ", "));
+        }
+        logger->info("Detected {} hardware threads", std::thread::hardware_concurrency());
 
-        logger->info("Port: {}", port);
-        logger->info("Detected {} hardware threads", thread_count);
+        // 未指定執行緒數時：有綁定 CPU 就每個 CPU 一條，否則使用硬體執行緒數
+        if (thread_count == 0) {
+            const auto io_cpus = config.resolve_io_cpus();
+            thread_count = io_cpus.empty() ? std::thread::hardware_concurrency() : io_cpus.size();
+        }
+        if (!config.logger_cpus.empty()) {
+            logger->info("Logger thread reserved CPU {}", format_cpu_list(config.logger_cpus));
+        }
 
-        ServerRunner server(port, thread_count, logger);
+        ServerRunner server(port, thread_count, logger, config);
 
         // 使用一個獨立的 io_context 來處理SIGINT, SIGTERM信號
         asio::io_context signal_context;
@@ -44,6 +183,20 @@ int main() {
             signal_context.stop();
         });
 
+#ifdef SIGUSR1
+        // 延遲追蹤：收到 SIGUSR1 時輸出目前的樣本，不需要停止伺服器
+        asio::signal_set dump_signal(signal_context);
+        std::function<void(const asio::error_code&, int)> on_dump = [&](const asio::error_code& ec, int) {
+            if (ec) return;
+            server.dump_latency_trace();
+            dump_signal.async_wait(on_dump);
+        };
+        if (!config.latency_trace_file.empty()) {
+            dump_signal.add(SIGUSR1);
+            dump_signal.async_wait(on_dump);
+        }
+#endif
+
         // 在主執行緒啟動伺服器執行緒池，並在背景執行信號處理
         std::thread signal_thread([&](){ signal_context.run(); });
 
@@ -11,13 +11,19 @@ set MESSAGE="SimpleStressTest"
 :: 要模擬的併發客戶端數量
 set CONCURRENT_CLIENTS=200
 
+:: 每個客戶端的測試時間 (秒)
+set DURATION=60
+
+:: Linux 上請改用 client-app 的多行程模式 (合併所有行程的結果)，例如：
+::   ./client-app 200 60 0 SimpleStressTest --processes 8 --rate 20000
+
 :: --- 執行 ---
 echo Starting %CONCURRENT_CLIENTS% concurrent clients...
 
 :: 迴圈啟動客戶端
 :: "start" 指令會讓每個客戶端在一個新的處理程序中非同步執行，而不會等待它結束
 for /L %%i in (1, 1, %CONCURRENT_CLIENTS%) do (
-    start "Client %%i" %CLIENT_EXE% %MESSAGE%
+    start "Client %%i" %CLIENT_EXE% 1 %DURATION% 0 %MESSAGE%
 )
 
 echo All clients have been launched.
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "server/Federation.hpp"
+
+namespace {
+
+// 建立總長度為 total_length 的發布訊框
+std::vector<char> publish_frame(std::size_t total_length) {
+    return FrameBuilder::build(CMD_PUBLISH_MESSAGE, std::string(total_length - sizeof(FrameHeader), 'x'));
+}
+
+// 批次訊框交給接收端的解析器，回傳解析結果與其中的訊框數
+ParseResult parse_batch(const std::vector<char>& bytes, std::size_t& frames) {
+    FrameParser parser;
+    parser.push_data(bytes.data(), bytes.size());
+    Frame batch;
+    const ParseResult result = parser.try_parse(batch);
+    if (result != ParseResult::SUCCESS) return result;
+    EXPECT_EQ(batch.header.command_id, CMD_PEER_FORWARD);
+
+    FrameParser inner;
+    inner.push_data(batch.payload.data(), batch.payload.size());
+    Frame frame;
+    frames = 0;
+    while (inner.try_parse(frame) == ParseResult::SUCCESS) ++frames;
+    return result;
+}
+
+} // namespace
+
+// 測試案例 1: 小訊框累積在同一個批次，批次標頭記錄總長度
+TEST(ForwardQueueTest, BatchesSmallFrames) {
+    ForwardQueue queue;
+    for (int i = 0; i < 10; ++i) ASSERT_TRUE(queue.push(publish_frame(100)));
+    EXPECT_EQ(queue.bytes(), 1000u);
+
+    const ForwardQueue::Batch batch = queue.pop();
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.bytes(), 0u);
+    EXPECT_EQ(batch.messages, 10u);
+    EXPECT_EQ(batch.bytes.size(), sizeof(FrameHeader) + 1000);
+
+    std::size_t frames = 0;
+    ASSERT_EQ(parse_batch(batch.bytes, frames), ParseResult::SUCCESS);
+    EXPECT_EQ(frames, 10u);
+}
+
+// 測試案例 2: 最大的可轉送訊框單獨成為一批，批次訊框剛好是解析器的上限
+TEST(ForwardQueueTest, MaxSizeFrameFitsInOneForwardFrame) {
+    ForwardQueue queue;
+    ASSERT_TRUE(queue.push(publish_frame(100)));
+    ASSERT_TRUE(queue.push(publish_frame(ForwardQueue::max_frame_bytes)));
+    ASSERT_TRUE(queue.push(publish_frame(100)));
+
+    std::vector<ForwardQueue::Batch> batches;
+    while (!queue.empty()) batches.push_back(queue.pop());
+    ASSERT_EQ(batches.size(), 3u);
+
+    EXPECT_EQ(batches[1].bytes.size(), FrameParser::max_frame_length);
+    for (const auto& batch : batches) {
+        EXPECT_LE(batch.bytes.size(), FrameParser::max_frame_length);
+        std::size_t frames = 0;
+        ASSERT_EQ(parse_batch(batch.bytes, frames), ParseResult::SUCCESS);
+        EXPECT_EQ(frames, 1u);
+    }
+}
+
+// 測試案例 3: 加上批次標頭就超過上限的訊框被拒絕，不影響已排入的批次
+TEST(ForwardQueueTest, RejectsFrameThatCannotFit) {
+    ForwardQueue queue;
+    ASSERT_TRUE(queue.push(publish_frame(100)));
+    EXPECT_FALSE(queue.push(publish_frame(FrameParser::max_frame_length)));
+    EXPECT_EQ(queue.bytes(), 100u);
+
+    EXPECT_EQ(queue.clear(), 1u);
+    EXPECT_TRUE(queue.empty());
+}
+
+// 測試案例 4: 批次承載資料必須剛好由完整的訊框組成，尾端不完整時整個批次被拒絕
+TEST(FederationTest, RejectsForwardBatchWithTrailingPartialFrame) {
+    ForwardQueue queue;
+    ASSERT_TRUE(queue.push(publish_frame(100)));
+    ASSERT_TRUE(queue.push(publish_frame(100)));
+    const ForwardQueue::Batch batch = queue.pop();
+    const std::string_view payload(batch.bytes.data() + sizeof(FrameHeader), batch.bytes.size() - sizeof(FrameHeader));
+
+    EXPECT_TRUE(Federation::well_formed_batch(payload));
+    EXPECT_TRUE(Federation::well_formed_batch({}));
+    EXPECT_FALSE(Federation::well_formed_batch(payload.substr(0, payload.size() - 1)));
+    EXPECT_FALSE(Federation::well_formed_batch(payload.substr(0, 100 + 3))); // 只剩下半個標頭
+}
@@ -144,4 +144,158 @@ TEST(FrameParserTest, HandleStickyPacketWithIncompleteTail) {
     Frame frame2;
     auto result2 = parser.try_parse(frame2);
     ASSERT_EQ(result2, ParseResult::NEED_MORE_DATA);
-}
\ No newline at end of file
+}
+
+// 測試案例 8: 批次訊框經過一般的解析後，可以依序走訪每個子訊息
+TEST(FrameParserTest, BuildAndWalkBatch) {
+    BatchBuilder builder;
+    ASSERT_TRUE(builder.add(CMD_PUBLISH_MESSAGE, "first"));
+    ASSERT_TRUE(builder.add(CMD_HEARTBEAT, ""));
+    ASSERT_TRUE(builder.add(CMD_SUBSCRIBE_TOPIC, "news"));
+    ASSERT_EQ(builder.count(), 3u);
+    auto packet = builder.build();
+    ASSERT_TRUE(builder.empty());
+
+    FrameParser parser;
+    parser.push_data(packet.data(), packet.size());
+    Frame frame;
+    ASSERT_EQ(parser.try_parse(frame), ParseResult::SUCCESS);
+    ASSERT_EQ(frame.header.command_id, CMD_BATCH);
+
+    BatchReader reader(frame.payload.data(), frame.payload.size());
+    BatchEntry entry;
+    ASSERT_TRUE(reader.next(entry));
+    ASSERT_EQ(entry.command_id, CMD_PUBLISH_MESSAGE);
+    ASSERT_EQ(entry.payload, "first");
+    // 子訊息直接指向批次訊框的記憶體
+    ASSERT_GE(entry.payload.data(), frame.payload.data());
+    ASSERT_LT(entry.payload.data(), frame.payload.data() + frame.payload.size());
+    ASSERT_TRUE(reader.next(entry));
+    ASSERT_EQ(entry.command_id, CMD_HEARTBEAT);
+    ASSERT_TRUE(entry.payload.empty());
+    ASSERT_TRUE(reader.next(entry));
+    ASSERT_EQ(entry.payload, "news");
+    ASSERT_FALSE(reader.next(entry));
+    ASSERT_FALSE(reader.malformed());
+}
+
+// 測試案例 9: 子訊息長度超出批次範圍時視為格式錯誤
+TEST(FrameParserTest, DetectTruncatedBatchEntry) {
+    BatchBuilder builder;
+    builder.add(CMD_PUBLISH_MESSAGE, "0123456789");
+    auto packet = builder.build();
+
+    // 去掉最後 3 個位元組 (不經過 FrameParser，直接走訪承載資料)
+    BatchReader reader(packet.data() + sizeof(FrameHeader), packet.size() - sizeof(FrameHeader) - 3);
+    BatchEntry entry;
+    ASSERT_FALSE(reader.next(entry));
+    ASSERT_TRUE(reader.malformed());
+}
+
+// 測試案例 10: 批次大小達到上限時拒絕加入新的子訊息
+TEST(FrameParserTest, BatchBuilderRespectsFrameLimit) {
+    BatchBuilder builder(64);
+    const std::string payload(20, 'x'); // 每個子訊息 4 + 20 bytes
+    ASSERT_TRUE(builder.add(CMD_PUBLISH_MESSAGE, payload));
+    ASSERT_TRUE(builder.add(CMD_PUBLISH_MESSAGE, payload));
+    ASSERT_FALSE(builder.add(CMD_PUBLISH_MESSAGE, payload)); // 8 + 72 > 64
+    ASSERT_EQ(builder.build().size(), sizeof(FrameHeader) + 48);
+}
+
+// 測試案例 11: 零複製解析：完整的訊框直接指向讀取的資料 (包含原本的標頭位元組)
+TEST(FrameParserTest, NextReturnsFramesInPlace) {
+    FrameParser parser;
+    auto first = FrameBuilder::build(CMD_PUBLISH_MESSAGE, "alpha");
+    auto second = FrameBuilder::build(CMD_HEARTBEAT);
+    std::vector<char> stream(first);
+    stream.insert(stream.end(), second.begin(), second.end());
+
+    const char* data = stream.data();
+    std::size_t length = stream.size();
+    FrameView frame;
+    ASSERT_EQ(parser.next(data, length, frame), ParseResult::SUCCESS);
+    ASSERT_FALSE(frame.buffered);
+    ASSERT_EQ(frame.bytes, stream.data());
+    ASSERT_EQ(frame.size, first.size());
+    ASSERT_EQ(frame.header.command_id, CMD_PUBLISH_MESSAGE);
+    ASSERT_EQ(frame.payload(), "alpha");
+
+    ASSERT_EQ(parser.next(data, length, frame), ParseResult::SUCCESS);
+    ASSERT_EQ(frame.header.command_id, CMD_HEARTBEAT);
+    ASSERT_TRUE(frame.payload().empty());
+    ASSERT_EQ(parser.next(data, length, frame), ParseResult::NEED_MORE_DATA);
+    ASSERT_EQ(length, 0u);
+}
+
+// 測試案例 12: 零複製解析：跨越讀取邊界的訊框 (包含被切開的標頭) 會組合起來，之後的訊框仍然不複製
+TEST(FrameParserTest, NextReassemblesFramesAcrossReads) {
+    FrameParser parser;
+    auto first = FrameBuilder::build(CMD_PUBLISH_MESSAGE, "this frame spans three reads");
+    auto second = FrameBuilder::build(CMD_PUBLISH_MESSAGE, "in place");
+    std::vector<char> stream(first);
+    stream.insert(stream.end(), second.begin(), second.end());
+
+    FrameView frame;
+    const std::size_t cuts[] = {3, 12, stream.size()}; // 第一次連標頭都不完整
+    std::size_t offset = 0;
+    std::vector<std::string> payloads;
+    std::vector<bool> buffered;
+    for (std::size_t cut : cuts) {
+        const char* data = stream.data() + offset;
+        std::size_t length = cut - offset;
+        offset = cut;
+        while (parser.next(data, length, frame) == ParseResult::SUCCESS) {
+            payloads.emplace_back(frame.payload());
+            buffered.push_back(frame.buffered);
+        }
+        ASSERT_EQ(length, 0u);
+    }
+    ASSERT_EQ(payloads, (std::vector<std::string>{"this frame spans three reads", "in place"}));
+    ASSERT_EQ(buffered, (std::vector<bool>{true, false}));
+    ASSERT_EQ(std::string(frame.bytes, frame.size), std::string(second.begin(), second.end()));
+}
+
+// 測試案例 13: 零複製解析：不合法的長度立即回報錯誤
+TEST(FrameParserTest, NextRejectsInvalidLength) {
+    FrameParser parser;
+    FrameHeader header;
+    encode_header(header, 3, CMD_PUBLISH_MESSAGE); // 比標頭本身還短
+    const char* data = reinterpret_cast<const char*>(&header);
+    std::size_t length = sizeof(header);
+    FrameView frame;
+    ASSERT_EQ(parser.next(data, length, frame), ParseResult::INVALID_HEADER);
+}
+
+// 測試案例 14: 零複製解析：暫停時保存的訊框 (包含不完整的尾端) 在之後的呼叫中依序取出
+TEST(FrameParserTest, NextResumesFromDeferredData) {
+    std::vector<char> stream;
+    for (const std::string payload : {"first", "second", "third", "fourth"}) {
+        const auto frame = FrameBuilder::build(CMD_PUBLISH_MESSAGE, payload);
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+    const std::size_t cut = stream.size() - 3; // 最後一個訊框分兩次讀到
+
+    FrameParser parser;
+    FrameView frame;
+    const char* data = stream.data();
+    std::size_t length = cut;
+    ASSERT_EQ(parser.next(data, length, frame), ParseResult::SUCCESS);
+    ASSERT_EQ(frame.payload(), "first");
+    parser.defer(data, length);
+    ASSERT_EQ(length, 0u);
+
+    // 沒有新資料時先取出保存的完整訊框
+    std::vector<std::string> payloads;
+    while (parser.next(data, length, frame) == ParseResult::SUCCESS) {
+        payloads.emplace_back(frame.payload());
+        EXPECT_TRUE(frame.buffered);
+    }
+    ASSERT_EQ(payloads, (std::vector<std::string>{"second", "third"}));
+
+    data = stream.data() + cut;
+    length = stream.size() - cut;
+    ASSERT_EQ(parser.next(data, length, frame), ParseResult::SUCCESS);
+    ASSERT_EQ(frame.payload(), "fourth");
+    ASSERT_EQ(length, 0u);
+    ASSERT_EQ(parser.next(data, length, frame), ParseResult::NEED_MORE_DATA);
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <openssl/sha.h>
+#include "server/HeavyCommands.hpp"
+
+namespace {
+
+// 回覆訊框的承載資料解碼成 DigestResponse (digest 指向 frame 的記憶體)
+DigestResponse decode_reply(const std::vector<char>& frame) {
+    FrameHeader header;
+    std::memcpy(&header, frame.data(), sizeof(header));
+    decode_header(header);
+    EXPECT_EQ(header.command_id, CMD_DIGEST_RESPONSE);
+    EXPECT_EQ(header.total_length, frame.size());
+    DigestResponse response;
+    EXPECT_TRUE(codec::decode(std::string_view(frame.data() + sizeof(FrameHeader), frame.size() - sizeof(FrameHeader)),
+                              response));
+    return response;
+}
+
+std::string payload_of(const DigestRequest& request) {
+    const std::vector<char> frame = FrameBuilder::build(request);
+    return std::string(frame.begin() + sizeof(FrameHeader), frame.end());
+}
+
+std::string sha256(std::string_view data) {
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(data.data()), data.size(), digest);
+    return std::string(reinterpret_cast<const char*>(digest), sizeof(digest));
+}
+
+} // namespace
+
+// 測試案例 1: 摘要請求被標記為耗用 CPU 的指令，結果與直接計算的迭代 SHA-256 相同
+TEST(HeavyCommandsTest, DigestRequestIteratesSha256) {
+    EXPECT_TRUE(is_heavy_command(CMD_DIGEST_REQUEST));
+    EXPECT_FALSE(is_heavy_command(CMD_PUBLISH_MESSAGE));
+
+    const std::vector<char> once = run_heavy_command(CMD_DIGEST_REQUEST, payload_of(DigestRequest{1, "hello"}));
+    DigestResponse response = decode_reply(once);
+    EXPECT_EQ(response.status, DIGEST_OK);
+    EXPECT_EQ(std::string(response.digest), sha256("hello"));
+
+    const std::vector<char> thrice = run_heavy_command(CMD_DIGEST_REQUEST, payload_of(DigestRequest{3, "hello"}));
+    response = decode_reply(thrice);
+    EXPECT_EQ(response.status, DIGEST_OK);
+    EXPECT_EQ(std::string(response.digest), sha256(sha256(sha256("hello"))));
+}
+
+// 測試案例 2: 格式錯誤或迭代次數超出範圍時回覆錯誤狀態；回覆可以就地設定請求 ID
+TEST(HeavyCommandsTest, RejectsBadRequestsAndCarriesRequestId) {
+    for (const std::string& payload : {payload_of(DigestRequest{0, "x"}),
+                                       payload_of(DigestRequest{max_digest_rounds + 1, "x"}), std::string("ab")}) {
+        const std::vector<char> frame = run_heavy_command(CMD_DIGEST_REQUEST, payload);
+        const DigestResponse response = decode_reply(frame);
+        EXPECT_EQ(response.status, DIGEST_BAD_REQUEST);
+        EXPECT_TRUE(response.digest.empty());
+    }
+
+    std::vector<char> frame = run_heavy_command(CMD_DIGEST_REQUEST, payload_of(DigestRequest{1, "x"}));
+    set_request_id(frame.data(), 42);
+    FrameHeader header;
+    std::memcpy(&header, frame.data(), sizeof(header));
+    EXPECT_EQ(header.request_id, 42);
+    EXPECT_EQ(header.flags, 0);
+}
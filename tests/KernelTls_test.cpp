@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include "server/KernelTls.hpp"
+
+namespace {
+
+std::string from_hex(std::string_view hex) {
+    std::string out;
+    for (std::size_t i = 0; i + 1 < hex.size(); i += 2) {
+        out.push_back(static_cast<char>(std::stoi(std::string(hex.substr(i, 2)), nullptr, 16)));
+    }
+    return out;
+}
+
+std::string as_string(const std::vector<unsigned char>& bytes) {
+    return std::string(bytes.begin(), bytes.end());
+}
+
+// 測試用的自簽憑證 (P-256)
+void use_self_signed_certificate(SSL_CTX* ctx) {
+    EVP_PKEY* key = EVP_EC_gen("P-256");
+    X509* cert = X509_new();
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME_add_entry_by_txt(X509_get_subject_name(cert), "CN", MBSTRING_ASC,
+                               reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert, X509_get_subject_name(cert));
+    X509_sign(cert, key, EVP_sha256());
+    SSL_CTX_use_certificate(ctx, cert);
+    SSL_CTX_use_PrivateKey(ctx, key);
+    X509_free(cert);
+    EVP_PKEY_free(key);
+}
+
+// 把一端寫出的 TLS record 交給另一端
+void pump(SSL* from, SSL* to) {
+    char buffer[16384];
+    int length = 0;
+    while ((length = BIO_read(SSL_get_wbio(from), buffer, sizeof(buffer))) > 0) {
+        BIO_write(SSL_get_rbio(to), buffer, length);
+    }
+}
+
+// 依 RFC 8446 5.2 以推導出的金鑰封裝一個應用資料 record (模擬核心的加密)
+std::string seal_record(const KernelTls::TxParameters& parameters, std::string_view payload) {
+    std::string inner(payload);
+    inner.push_back(0x17); // 內層的 content type: application_data
+    unsigned char nonce[12];
+    std::memcpy(nonce, parameters.keys.iv.data(), sizeof(nonce));
+    for (int i = 0; i < 8; ++i) nonce[4 + i] ^= static_cast<unsigned char>(parameters.sequence >> (8 * (7 - i)));
+    const std::size_t length = inner.size() + 16;
+    const unsigned char header[5] = {0x17, 0x03, 0x03, static_cast<unsigned char>(length >> 8),
+                                     static_cast<unsigned char>(length & 0xFF)};
+    const EVP_CIPHER* cipher = parameters.cipher_id == 0x1301 ? EVP_aes_128_gcm()
+                             : parameters.cipher_id == 0x1302 ? EVP_aes_256_gcm()
+                                                              : EVP_chacha20_poly1305();
+    std::string record(reinterpret_cast<const char*>(header), sizeof(header));
+    record.resize(sizeof(header) + length);
+    auto* out = reinterpret_cast<unsigned char*>(record.data()) + sizeof(header);
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    int written = 0;
+    EVP_EncryptInit_ex(ctx, cipher, nullptr, nullptr, nullptr);
+    EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_IVLEN, sizeof(nonce), nullptr);
+    EVP_EncryptInit_ex(ctx, nullptr, nullptr, parameters.keys.key.data(), nonce);
+    EVP_EncryptUpdate(ctx, nullptr, &written, header, sizeof(header));
+    EVP_EncryptUpdate(ctx, out, &written, reinterpret_cast<const unsigned char*>(inner.data()),
+                      static_cast<int>(inner.size()));
+    EVP_EncryptFinal_ex(ctx, out + written, &written);
+    EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, 16, out + inner.size());
+    EVP_CIPHER_CTX_free(ctx);
+    return record;
+}
+
+} // namespace
+
+// 測試案例 1: HKDF-Expand-Label 與 RFC 8448 (Simple 1-RTT Handshake) 的伺服器交握金鑰一致
+TEST(KernelTlsTest, DerivesTrafficKeysFromSecret) {
+    const std::string secret = from_hex("b67b7d690cc16c4e75e54213cb2d37b4e9c912bcded9105d42befd59d391ad38");
+    KernelTls::TrafficKeys keys;
+    ASSERT_TRUE(KernelTls::derive_traffic_keys(EVP_sha256(), secret, 16, keys));
+    EXPECT_EQ(as_string(keys.key), from_hex("3fce516009c21727d0f2e4e86ee403bc"));
+    EXPECT_EQ(as_string(keys.iv), from_hex("5d313eb2671276ee13000b30"));
+}
+
+// 測試案例 2: 交握後取得的金鑰與序號 (已計入 NewSessionTicket 與 OpenSSL 寫出的資料)
+// 封裝出的 record 可以由客戶端正常解密，也就是核心接手後寫出的內容
+TEST(KernelTlsTest, TxParametersContinueTheServerRecordStream) {
+    for (const char* suite : {"TLS_AES_128_GCM_SHA256", "TLS_AES_256_GCM_SHA384", "TLS_CHACHA20_POLY1305_SHA256"}) {
+        SCOPED_TRACE(suite);
+        SSL_CTX* server_ctx = SSL_CTX_new(TLS_server_method());
+        SSL_CTX* client_ctx = SSL_CTX_new(TLS_client_method());
+        use_self_signed_certificate(server_ctx);
+        SSL_CTX_set_ciphersuites(server_ctx, suite);
+        SSL_CTX_set_ciphersuites(client_ctx, suite);
+        KernelTls::install(server_ctx);
+
+        SSL* server = SSL_new(server_ctx);
+        SSL* client = SSL_new(client_ctx);
+        SSL_set_bio(server, BIO_new(BIO_s_mem()), BIO_new(BIO_s_mem()));
+        SSL_set_bio(client, BIO_new(BIO_s_mem()), BIO_new(BIO_s_mem()));
+        SSL_set_accept_state(server);
+        SSL_set_connect_state(client);
+        for (int i = 0; i < 8 && !(SSL_is_init_finished(server) && SSL_is_init_finished(client)); ++i) {
+            SSL_do_handshake(client);
+            pump(client, server);
+            SSL_do_handshake(server);
+            pump(server, client);
+        }
+        ASSERT_TRUE(SSL_is_init_finished(server));
+
+        // 切換之前 OpenSSL 寫出的應用資料也要計入序號
+        char buffer[64];
+        ASSERT_EQ(SSL_write(server, "before", 6), 6);
+        pump(server, client);
+        ASSERT_EQ(SSL_read(client, buffer, sizeof(buffer)), 6);
+
+        KernelTls::TxParameters parameters;
+        ASSERT_EQ(KernelTls::tx_parameters(server, parameters), KernelTlsStatus::ENABLED);
+        EXPECT_GE(parameters.sequence, 1u);
+
+        const std::string record = seal_record(parameters, "after");
+        BIO_write(SSL_get_rbio(client), record.data(), static_cast<int>(record.size()));
+        const int length = SSL_read(client, buffer, sizeof(buffer));
+        ASSERT_EQ(length, 5);
+        EXPECT_EQ(std::string(buffer, length), "after");
+
+        SSL_free(client);
+        SSL_free(server);
+        SSL_CTX_free(client_ctx);
+        SSL_CTX_free(server_ctx);
+    }
+}
@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+#include "utils/LatencyHistogram.hpp"
+
+// 測試案例 1: 序列化後合併的結果與直接合併相同 (多行程模式把工作行程的直方圖傳回協調者)
+TEST(LatencyHistogramTest, SerializedMergeMatchesDirectMerge) {
+    LatencyHistogram a;
+    LatencyHistogram b;
+    for (uint64_t i = 1; i <= 1000; ++i) {
+        a.record(i * 1000);
+        b.record(i * 7919);
+    }
+
+    LatencyHistogram direct;
+    direct.merge(a);
+    direct.merge(b);
+
+    LatencyHistogram serialized;
+    ASSERT_TRUE(serialized.merge_serialized(a.serialize()));
+    ASSERT_TRUE(serialized.merge_serialized(b.serialize()));
+
+    EXPECT_EQ(serialized.count(), direct.count());
+    EXPECT_EQ(serialized.max(), direct.max());
+    for (double p : {50.0, 90.0, 99.0, 99.9}) {
+        EXPECT_EQ(serialized.percentile(p), direct.percentile(p)) << "p" << p;
+    }
+}
+
+// 測試案例 2: 空的直方圖與格式錯誤的輸入
+TEST(LatencyHistogramTest, SerializedMergeRejectsMalformedInput) {
+    LatencyHistogram empty;
+    LatencyHistogram histogram;
+    EXPECT_TRUE(histogram.merge_serialized(empty.serialize()));
+    EXPECT_EQ(histogram.count(), 0u);
+
+    EXPECT_FALSE(histogram.merge_serialized(""));
+    EXPECT_FALSE(histogram.merge_serialized("100 3"));
+    EXPECT_FALSE(histogram.merge_serialized("100 x:1"));
+    EXPECT_FALSE(histogram.merge_serialized("100 99999:1"));
+}
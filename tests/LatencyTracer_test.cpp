@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "server/LatencyTracer.hpp"
+
+namespace {
+
+FrameSample make_sample(uint32_t connection_id, int64_t base_ns) {
+    FrameSample sample;
+    sample.connection_id = connection_id;
+    sample.command_id = 2001;
+    sample.payload_size = 5;
+    for (std::size_t i = 0; i < FRAME_STAMP_COUNT; ++i) {
+        sample.stamps[i] = base_ns + static_cast<int64_t>(i) * 1000;
+    }
+    return sample;
+}
+
+// 測試案例 1: 每 N 次讀取取樣一次
+TEST(LatencyTracerTest, SamplesOneInInterval) {
+    LatencyTracer tracer(4);
+    // 同一條執行緒的倒數可能被其他測試用掉一部分，先對齊到一次取樣
+    while (!tracer.sample()) {}
+    int sampled = 0;
+    for (int i = 0; i < 40; ++i) {
+        sampled += tracer.sample() ? 1 : 0;
+    }
+    EXPECT_EQ(sampled, 10);
+}
+
+// 測試案例 2: 缺少的時間點 (沒有回覆) 不計入階段耗時
+TEST(LatencyTracerTest, StagesSkipMissingStamps) {
+    FrameSample sample = make_sample(1, 1000000);
+    sample.stamps[static_cast<std::size_t>(FrameStamp::WRITE_STARTED)] = 0;
+    sample.stamps[static_cast<std::size_t>(FrameStamp::WRITTEN)] = 0;
+    EXPECT_EQ(sample.stage_ns(0), 1000);
+    EXPECT_EQ(sample.stage_ns(3), 1000);
+    EXPECT_EQ(sample.stage_ns(4), -1);
+    EXPECT_EQ(sample.stage_ns(5), -1);
+}
+
+// 測試案例 3: 環狀緩衝區滿了之後保留最新的樣本；每條執行緒各自一個緩衝區
+TEST(LatencyTracerTest, RingKeepsNewestSamplesPerThread) {
+    LatencyTracer tracer(1, 8);
+    for (uint32_t i = 1; i <= 20; ++i) {
+        tracer.record(make_sample(i, 1000000 * i));
+    }
+    std::thread other([&] { tracer.record(make_sample(100, 5000)); });
+    other.join();
+
+    const auto samples = tracer.snapshot();
+    ASSERT_EQ(samples.size(), 9u);
+    EXPECT_EQ(samples.front().connection_id, 13u);
+    EXPECT_EQ(samples[7].connection_id, 20u);
+    EXPECT_EQ(samples.back().connection_id, 100u);
+    EXPECT_EQ(samples.back().stamps, make_sample(100, 5000).stamps);
+    EXPECT_EQ(tracer.recorded(), 21u);
+}
+
+// 測試案例 4: 輸出 Chrome trace JSON，每個樣本一個訊框事件加上每個階段一個事件
+TEST(LatencyTracerTest, DumpsChromeTraceEvents) {
+    const std::string path = (std::filesystem::temp_directory_path() / "latency_tracer_test.json").string();
+    LatencyTracer tracer(1);
+    tracer.record(make_sample(7, FrameSample::now_ns()));
+    ASSERT_EQ(tracer.dump(path), 1u);
+
+    std::ifstream in(path);
+    std::stringstream content;
+    content << in.rdbuf();
+    const std::string json = content.str();
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0u);
+    EXPECT_NE(json.find("\"name\":\"frame 2001\""), std::string::npos);
+    for (std::size_t stage = 0; stage < FRAME_STAGE_COUNT; ++stage) {
+        EXPECT_NE(json.find(std::string("\"name\":\"") + frame_stage_name(stage) + "\""), std::string::npos);
+    }
+    std::size_t events = 0;
+    for (std::size_t pos = 0; (pos = json.find("\"ph\":\"X\"", pos)) != std::string::npos; ++pos) ++events;
+    EXPECT_EQ(events, 1 + FRAME_STAGE_COUNT);
+    EXPECT_NE(json.find("\"tid\":7"), std::string::npos);
+}
+
+} // namespace
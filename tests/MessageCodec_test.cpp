@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "frame/Messages.hpp"
+#include "frame/FrameBuilder.hpp"
+#include "frame/FrameParser.hpp"
+
+namespace {
+
+// 測試用：同時有帶長度字串與剩餘位元組的訊息
+struct TaggedNote {
+    uint16_t tag = 0;
+    std::string_view label;
+    std::string_view body;
+};
+
+} // namespace
+
+template <>
+struct codec::MessageSchema<TaggedNote> {
+    static constexpr CommandID command = CMD_HEARTBEAT;
+    static constexpr auto fields = std::make_tuple(codec::field(&TaggedNote::tag), codec::text(&TaggedNote::label),
+                                                   codec::tail(&TaggedNote::body));
+};
+
+namespace {
+
+std::string_view payload_of(const std::vector<char>& frame) {
+    return std::string_view(frame.data() + sizeof(FrameHeader), frame.size() - sizeof(FrameHeader));
+}
+
+// 測試案例 1: 與原本手寫的線上格式相同 (整數為網路位元組序)
+TEST(MessageCodecTest, MatchesHandWrittenWireFormat) {
+    const auto frame = FrameBuilder::build(ReplayResponse{REPLAY_BAD_REQUEST, 0x0102030405060708ULL});
+    const std::string expected("\x02\x01\x02\x03\x04\x05\x06\x07\x08", 9);
+    EXPECT_EQ(payload_of(frame), expected);
+
+    const auto interest = FrameBuilder::build(PeerInterest{true, "news"});
+    EXPECT_EQ(interest, FrameBuilder::build(CMD_PEER_INTEREST, std::string("\1news", 5)));
+}
+
+// 測試案例 2: 編碼後再解碼得到相同的欄位，字串直接指向訊框
+TEST(MessageCodecTest, RoundTripsWithoutCopyingStrings) {
+    const auto frame = FrameBuilder::build(TaggedNote{7, "label", "the rest"});
+    ASSERT_EQ(frame.size(), sizeof(FrameHeader) + 2 + 2 + 5 + 8);
+
+    FrameParser parser;
+    const char* data = frame.data();
+    std::size_t length = frame.size();
+    FrameView view;
+    ASSERT_EQ(parser.next(data, length, view), ParseResult::SUCCESS);
+
+    TaggedNote note;
+    ASSERT_TRUE(view.decode(note));
+    EXPECT_EQ(note.tag, 7);
+    EXPECT_EQ(note.label, "label");
+    EXPECT_EQ(note.body, "the rest");
+    EXPECT_GE(note.body.data(), frame.data());
+    EXPECT_LT(note.body.data(), frame.data() + frame.size());
+
+    // 指令 ID 不符時不解碼
+    ReplayRequest request;
+    EXPECT_FALSE(view.decode(request));
+}
+
+// 測試案例 3: 截斷、多出位元組與超出範圍的長度都視為格式錯誤
+TEST(MessageCodecTest, RejectsMalformedPayloads) {
+    ReplayRequest request;
+    EXPECT_FALSE(codec::decode(std::string_view("\0\0\0\0\0\0\0", 7), request));
+    EXPECT_FALSE(codec::decode(std::string_view("\0\0\0\0\0\0\0\0\0", 9), request));
+    EXPECT_TRUE(codec::decode(std::string_view("\0\0\0\0\0\0\1\0", 8), request));
+    EXPECT_EQ(request.offset, 256u);
+
+    TaggedNote note;
+    EXPECT_FALSE(codec::decode(std::string_view("\0\1\0\x09" "abc", 7), note)); // 字串長度超出承載資料
+    EXPECT_FALSE(codec::decode(std::string_view("\0", 1), note));
+
+    AuthResponse empty;
+    EXPECT_FALSE(codec::decode(std::string_view(), empty));
+}
+
+// 測試案例 4: 寫入呼叫端的緩衝區時檢查邊界
+TEST(MessageCodecTest, WriteChecksCapacity) {
+    char buffer[sizeof(FrameHeader) + 4];
+    EXPECT_EQ(FrameBuilder::write(BatchAck{3}, buffer, sizeof(buffer)), sizeof(buffer));
+    EXPECT_EQ(std::vector<char>(buffer, buffer + sizeof(buffer)), FrameBuilder::build(BatchAck{3}));
+    EXPECT_EQ(FrameBuilder::write(BatchAck{3}, buffer, sizeof(buffer) - 1), 0u);
+
+    const std::string long_label(70000, 'x');
+    std::vector<char> large(80000);
+    EXPECT_EQ(FrameBuilder::write(TaggedNote{1, long_label, {}}, large.data(), large.size()), 0u);
+}
+
+// 測試案例 5: 批次中的子訊息可以由 schema 直接編碼
+TEST(MessageCodecTest, BatchBuilderEncodesMessages) {
+    BatchBuilder batch;
+    ASSERT_TRUE(batch.add(SubscribeRequest{"alpha"}));
+    ASSERT_TRUE(batch.add(ReplayRequest{42}));
+    const auto frame = batch.build();
+
+    BatchReader reader(frame.data() + sizeof(FrameHeader), frame.size() - sizeof(FrameHeader));
+    BatchEntry entry;
+    SubscribeRequest subscribe;
+    ASSERT_TRUE(reader.next(entry));
+    ASSERT_TRUE(codec::decode(entry.command_id, entry.payload, subscribe));
+    EXPECT_EQ(subscribe.topic, "alpha");
+
+    ReplayRequest replay;
+    ASSERT_TRUE(reader.next(entry));
+    ASSERT_TRUE(codec::decode(entry.command_id, entry.payload, replay));
+    EXPECT_EQ(replay.offset, 42u);
+    EXPECT_FALSE(reader.next(entry));
+    EXPECT_FALSE(reader.malformed());
+}
+
+// 測試案例 6: 無法編碼的訊息不會產生訊框 (除錯版直接中止)
+TEST(MessageCodecTest, BuildRejectsUnencodableMessage) {
+    const std::string long_label(70000, 'x');
+    EXPECT_DEBUG_DEATH(EXPECT_TRUE(FrameBuilder::build(TaggedNote{1, long_label, {}}).empty()), "cannot be encoded");
+}
+
+} // namespace
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <spdlog/sinks/null_sink.h>
+#include "storage/MessageLog.hpp"
+#include "frame/FrameParser.hpp"
+#include "frame/FrameBuilder.hpp"
+
+namespace {
+
+// 每個測試使用獨立的暫存目錄，結束時刪除
+class MessageLogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() /
+               ("message_log_test_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::remove_all(dir_);
+        logger_ = std::make_shared<spdlog::logger>("message_log_test", std::make_shared<spdlog::sinks::null_sink_mt>());
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir_);
+    }
+
+    MessageLog::Options options(std::size_t segment_bytes = 4096, std::size_t max_segments = 0) {
+        MessageLog::Options opts;
+        opts.directory = dir_.string();
+        opts.segment_bytes = segment_bytes;
+        opts.index_interval = 4;
+        opts.max_segments = max_segments;
+        return opts;
+    }
+
+    // 將重播區塊解析回訊息內容
+    static std::vector<std::string> decode(const ReplayChunk& chunk) {
+        FrameParser parser;
+        parser.push_data(chunk.data, chunk.size);
+        std::vector<std::string> messages;
+        Frame frame;
+        while (parser.try_parse(frame) == ParseResult::SUCCESS) {
+            messages.emplace_back(frame.payload.begin(), frame.payload.end());
+        }
+        return messages;
+    }
+
+    std::filesystem::path dir_;
+    std::shared_ptr<spdlog::logger> logger_;
+};
+
+std::shared_ptr<const std::vector<char>> publish_frame(const std::string& payload) {
+    return std::make_shared<const std::vector<char>>(FrameBuilder::build(CMD_PUBLISH_MESSAGE, payload));
+}
+
+} // namespace
+
+// 測試案例 1: 附加後可以從 offset 0 讀回完整且順序正確的訊框
+TEST_F(MessageLogTest, AppendAndReadFromStart) {
+    MessageLog log(options(), logger_);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(log.append(publish_frame("msg" + std::to_string(i))));
+    }
+    log.sync();
+
+    ASSERT_EQ(log.next_offset(), 10u);
+    auto chunk = log.read(0, 65536);
+    auto messages = decode(chunk);
+    ASSERT_EQ(messages.size(), 10u);
+    ASSERT_EQ(messages.front(), "msg0");
+    ASSERT_EQ(messages.back(), "msg9");
+    ASSERT_EQ(chunk.next_offset, 10u);
+}
+
+// 測試案例 2: 透過稀疏索引從中間的 offset 開始讀取
+TEST_F(MessageLogTest, ReadFromMiddleOffset) {
+    MessageLog log(options(), logger_);
+    for (int i = 0; i < 20; ++i) {
+        log.append(publish_frame("msg" + std::to_string(i)));
+    }
+    log.sync();
+
+    auto chunk = log.read(13, 65536);
+    auto messages = decode(chunk);
+    ASSERT_EQ(chunk.first_offset, 13u);
+    ASSERT_EQ(messages.size(), 7u);
+    ASSERT_EQ(messages.front(), "msg13");
+}
+
+// 測試案例 3: 超過區段大小時切換到新區段，讀取端可逐段讀完
+TEST_F(MessageLogTest, RollsSegmentsAndReadsAcrossThem) {
+    MessageLog log(options(1024), logger_);
+    const std::string payload(100, 'x');
+    for (int i = 0; i < 50; ++i) {
+        log.append(publish_frame(payload));
+    }
+    log.sync();
+
+    uint64_t offset = 0;
+    std::size_t total = 0;
+    while (true) {
+        auto chunk = log.read(offset, 65536);
+        if (chunk.size == 0) break;
+        total += decode(chunk).size();
+        offset = chunk.next_offset;
+    }
+    ASSERT_EQ(total, 50u);
+    ASSERT_GT(std::distance(std::filesystem::directory_iterator(dir_), std::filesystem::directory_iterator{}), 1);
+}
+
+// 測試案例 4: 重新開啟時從既有的區段檔案復原，並接續原本的 offset
+TEST_F(MessageLogTest, RecoversExistingSegmentsOnReopen) {
+    {
+        MessageLog log(options(), logger_);
+        for (int i = 0; i < 5; ++i) {
+            log.append(publish_frame("before" + std::to_string(i)));
+        }
+        log.sync();
+    }
+
+    MessageLog log(options(), logger_);
+    ASSERT_EQ(log.next_offset(), 5u);
+    log.append(publish_frame("after"));
+    log.sync();
+
+    auto messages = decode(log.read(3, 65536));
+    ASSERT_EQ(messages.size(), 3u);
+    ASSERT_EQ(messages[0], "before3");
+    ASSERT_EQ(messages[2], "after");
+}
+
+// 測試案例 5: 超過保留上限時刪除最舊的區段，讀取過舊的 offset 從最舊的訊息開始
+TEST_F(MessageLogTest, RetentionDropsOldestSegments) {
+    MessageLog log(options(1024, 2), logger_);
+    const std::string payload(100, 'y');
+    for (int i = 0; i < 50; ++i) {
+        log.append(publish_frame(payload));
+    }
+    log.sync();
+
+    ASSERT_GT(log.first_offset(), 0u);
+    auto chunk = log.read(0, 65536);
+    ASSERT_EQ(chunk.first_offset, log.first_offset());
+}
+
+// 測試案例 6: 每個區塊不超過位元組上限，但至少包含一則完整訊息
+TEST_F(MessageLogTest, ChunkRespectsByteLimit) {
+    MessageLog log(options(), logger_);
+    for (int i = 0; i < 10; ++i) {
+        log.append(publish_frame(std::string(92, 'z'))); // 每個訊框 100 bytes
+    }
+    log.sync();
+
+    ASSERT_EQ(log.read(0, 250).message_count, 2u);
+    ASSERT_EQ(log.read(0, 10).message_count, 1u);
+}
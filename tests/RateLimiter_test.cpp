@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "server/RateLimiter.hpp"
+
+namespace {
+
+using std::chrono::milliseconds;
+using std::chrono::nanoseconds;
+
+constexpr int64_t ms = 1000 * 1000;
+
+// 測試案例 1: 突發額度內不需等待，超過後等待時間與透支量成正比
+TEST(TokenBucketTest, AllowsBurstThenPaces) {
+    TokenBucket bucket;
+    bucket.configure(1000, milliseconds(100)); // 每秒 1000 個令牌，突發 100 個
+
+    const int64_t now = 10000 * ms;
+    EXPECT_EQ(bucket.consume(100, now), nanoseconds(0));
+    EXPECT_EQ(bucket.consume(10, now), nanoseconds(10 * ms));
+    EXPECT_EQ(bucket.consume(10, now), nanoseconds(20 * ms));
+
+    // 等到令牌補回來之後又回到限制內
+    EXPECT_EQ(bucket.consume(1, now + 30 * ms), nanoseconds(0));
+}
+
+// 測試案例 2: 閒置期間累積的令牌不會超過突發額度
+TEST(TokenBucketTest, IdleTimeDoesNotAccumulateBeyondBurst) {
+    TokenBucket bucket;
+    bucket.configure(1000, milliseconds(100));
+
+    EXPECT_EQ(bucket.consume(1, 0), nanoseconds(0));
+    const int64_t later = 60 * 1000 * ms;
+    EXPECT_EQ(bucket.consume(100, later), nanoseconds(0));
+    EXPECT_GT(bucket.consume(1, later).count(), 0);
+}
+
+// 測試案例 3: 未設定速率時不做任何限制
+TEST(TokenBucketTest, UnconfiguredBucketNeverWaits) {
+    TokenBucket bucket;
+    EXPECT_FALSE(bucket.enabled());
+    EXPECT_EQ(bucket.consume(1e12, 0), nanoseconds(0));
+
+    RateLimiter limiter;
+    limiter.configure(RateLimitConfig{}, nullptr);
+    EXPECT_FALSE(limiter.enabled());
+}
+
+// 測試案例 4: 多條執行緒共用同一個桶時，扣除的令牌一個都不會遺失
+TEST(TokenBucketTest, ConcurrentConsumersShareOneBudget) {
+    TokenBucket bucket;
+    bucket.configure(1000, milliseconds(0));
+
+    constexpr int threads = 4;
+    constexpr int per_thread = 10000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&bucket] {
+            for (int i = 0; i < per_thread; ++i) bucket.consume(1, 0);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    // 每個令牌 1ms：下一個令牌要等到全部扣除量之後
+    EXPECT_EQ(bucket.consume(1, 0), nanoseconds(int64_t{threads * per_thread + 1} * ms));
+}
+
+// 測試案例 5: 同一個來源 IP 的連線共用令牌桶，最後一條連線關閉後重新建立
+TEST(SourceRateLimitsTest, SharesBucketsPerAddress) {
+    RateLimitConfig config;
+    config.source_frames_per_s = 100;
+    SourceRateLimits limits(config);
+
+    auto first = limits.acquire("10.0.0.1");
+    auto second = limits.acquire("10.0.0.1");
+    auto other = limits.acquire("10.0.0.2");
+    EXPECT_EQ(first, second);
+    EXPECT_NE(first, other);
+    EXPECT_TRUE(first->frames.enabled());
+    EXPECT_FALSE(first->bytes.enabled());
+
+    first->frames.consume(1000, 0);
+    first.reset();
+    second.reset();
+    auto fresh = limits.acquire("10.0.0.1");
+    EXPECT_EQ(fresh->frames.consume(1, 0), nanoseconds(0));
+    EXPECT_EQ(limits.size(), 2u);
+}
+
+// 測試案例 6: 來源的限制比連線的限制嚴格時，由來源造成暫停
+TEST(RateLimiterTest, ReportsWhichLimitApplies) {
+    RateLimitConfig config;
+    config.session_frames_per_s = 1000;
+    config.source_frames_per_s = 10;
+    config.burst_ms = 0;
+    SourceRateLimits limits(config);
+
+    RateLimiter limiter;
+    limiter.configure(config, limits.acquire("127.0.0.1"));
+    ASSERT_TRUE(limiter.enabled());
+    const auto verdict = limiter.charge(5, 0);
+    EXPECT_TRUE(verdict.by_source);
+    EXPECT_GT(verdict.wait, milliseconds(400));
+}
+
+} // namespace
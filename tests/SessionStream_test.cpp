@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <asio.hpp>
+#include "server/SessionStream.hpp"
+
+#if defined(ASIO_HAS_LOCAL_SOCKETS) && defined(SO_PEERCRED)
+#include <unistd.h>
+
+// 測試案例 1: SO_PEERCRED 取得的是對端行程的身分
+TEST(SessionStreamTest, ReadsPeerCredentials) {
+    asio::io_context io_context;
+    asio::local::stream_protocol::socket a(io_context);
+    asio::local::stream_protocol::socket b(io_context);
+    asio::local::connect_pair(a, b);
+
+    const PeerCredentials credentials = read_peer_credentials(a);
+    ASSERT_TRUE(credentials.known());
+    EXPECT_EQ(credentials.uid, static_cast<int64_t>(::getuid()));
+    EXPECT_EQ(credentials.pid, static_cast<int64_t>(::getpid()));
+
+    SessionStream stream(std::move(a), credentials);
+    EXPECT_FALSE(stream.is_tls());
+    EXPECT_FALSE(stream.has_buffered_data());
+    EXPECT_EQ(stream.remote_address_string(), "unix:uid=" + std::to_string(::getuid()));
+}
+
+// 測試案例 2: Unix domain socket 上多個 buffer 一次寫出，對端收到的是依序串接的位元組
+TEST(SessionStreamTest, WritesBufferSequenceOverLocalSocket) {
+    asio::io_context io_context;
+    asio::local::stream_protocol::socket a(io_context);
+    asio::local::stream_protocol::socket b(io_context);
+    asio::local::connect_pair(a, b);
+    SessionStream stream(std::move(a), PeerCredentials{});
+
+    const std::string first = "hello ";
+    const std::string second = "world";
+    std::vector<asio::const_buffer> buffers{asio::buffer(first), asio::buffer(second)};
+    std::size_t written = 0;
+    asio::async_write(stream, buffers, [&](const asio::error_code& ec, std::size_t length) {
+        EXPECT_FALSE(ec);
+        written = length;
+    });
+    io_context.run();
+    EXPECT_EQ(written, first.size() + second.size());
+
+    std::string received(first.size() + second.size(), '\0');
+    asio::read(b, asio::buffer(received));
+    EXPECT_EQ(received, first + second);
+}
+#endif
@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <future>
+#include <string>
+#include <vector>
+#include <asio.hpp>
+#include <spdlog/sinks/null_sink.h>
+#include "server/Session.hpp"
+
+#if defined(ASIO_HAS_LOCAL_SOCKETS) && defined(SO_PEERCRED)
+
+namespace {
+
+// 以 Unix domain socket 連線建立 Session (不需要憑證與 TLS 交握)；測試端持有另一端的 socket
+class SessionTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        services_ = std::make_shared<SessionServices>();
+        services_->logger = std::make_shared<spdlog::logger>("session_test", std::make_shared<spdlog::sinks::null_sink_mt>());
+        services_->metrics = std::make_shared<ServerMetrics>();
+        services_->topics = std::make_shared<TopicRegistry>();
+    }
+
+    // 建立連線並啟動 Session，回傳測試端的 socket
+    asio::local::stream_protocol::socket connect() {
+        asio::local::stream_protocol::socket server_side(io_context_);
+        asio::local::stream_protocol::socket client_side(io_context_);
+        asio::local::connect_pair(server_side, client_side);
+        const PeerCredentials credentials = read_peer_credentials(server_side);
+        std::make_shared<Session>(SessionStream(std::move(server_side), credentials), services_)->start();
+        return client_side;
+    }
+
+    // 讀取一個完整的訊框 (在背景執行 io_context，直到讀完或連線關閉)
+    bool read_frame(asio::local::stream_protocol::socket& socket, FrameHeader& header, std::string& payload) {
+        bool done = false;
+        bool ok = false;
+        asio::async_read(socket, asio::buffer(&header, sizeof(header)), [&](const asio::error_code& ec, std::size_t) {
+            if (ec) {
+                done = true;
+                return;
+            }
+            decode_header(header);
+            payload.resize(header.total_length - sizeof(FrameHeader));
+            asio::async_read(socket, asio::buffer(payload), [&](const asio::error_code& ec, std::size_t) {
+                ok = !ec;
+                done = true;
+            });
+        });
+        io_context_.restart();
+        while (!done && io_context_.run_one_for(std::chrono::seconds(2)) > 0) {}
+        return ok;
+    }
+
+    // 連線是否已被伺服器關閉 (讀到 EOF)
+    bool closed_by_server(asio::local::stream_protocol::socket& socket) {
+        char byte;
+        bool done = false;
+        bool eof = false;
+        socket.async_read_some(asio::buffer(&byte, 1), [&](const asio::error_code& ec, std::size_t) {
+            eof = ec == asio::error::eof;
+            done = true;
+        });
+        io_context_.restart();
+        while (!done && io_context_.run_one_for(std::chrono::seconds(2)) > 0) {}
+        return eof;
+    }
+
+    // 交給 services_->worker_executor 的工作執行緒 (測試中需要時才設定)
+    void use_workers() { services_->worker_executor = workers_.get_executor(); }
+
+    asio::io_context io_context_;
+    asio::thread_pool workers_{1};
+    std::shared_ptr<SessionServices> services_;
+};
+
+} // namespace
+
+// 測試案例 1: 啟用認證時，沒有節點身分的連線 (以 uid 認證的本機連線) 送出 PEER_HELLO 會被拒絕並關閉
+TEST_F(SessionTest, RefusesPeerHelloWithoutPeerIdentity) {
+    services_->authenticator = std::make_shared<TokenAuthenticator>(
+        std::vector<TokenAuthenticator::Key>{{"k1", "secret"}});
+    auto socket = connect();
+    asio::write(socket, asio::buffer(FrameBuilder::build(PeerHello{"intruder"})));
+
+    FrameHeader header;
+    std::string payload;
+    ASSERT_TRUE(read_frame(socket, header, payload));
+    AuthResponse response;
+    ASSERT_TRUE(codec::decode(header.command_id, payload, response));
+    EXPECT_EQ(response.status, static_cast<uint8_t>(AuthStatus::FORBIDDEN));
+    EXPECT_TRUE(closed_by_server(socket));
+    EXPECT_EQ(services_->metrics->auth_failed.load(), 1u);
+}
+
+// 測試案例 2: 被拒絕的連線不再接收訂閱的訊息，持續有訊息發布時仍會在回覆寫出後關閉
+TEST_F(SessionTest, RejectedSubscriberClosesDespiteFanOut) {
+    services_->authenticator = std::make_shared<TokenAuthenticator>(
+        std::vector<TokenAuthenticator::Key>{{"k1", "secret"}});
+    auto socket = connect();
+    asio::write(socket, asio::buffer(FrameBuilder::build(SubscribeRequest{"news"})));
+    FrameHeader header;
+    std::string payload;
+    ASSERT_TRUE(read_frame(socket, header, payload));
+    ASSERT_EQ(header.command_id, CMD_SUBSCRIBE_TOPIC);
+
+    asio::write(socket, asio::buffer(FrameBuilder::build(PeerHello{"intruder"})));
+    auto message = std::make_shared<const std::vector<char>>(FrameBuilder::build(CMD_PUBLISH_MESSAGE, std::string_view("news\0hello", 10)));
+    bool closed = false;
+    // 每讀到一個訊框就再發布兩則，寫入佇列不會自己清空
+    for (int i = 0; i < 200 && !closed; ++i) {
+        services_->topics->publish("news", message, PriorityClass::BULK);
+        services_->topics->publish("news", message, PriorityClass::BULK);
+        closed = !read_frame(socket, header, payload);
+    }
+    EXPECT_TRUE(closed);
+    EXPECT_EQ(services_->topics->topic_count(), 0u);
+}
+
+// 測試案例 3: 批次中的耗用 CPU 指令不執行，以錯誤狀態回覆，批次照常確認
+TEST_F(SessionTest, RejectsHeavyCommandsInsideBatch) {
+    auto socket = connect();
+    BatchBuilder batch;
+    ASSERT_TRUE(batch.add(DigestRequest{max_digest_rounds, "x"}));
+    asio::write(socket, asio::buffer(batch.build()));
+
+    FrameHeader header;
+    std::string payload;
+    ASSERT_TRUE(read_frame(socket, header, payload));
+    DigestResponse response;
+    ASSERT_TRUE(codec::decode(header.command_id, payload, response));
+    EXPECT_EQ(response.status, DIGEST_BAD_REQUEST);
+
+    ASSERT_TRUE(read_frame(socket, header, payload));
+    BatchAck ack;
+    ASSERT_TRUE(codec::decode(header.command_id, payload, ack));
+    EXPECT_EQ(ack.count, 1u);
+    EXPECT_EQ(services_->metrics->worker_inline.load(), 0u);
+}
+
+// 測試案例 4: 有工作執行緒時，慢的摘要請求不會擋住之後的回音；兩個回覆都帶回各自的請求 ID
+TEST_F(SessionTest, HeavyCommandRunsOnWorkerAndRepliesOutOfOrder) {
+    use_workers();
+    auto socket = connect();
+    std::vector<char> digest = FrameBuilder::build(DigestRequest{max_digest_rounds / 4, "slow"});
+    set_request_id(digest.data(), 1);
+    std::vector<char> echo = FrameBuilder::build(CMD_HEARTBEAT, "ping");
+    set_request_id(echo.data(), 2);
+    std::vector<char> frames(digest);
+    frames.insert(frames.end(), echo.begin(), echo.end());
+    asio::write(socket, asio::buffer(frames));
+
+    FrameHeader header;
+    std::string payload;
+    ASSERT_TRUE(read_frame(socket, header, payload));
+    EXPECT_EQ(header.command_id, CMD_HEARTBEAT);
+    EXPECT_EQ(header.request_id, 2);
+    EXPECT_EQ(payload, "ping");
+
+    ASSERT_TRUE(read_frame(socket, header, payload));
+    EXPECT_EQ(header.request_id, 1);
+    DigestResponse response;
+    ASSERT_TRUE(codec::decode(header.command_id, payload, response));
+    EXPECT_EQ(response.status, DIGEST_OK);
+    EXPECT_EQ(response.digest.size(), 32u);
+    EXPECT_EQ(services_->metrics->worker_jobs.load(), 1u);
+    EXPECT_EQ(services_->metrics->worker_inline.load(), 0u);
+}
+
+// 測試案例 5: 沒有工作執行緒時在 io 執行緒上直接處理，回覆依序送出
+TEST_F(SessionTest, HeavyCommandRunsInlineWithoutWorkers) {
+    auto socket = connect();
+    std::vector<char> digest = FrameBuilder::build(DigestRequest{1, "x"});
+    set_request_id(digest.data(), 7);
+    asio::write(socket, asio::buffer(digest));
+
+    FrameHeader header;
+    std::string payload;
+    ASSERT_TRUE(read_frame(socket, header, payload));
+    EXPECT_EQ(header.command_id, CMD_DIGEST_RESPONSE);
+    EXPECT_EQ(header.request_id, 7);
+    EXPECT_EQ(services_->metrics->worker_inline.load(), 1u);
+    EXPECT_EQ(services_->metrics->worker_jobs.load(), 0u);
+}
+
+// 測試案例 6: 一次讀到超過上限的耗用 CPU 請求時，分派到上限就暫停，其餘的請求在工作完成後繼續分派
+TEST_F(SessionTest, ParksReadsAtPendingJobLimit) {
+    use_workers();
+    auto socket = connect();
+    constexpr int requests = 100;
+    std::vector<char> frames;
+    for (int i = 0; i < requests; ++i) {
+        const auto frame = FrameBuilder::build(DigestRequest{1, "x"});
+        frames.insert(frames.end(), frame.begin(), frame.end());
+    }
+    // 先佔住唯一的工作執行緒，請求都還不會完成
+    std::promise<void> release;
+    asio::post(workers_, [blocked = release.get_future().share()] { blocked.wait(); });
+    asio::write(socket, asio::buffer(frames));
+    io_context_.restart();
+    for (int i = 0; i < 100 && services_->metrics->worker_read_pauses.load() == 0; ++i) {
+        io_context_.run_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(services_->metrics->worker_read_pauses.load(), 1u);
+    EXPECT_EQ(services_->metrics->worker_jobs.load(), 64u); // 只分派到上限，其餘留在解析器中
+    release.set_value();
+
+    FrameHeader header;
+    std::string payload;
+    for (int i = 0; i < requests; ++i) {
+        ASSERT_TRUE(read_frame(socket, header, payload)) << "reply " << i;
+        DigestResponse response;
+        ASSERT_TRUE(codec::decode(header.command_id, payload, response));
+        EXPECT_EQ(response.status, DIGEST_OK);
+    }
+    EXPECT_GE(services_->metrics->worker_read_pauses.load(), 1u);
+    EXPECT_EQ(services_->metrics->worker_jobs.load(), static_cast<uint64_t>(requests));
+}
+
+#endif
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include "auth/TokenAuthenticator.hpp"
+
+namespace {
+
+std::vector<TokenAuthenticator::Key> test_keys() {
+    return {{"k2", "current-secret"}, {"k1", "previous-secret"}};
+}
+
+} // namespace
+
+// 測試案例 1: 簽發的 token 可以通過驗證，第二次驗證命中快取
+TEST(TokenAuthTest, IssuedTokenVerifiesAndIsCached) {
+    TokenAuthenticator auth(test_keys());
+    const std::string token = auth.issue("alice", std::chrono::minutes(5));
+
+    auto first = auth.authenticate(token);
+    ASSERT_EQ(first.status, AuthStatus::OK);
+    ASSERT_EQ(first.subject, "alice");
+    ASSERT_FALSE(first.cache_hit);
+
+    auto second = auth.authenticate(token);
+    ASSERT_EQ(second.status, AuthStatus::OK);
+    ASSERT_EQ(second.subject, "alice");
+    ASSERT_TRUE(second.cache_hit);
+}
+
+// 測試案例 2: 以舊金鑰簽發的 token 在輪替後仍然有效
+TEST(TokenAuthTest, AcceptsAnyKeyInKeyset) {
+    TokenAuthenticator old_auth(std::vector<TokenAuthenticator::Key>{{"k1", "previous-secret"}});
+    TokenAuthenticator auth(test_keys());
+    ASSERT_EQ(auth.authenticate(old_auth.issue("bob", std::chrono::minutes(5))).status, AuthStatus::OK);
+}
+
+// 測試案例 3: 竄改的內容、未知的金鑰、過期與格式錯誤都會被拒絕
+TEST(TokenAuthTest, RejectsInvalidTokens) {
+    TokenAuthenticator auth(test_keys());
+    std::string token = auth.issue("alice", std::chrono::minutes(5));
+
+    std::string forged = token;
+    forged.replace(forged.find("alice"), 5, "admin");
+    ASSERT_EQ(auth.authenticate(forged).status, AuthStatus::BAD_SIGNATURE);
+
+    TokenAuthenticator other(std::vector<TokenAuthenticator::Key>{{"k9", "other-secret"}});
+    ASSERT_EQ(auth.authenticate(other.issue("alice", std::chrono::minutes(5))).status, AuthStatus::UNKNOWN_KEY);
+
+    ASSERT_EQ(auth.authenticate(auth.issue("alice", std::chrono::seconds(-1))).status, AuthStatus::EXPIRED);
+
+    ASSERT_EQ(auth.authenticate("").status, AuthStatus::MALFORMED);
+    ASSERT_EQ(auth.authenticate("k2:alice:notanumber:00").status, AuthStatus::MALFORMED);
+    ASSERT_EQ(auth.authenticate("k2:alice:99999999999:zz").status, AuthStatus::BAD_SIGNATURE);
+}
+
+// 測試案例 4: 快取的每個分片在容量滿時淘汰最久未使用的項目
+TEST(TokenAuthTest, CacheEvictsLeastRecentlyUsed) {
+    TokenCache cache(2, 1); // 單一分片，容量 2
+    cache.insert("a", {"a", 100});
+    cache.insert("b", {"b", 100});
+    ASSERT_TRUE(cache.find("a", 0).has_value()); // a 變成最近使用
+    cache.insert("c", {"c", 100});               // 淘汰 b
+
+    ASSERT_TRUE(cache.find("a", 0).has_value());
+    ASSERT_FALSE(cache.find("b", 0).has_value());
+    ASSERT_TRUE(cache.find("c", 0).has_value());
+    ASSERT_EQ(cache.size(), 2u);
+}
+
+// 測試案例 5: 快取中已過期的項目不會被當作命中
+TEST(TokenAuthTest, CacheDropsExpiredEntries) {
+    TokenCache cache;
+    cache.insert("t", {"alice", 100});
+    ASSERT_TRUE(cache.find("t", 99).has_value());
+    ASSERT_FALSE(cache.find("t", 100).has_value());
+    ASSERT_EQ(cache.size(), 0u);
+}
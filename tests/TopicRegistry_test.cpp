@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include "server/TopicRegistry.hpp"
+
+namespace {
+
+// 記錄收到的訊框
+class RecordingSubscriber : public TopicSubscriber {
+public:
+    void deliver(std::shared_ptr<const std::vector<char>> frame, PriorityClass priority) override {
+        frames.push_back(std::move(frame));
+        priorities.push_back(priority);
+    }
+
+    std::vector<std::shared_ptr<const std::vector<char>>> frames;
+    std::vector<PriorityClass> priorities;
+};
+
+std::shared_ptr<const std::vector<char>> make_frame(const std::string& text) {
+    return std::make_shared<const std::vector<char>>(text.begin(), text.end());
+}
+
+} // namespace
+
+// 測試案例 1: 只有訂閱該主題的對象會收到訊息，而且收到的是同一份訊框 (不複製)
+TEST(TopicRegistryTest, PublishesOnlyToTopicSubscribers) {
+    TopicRegistry registry;
+    auto news = std::make_shared<RecordingSubscriber>();
+    auto sports = std::make_shared<RecordingSubscriber>();
+    registry.subscribe("news", news);
+    registry.subscribe("sports", sports);
+
+    auto frame = make_frame("hello");
+    ASSERT_EQ(registry.publish("news", frame, PriorityClass::BULK), 1u);
+
+    ASSERT_EQ(news->frames.size(), 1u);
+    ASSERT_EQ(news->frames[0], frame);
+    ASSERT_EQ(news->priorities[0], PriorityClass::BULK);
+    ASSERT_TRUE(sports->frames.empty());
+}
+
+// 測試案例 2: 發布者本身不會收到自己的訊息
+TEST(TopicRegistryTest, ExcludesPublisher) {
+    TopicRegistry registry;
+    auto a = std::make_shared<RecordingSubscriber>();
+    auto b = std::make_shared<RecordingSubscriber>();
+    registry.subscribe("t", a);
+    registry.subscribe("t", b);
+
+    ASSERT_EQ(registry.publish("t", make_frame("x"), PriorityClass::BULK, a.get()), 1u);
+    ASSERT_TRUE(a->frames.empty());
+    ASSERT_EQ(b->frames.size(), 1u);
+}
+
+// 測試案例 3: 第一個訂閱者出現與最後一個訂閱者離開時才通知 (重複訂閱不影響)
+TEST(TopicRegistryTest, NotifiesInterestChangesOnce) {
+    TopicRegistry registry;
+    std::vector<std::pair<std::string, bool>> changes;
+    registry.set_interest_callback([&](const std::string& topic, bool interested) {
+        changes.emplace_back(topic, interested);
+    });
+
+    auto a = std::make_shared<RecordingSubscriber>();
+    auto b = std::make_shared<RecordingSubscriber>();
+    registry.subscribe("t", a);
+    registry.subscribe("t", a);
+    registry.subscribe("t", b);
+    registry.unsubscribe(a.get(), {"t"});
+    ASSERT_EQ(changes.size(), 1u);
+
+    registry.unsubscribe(b.get(), {"t"});
+    ASSERT_EQ(changes.size(), 2u);
+    ASSERT_EQ(changes[0], std::make_pair(std::string("t"), true));
+    ASSERT_EQ(changes[1], std::make_pair(std::string("t"), false));
+    ASSERT_EQ(registry.topic_count(), 0u);
+}
+
+// 測試案例 4: 已經釋放的訂閱者會被略過
+TEST(TopicRegistryTest, SkipsExpiredSubscribers) {
+    TopicRegistry registry;
+    auto kept = std::make_shared<RecordingSubscriber>();
+    auto dropped = std::make_shared<RecordingSubscriber>();
+    registry.subscribe("t", kept);
+    registry.subscribe("t", dropped);
+    dropped.reset();
+
+    ASSERT_EQ(registry.publish("t", make_frame("x"), PriorityClass::BULK), 1u);
+}
+
+// 測試案例 5: 主題名稱取自 '\0' 之前的部分，沒有 '\0' 時為預設主題
+TEST(TopicRegistryTest, ParsesPublishTopic) {
+    const std::string with_topic("news\0body", 9);
+    ASSERT_EQ(publish_topic(with_topic.data(), with_topic.size()), "news");
+    const std::string without_topic = "plain message";
+    ASSERT_EQ(publish_topic(without_topic.data(), without_topic.size()), "");
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <thread>
+#include "storage/TraceFile.hpp"
+#include "frame/FrameHeader.hpp"
+
+namespace {
+
+// 每個測試使用獨立的暫存檔，結束時刪除
+class TraceFileTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path_ = (std::filesystem::temp_directory_path() /
+                 ("trace_file_test_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()))).string();
+        std::filesystem::remove(path_);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path_);
+    }
+
+    std::string path_;
+};
+
+// 測試案例 1: 錄製的紀錄可以原樣讀回，時間不會倒退
+TEST_F(TraceFileTest, RecordsRoundTrip) {
+    {
+        TraceRecorder recorder(path_);
+        const uint32_t id = recorder.next_connection_id();
+        recorder.record(id, TRACE_CONNECTION_OPEN, 0);
+        recorder.record(id, CMD_PUBLISH_MESSAGE, 70000);
+        recorder.record(id, TRACE_CONNECTION_CLOSE, 0);
+        ASSERT_EQ(recorder.recorded(), 3u);
+    }
+
+    const auto records = read_trace(path_);
+    ASSERT_EQ(records.size(), 3u);
+    ASSERT_EQ(records[0].command_id, TRACE_CONNECTION_OPEN);
+    ASSERT_EQ(records[1].command_id, CMD_PUBLISH_MESSAGE);
+    ASSERT_EQ(records[1].payload_size, 70000u);
+    ASSERT_EQ(records[2].command_id, TRACE_CONNECTION_CLOSE);
+    for (const auto& record : records) {
+        ASSERT_EQ(record.connection_id, records[0].connection_id);
+    }
+    ASSERT_LE(records[0].timestamp_ns, records[1].timestamp_ns);
+    ASSERT_LE(records[1].timestamp_ns, records[2].timestamp_ns);
+}
+
+// 測試案例 2: 多條執行緒同時錄製 (跨越多次整批寫檔)，檔案中的時間依序排列且沒有遺失
+TEST_F(TraceFileTest, ConcurrentRecordingKeepsOrder) {
+    constexpr int threads = 4;
+    constexpr int per_thread = 5000;
+    {
+        TraceRecorder recorder(path_, 1024);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&recorder] {
+                const uint32_t id = recorder.next_connection_id();
+                for (int i = 0; i < per_thread; ++i) {
+                    recorder.record(id, CMD_PUBLISH_MESSAGE, static_cast<uint32_t>(i));
+                }
+            });
+        }
+        for (auto& worker : workers) worker.join();
+    }
+
+    const auto records = read_trace(path_);
+    ASSERT_EQ(records.size(), static_cast<std::size_t>(threads * per_thread));
+    std::map<uint32_t, uint32_t> next_size;
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        if (i > 0) {
+            ASSERT_LE(records[i - 1].timestamp_ns, records[i].timestamp_ns);
+        }
+        // 同一條連線的紀錄維持呼叫順序
+        ASSERT_EQ(records[i].payload_size, next_size[records[i].connection_id]++);
+    }
+}
+
+// 測試案例 3: 檔尾不完整的紀錄被忽略；不是軌跡檔時拋出例外
+TEST_F(TraceFileTest, IgnoresTruncatedTailAndRejectsForeignFiles) {
+    {
+        TraceRecorder recorder(path_);
+        recorder.record(1, CMD_PUBLISH_MESSAGE, 10);
+        recorder.record(1, CMD_PUBLISH_MESSAGE, 20);
+    }
+    std::filesystem::resize_file(path_, std::filesystem::file_size(path_) - 5);
+    const auto records = read_trace(path_);
+    ASSERT_EQ(records.size(), 1u);
+    ASSERT_EQ(records[0].payload_size, 10u);
+
+    {
+        std::ofstream foreign(path_, std::ios::binary | std::ios::trunc);
+        foreign << "definitely not a trace file";
+    }
+    ASSERT_THROW(read_trace(path_), std::runtime_error);
+}
+
+} // namespace
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include "server/WriteScheduler.hpp"
+
+// 建立指定大小的封包，第一個位元組作為識別碼
+static std::vector<char> make_packet(std::size_t size, char tag) {
+    std::vector<char> packet(size, 0);
+    packet[0] = tag;
+    return packet;
+}
+
+// 測試案例 1: 控制訊框即使較晚排入，也要排在大量資料之前送出
+TEST(WriteSchedulerTest, ControlFramesBypassBulkData) {
+    WriteScheduler scheduler;
+    for (int i = 0; i < 10; ++i) {
+        scheduler.push(make_packet(4096, 'B'), PriorityClass::BULK);
+    }
+    scheduler.push(make_packet(16, 'H'), PriorityClass::CONTROL);
+
+    std::vector<OutPacket> batch;
+    scheduler.collect(batch, 16384);
+
+    ASSERT_FALSE(batch.empty());
+    ASSERT_EQ(batch.front().data[0], 'H');
+    ASSERT_EQ(batch.front().priority, PriorityClass::CONTROL);
+}
+
+// 測試案例 2: 多個小封包合併在同一批寫入中，且不超過位元組上限
+TEST(WriteSchedulerTest, CoalescesSmallPacketsUpToLimit) {
+    WriteScheduler scheduler;
+    for (int i = 0; i < 100; ++i) {
+        scheduler.push(make_packet(100, 'S'), PriorityClass::STANDARD);
+    }
+
+    std::vector<OutPacket> batch;
+    scheduler.collect(batch, 1000);
+
+    ASSERT_EQ(batch.size(), 10u);
+    ASSERT_FALSE(scheduler.empty());
+}
+
+// 測試案例 3: 單一封包大於上限時仍然要送出，避免卡住
+TEST(WriteSchedulerTest, OversizedPacketStillMakesProgress) {
+    WriteScheduler scheduler;
+    scheduler.push(make_packet(65536, 'B'), PriorityClass::BULK);
+
+    std::vector<OutPacket> batch;
+    scheduler.collect(batch, 16384);
+
+    ASSERT_EQ(batch.size(), 1u);
+    ASSERT_TRUE(scheduler.empty());
+}
+
+// 測試案例 4: STANDARD 與 BULK 依權重 (4:1) 分享頻寬
+TEST(WriteSchedulerTest, WeightedFairSharingBetweenClasses) {
+    WriteScheduler scheduler({1, 4, 1}, 1000);
+    for (int i = 0; i < 200; ++i) {
+        scheduler.push(make_packet(100, 'S'), PriorityClass::STANDARD);
+        scheduler.push(make_packet(100, 'B'), PriorityClass::BULK);
+    }
+
+    std::size_t standard_bytes = 0, bulk_bytes = 0;
+    for (int round = 0; round < 5; ++round) {
+        std::vector<OutPacket> batch;
+        scheduler.collect(batch, 5000);
+        for (const auto& packet : batch) {
+            (packet.priority == PriorityClass::STANDARD ? standard_bytes : bulk_bytes) += packet.data.size();
+        }
+    }
+
+    ASSERT_GT(bulk_bytes, 0u); // BULK 不會被餓死
+    ASSERT_EQ(standard_bytes, bulk_bytes * 4);
+}
+
+// 測試案例 5: 排隊時間回呼會收到每個被取出的封包
+TEST(WriteSchedulerTest, ReportsQueueingDelayPerPacket) {
+    WriteScheduler scheduler;
+    scheduler.push(make_packet(10, 'H'), PriorityClass::CONTROL);
+    scheduler.push(make_packet(10, 'B'), PriorityClass::BULK);
+
+    std::array<int, PRIORITY_CLASS_COUNT> reported{};
+    std::vector<OutPacket> batch;
+    scheduler.collect(batch, 16384, [&](PriorityClass cls, std::chrono::nanoseconds delay) {
+        ASSERT_GE(delay.count(), 0);
+        reported[static_cast<std::size_t>(cls)]++;
+    });
+
+    ASSERT_EQ(reported[0], 1);
+    ASSERT_EQ(reported[2], 1);
+}
+
+// 測試案例 6: 佇列持續有積壓 (從未清空) 時仍維持 FIFO 順序，清空後可歸還儲存空間
+TEST(WriteSchedulerTest, KeepsFifoOrderUnderSustainedBacklog) {
+    WriteScheduler scheduler;
+    int next_push = 0, next_pop = 0;
+    for (int round = 0; round < 200; ++round) {
+        for (int i = 0; i < 3; ++i) {
+            scheduler.push(make_packet(1, static_cast<char>(next_push++ % 128)), PriorityClass::STANDARD);
+        }
+        std::vector<OutPacket> batch;
+        scheduler.collect(batch, 2); // 每次最多取出 2 個，佇列持續增長
+        for (const auto& packet : batch) {
+            ASSERT_EQ(packet.data[0], static_cast<char>(next_pop++ % 128));
+        }
+    }
+    while (!scheduler.empty()) {
+        std::vector<OutPacket> batch;
+        scheduler.collect(batch, 16384);
+        for (const auto& packet : batch) {
+            ASSERT_EQ(packet.data[0], static_cast<char>(next_pop++ % 128));
+        }
+    }
+    ASSERT_EQ(next_pop, next_push);
+    scheduler.release_memory();
+    ASSERT_TRUE(scheduler.empty());
+}